@@ -23,37 +23,178 @@
 #ifndef ALGO_H_
 #define ALGO_H_
 
+#include <stdlib.h>
+#include <time.h>
+
 #include <cstddef>
+#include <atomic>
+#include <functional>
+
+#include "sort_stats.h"
+#include "arena.h"
 
 namespace hedger {
 
 typedef int S_T;
 
+// SortSeed
+// Seed for one sort's random sequence, from a per-thread generator: no
+// libc rand() lock in the timed path, and the harness's rand() stream does
+// not depend on which engines ran.
+inline unsigned int SortSeed()
+{
+  static std::atomic<unsigned int> thread_seq(0);
+  static thread_local unsigned int state = (unsigned int) time(nullptr) ^
+    thread_seq.fetch_add(0x9e3779b9u, std::memory_order_relaxed);
+  state = state * 1664525u + 1013904223u;
+  return state;
+}
+
+// SortContext
+// Per-call state of a sort.  It lives on the calling thread's stack, so a
+// single Algo instance can run any number of sorts at once.  Stats is the
+// instrumentation policy (NoStats or CountStats).
+template <class Stats, class T = hedger::S_T, class Compare = std::less<T> >
+struct SortContext {
+  SortContext(T *array, const Compare& compare = Compare()) : less(compare) {
+    arr = array;
+    seeded = false;
+  }
+  // Compare through the instrumentation policy
+  inline bool Less(const T& a, const T& b) { return stats.Less(a, b, less); }
+  // The same, as a comparator to hand to a sorting network
+  inline StatsLess<Stats, Compare> CountedLess() {
+    return StatsLess<Stats, Compare>(stats, less);
+  }
+  // Next random number for randomizing engines; the sequence is seeded on
+  // first use, so other engines never pay for it.
+  inline unsigned int Random() {
+    if (!seeded) {
+      seed = SortSeed();
+      seeded = true;
+    }
+    return (unsigned int) rand_r(&seed);
+  }
+  T *arr;
+  unsigned int seed;        // rand_r() state
+  bool seeded;
+  Stats stats;
+  Compare less;
+};
+
 // Algo is an ancestor class for any algorithm, and is to be used
 // for maintaining relevant statistics on the algorithm (run time, mean, std deviation, etc)
-class Algo
+// Test() must be reentrant: per-call state belongs in a SortContext, never
+// in members or statics.  Engines that CanInstrument() build their hot path
+// twice, with NoStats for timing and CountStats for SetInstrumented(true)
+// runs, whose counts are folded into the instance when a call finishes.
+// Temporary memory comes from the arena set with SetArena(), sized by the
+// caller from GetScratchSize(); an engine holding an arena must not be
+// called from two threads at once.
+// Comparison engines are templates on the element type and its strict
+// weak ordering, explicitly instantiated for the types in sort_types.h;
+// the comparator is a template argument, so it inlines into the hot path.
+// Algo is the int instantiation the rest of the bench is written against.
+template <class T, class Compare = std::less<T> >
+class BasicAlgo
 {
  public:
-  Algo() { max_recurse_depth_ = 0; max_recurse_depth_hwm_ = 0; }
-  virtual ~Algo() {};
-  virtual int Test(hedger::S_T *t, size_t size, hedger::S_T range = 0) = 0;
+  typedef T Element;
+  BasicAlgo(const Compare& less = Compare()) : less_(less) {
+    ResetStats();
+    instrumented_ = false;
+    small_sort_max_ = 0;
+    arena_ = nullptr;
+  }
+  virtual ~BasicAlgo() {};
+  virtual int Test(T *t, size_t size, hedger::S_T range = 0) = 0;
+  // One call counted whatever SetInstrumented() says, its counts added to
+  // the caller's stats rather than the instance's, so a composite engine
+  // can count a shared sub-engine without changing its settings.  Engines
+  // that do not override it sort uncounted.
+  virtual int TestCounted(T *t, size_t size, hedger::S_T range,
+    SortStats& stats) {
+    return Test(t, size, range);
+  }
   virtual const char *GetName() = 0;
-  int GetMaxRecurseDepth() { return max_recurse_depth_hwm_; }
-  void ResetMaxRecurseDepth() {
-    max_recurse_depth_hwm_ = max_recurse_depth_ = 0;
+  // Instrumentation
+  virtual bool CanInstrument() { return false; }
+  void SetInstrumented(bool instrumented) { instrumented_ = instrumented; }
+  bool GetInstrumented() { return instrumented_; }
+  const SortStats& GetStats() { return stats_; }
+  int GetMaxRecurseDepth() { return stats_.depth_max; }
+  void ResetStats() {
+    stats_.compare_tot = stats_.move_tot = 0;
+    stats_.swap_tot = stats_.alloc_tot = 0;
+    stats_.depth_max = 0;
+    stats_.pass_tot = -1;
+    stats_.detail = nullptr;
   }
+  // Scratch memory (nullptr == heap)
+  virtual void SetArena(Arena *arena) { arena_ = arena; }
+  Arena *GetArena() { return arena_; }
+  // Arena bytes one call on size keys spanning at most size values needs
+  virtual size_t GetScratchSize(size_t size) { return 0; }
+  // Bytes one call on size keys moves between memory and the last-level
+  // cache, by the engine's traffic model (roofline.h); 0 == not declared,
+  // or the sort runs from cache
+  virtual double GetMemoryBytes(size_t size) { return 0.0; }
+  // As above, refined by what the instrumented call on size keys counted
+  // (GetStats()); engines whose traffic depends on the data override it
+  virtual double GetMemoryBytes(size_t size, const SortStats& stats) {
+    return GetMemoryBytes(size);
+  }
+  // Subarrays this small are finished by a sorting network (0 == never)
+  void SetSmallSortMax(size_t small_sort_max) {
+    small_sort_max_ = small_sort_max;
+  }
+  size_t GetSmallSortMax() { return small_sort_max_; }
+  // Threads a parallel engine may use (serial engines ignore this)
+  virtual void SetThreadMax(int thread_max) {}
+  virtual int GetThreadMax() { return 1; }
 
  protected:
-  virtual void IncMaxRecurseDepth() {
-    ++max_recurse_depth_;
-    if (max_recurse_depth_hwm_ < max_recurse_depth_)
-      max_recurse_depth_hwm_ = max_recurse_depth_;
-  }
-  virtual void DecMaxRecurseDepth() { --max_recurse_depth_; }
-  volatile int max_recurse_depth_;
-  volatile int max_recurse_depth_hwm_;
-  hedger::S_T *arr_;
+  // Fold a finished call's statistics into the instance, or into the
+  // caller's stats of a TestCounted() call (sink), which no other thread
+  // touches.
+  void Finish(const NoStats& stats, SortStats *sink = nullptr) {}
+  void Finish(const SortStats& stats, SortStats *sink = nullptr) {
+    if (sink) {
+      sink->compare_tot += stats.compare_tot;
+      sink->move_tot += stats.move_tot;
+      sink->swap_tot += stats.swap_tot;
+      sink->alloc_tot += stats.alloc_tot;
+      if (sink->depth_max < stats.depth_max)
+        sink->depth_max = stats.depth_max;
+      if (sink->pass_tot < stats.pass_tot)
+        sink->pass_tot = stats.pass_tot;
+      if (stats.detail)
+        sink->detail = stats.detail;
+      return;
+    }
+    __sync_fetch_and_add(&stats_.compare_tot, stats.compare_tot);
+    __sync_fetch_and_add(&stats_.move_tot, stats.move_tot);
+    __sync_fetch_and_add(&stats_.swap_tot, stats.swap_tot);
+    __sync_fetch_and_add(&stats_.alloc_tot, stats.alloc_tot);
+    int depth_max;
+    while ((depth_max = stats_.depth_max) < stats.depth_max &&
+      !__sync_bool_compare_and_swap(&stats_.depth_max, depth_max,
+        stats.depth_max));
+    int pass_tot;
+    while ((pass_tot = stats_.pass_tot) < stats.pass_tot &&
+      !__sync_bool_compare_and_swap(&stats_.pass_tot, pass_tot,
+        stats.pass_tot));
+    if (stats.detail)
+      __atomic_store_n(&stats_.detail, stats.detail, __ATOMIC_RELAXED);
+  }
+  SortStats stats_;
+  bool instrumented_;
+  size_t small_sort_max_;
+  Arena *arena_;
+  Compare less_;
 };
+
+typedef BasicAlgo<hedger::S_T> Algo;
 }
 
 #endif // ALGO_H_
@@ -0,0 +1,152 @@
+// arena.cc
+//
+// Scratch memory arena shared by the sorting engines.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdlib.h>
+#include <memory.h>
+
+#include <cstddef>
+
+#include "arena.h"
+
+namespace hedger {
+
+// Constructor
+Arena::Arena() {
+  base_ = nullptr;
+  capacity_ = used_ = high_water_ = 0;
+  owned_ = true;
+  split_mark_ = 0;
+}
+
+// Destructor
+Arena::~Arena() {
+  FreeParts();
+  if (owned_)
+    free(base_);
+}
+
+// Reserve
+// Make sure the arena holds at least this many bytes.  Growing discards
+// anything allocated, so size the arena before a benchmark, not during.
+// The block is touched here so that page faults are not charged to the
+// first sort that uses it.
+// Entry: bytes
+// Exit:  true == success
+bool Arena::Reserve(size_t bytes)
+{
+  if (!owned_)
+    return bytes <= capacity_;
+  bytes = Round(bytes);
+  if (bytes > capacity_) {
+    FreeParts();
+    free(base_);
+    base_ = nullptr;
+    capacity_ = used_ = 0;
+    if (posix_memalign((void **) &base_, kArenaAlign, bytes)) {
+      // TODO: LOG ERROR
+      base_ = nullptr;
+      return false;
+    }
+    memset(base_, 0, bytes);
+    capacity_ = bytes;
+  }
+  return true;
+}
+
+// Alloc
+// Entry: bytes
+// Exit:  kArenaAlign-aligned pointer, or nullptr if the arena is full
+void *Arena::Alloc(size_t bytes)
+{
+  bytes = Round(bytes);
+  if (nullptr == base_ || bytes > capacity_ - used_)
+    return nullptr;
+  void *p = base_ + used_;
+  used_ += bytes;
+  if (used_ > high_water_)
+    high_water_ = used_;
+  return p;
+}
+
+// Split
+// Carve the free space into part_tot equal sub-arenas.  The parts are
+// kept until the next Split() with a different count or mark.
+// Entry: number of parts
+// Exit:  true == success
+bool Arena::Split(int part_tot)
+{
+  if (part_tot < 1)
+    return false;
+  if ((size_t) part_tot == part_arr_.size() && split_mark_ == used_)
+    return true;
+  FreeParts();
+  size_t part_size = (capacity_ - used_) / part_tot & ~(kArenaAlign - 1);
+  for (int i = 0; i < part_tot; ++i) {
+    Arena *part = new Arena();
+    part->base_ = base_ ? base_ + used_ + i * part_size : nullptr;
+    part->capacity_ = base_ ? part_size : 0;
+    part->owned_ = false;
+    part_arr_.push_back(part);
+  }
+  split_mark_ = used_;
+  return true;
+}
+
+// FreeParts
+// Drop the sub-arenas carved by Split().
+void Arena::FreeParts()
+{
+  for (auto part : part_arr_)
+    delete part;
+  part_arr_.clear();
+}
+
+// Scratch constructor
+// Entry: arena to draw from (nullptr == heap only)
+Scratch::Scratch(Arena *arena) {
+  arena_ = arena;
+  mark_ = arena ? arena->Mark() : 0;
+}
+
+// Scratch destructor
+// Roll the arena back and free any heap fallbacks.
+Scratch::~Scratch() {
+  if (arena_)
+    arena_->Release(mark_);
+  for (auto p : heap_arr_)
+    free(p);
+}
+
+// Alloc
+// Entry: bytes
+// Exit:  pointer, or nullptr if both the arena and the heap are out
+void *Scratch::Alloc(size_t bytes)
+{
+  void *p = arena_ ? arena_->Alloc(bytes) : nullptr;
+  if (nullptr == p) {
+    p = malloc(bytes);
+    if (p)
+      heap_arr_.push_back(p);
+  }
+  return p;
+}
+} // namespace hedger
@@ -0,0 +1,87 @@
+// arena.h
+//
+// Scratch memory arena shared by the sorting engines.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace hedger
+{
+// Alignment of every arena allocation (one cache line)
+const size_t kArenaAlign = 64;
+
+// Arena
+// Bump allocator over one block reserved up front, so engines can take
+// their temporary memory without calling the heap inside a timed sort.
+// Allocations are popped by rolling back to a Mark().  Split() carves the
+// free space into equal sub-arenas, one per worker thread; an arena and
+// its parts must not be allocated from by two threads at once.
+class Arena
+{
+ public:
+  Arena();
+  ~Arena();
+  bool Reserve(size_t bytes);
+  void *Alloc(size_t bytes);
+  size_t Mark() { return used_; }
+  void Release(size_t mark) { used_ = mark; }
+  bool Split(int part_tot);
+  Arena *GetPart(int index) { return part_arr_[index]; }
+  size_t GetCapacity() { return capacity_; }
+  size_t GetHighWater() { return high_water_; }
+  // Where the next allocation starts, less its padding, and the room left
+  void *GetFree() { return base_ + used_; }
+  size_t GetFreeBytes() { return capacity_ - used_; }
+  // Bytes an allocation of this size consumes, padding included
+  static size_t Round(size_t bytes) {
+    return (bytes + kArenaAlign - 1) & ~(kArenaAlign - 1);
+  }
+ private:
+  void FreeParts();
+  char *base_;
+  size_t capacity_;
+  size_t used_;
+  size_t high_water_;
+  bool owned_;                  // false for a part of another arena
+  std::vector<Arena *> part_arr_;
+  size_t split_mark_;           // used_ when the parts were carved
+};
+
+// Scratch
+// One call's temporary memory: taken from an arena when there is one and
+// it has room, from the heap otherwise, and all given back on destruction.
+class Scratch
+{
+ public:
+  Scratch(Arena *arena);
+  ~Scratch();
+  void *Alloc(size_t bytes);
+ private:
+  Arena *arena_;
+  size_t mark_;
+  std::vector<void *> heap_arr_;
+};
+}
+
+#endif // ARENA_H_
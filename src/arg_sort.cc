@@ -0,0 +1,419 @@
+// arg_sort.cc
+//
+// Argsort: sort permutations over a key column, and the gather that
+// applies one to payload columns.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdint.h>
+#include <memory.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "arg_sort.h"
+
+namespace hedger {
+
+// Buckets per radix pass (one byte)
+const int kArgRadix = 256;
+// Runs this long are started by insertion sort
+const size_t kArgInsertionMax = 16;
+// Rows per gather block: 2048 indices fit in L1 at either width
+const size_t kGatherBlock = 2048;
+// Rows ahead of the gather cursor to prefetch
+const size_t kGatherPrefetch = 16;
+// Rows each gather thread gets at least
+const size_t kGatherParallelMin = 1 << 16;
+
+// ArgPair
+// A transformed key and the row it came from
+template <class Key, class Index> struct ArgPair {
+  Key key;
+  Index index;
+};
+
+// LoadPairs
+// Entry: key column
+//        size in elements
+//        pair array to fill
+template <class T, class Index> static void LoadPairs(
+  const T *keys,
+  size_t size,
+  ArgPair<typename KeyTraits<T>::Key, Index> *pair_arr)
+{
+  for (size_t i = 0; i < size; ++i) {
+    pair_arr[i].key = KeyTraits<T>::ToKey(keys[i]);
+    pair_arr[i].index = (Index) i;
+  }
+}
+
+// StorePerm
+// Entry: sorted pair array
+//        size in elements
+//        permutation to fill
+template <class Key, class Index> static void StorePerm(
+  const ArgPair<Key, Index> *pair_arr,
+  size_t size,
+  Index *perm)
+{
+  for (size_t i = 0; i < size; ++i)
+    perm[i] = pair_arr[i].index;
+}
+
+// ArgSortScratchSize
+// Exit: arena bytes the hungriest argsort (radix) takes for size keys
+template <class T, class Index> size_t ArgSortScratchSize(size_t size)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  return 2 * Arena::Round(size * sizeof(ArgPair<Key, Index>)) +
+    Arena::Round(sizeof(Key) * kArgRadix * sizeof(size_t));
+}
+
+// ArgRadixSort
+// Entry: key column
+//        size in elements
+//        permutation to fill
+//        arena for scratch (nullptr == heap)
+// Exit:  0 == success
+template <class T, class Index> int ArgRadixSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  typedef ArgPair<Key, Index> Pair;
+  const int digit_tot = sizeof(Key);
+  if (nullptr == keys || nullptr == perm)
+    return -1;
+  if (size < 2) {
+    if (size)
+      perm[0] = 0;
+    return 0;
+  }
+
+  Scratch scratch(arena);
+  Pair *src = (Pair *) scratch.Alloc(size * sizeof(Pair));
+  Pair *dst = (Pair *) scratch.Alloc(size * sizeof(Pair));
+  size_t *count_arr =
+    (size_t *) scratch.Alloc(digit_tot * kArgRadix * sizeof(size_t));
+  if (nullptr == src || nullptr == dst || nullptr == count_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+
+  // Transform, counting every digit on the way through.
+  LoadPairs(keys, size, src);
+  memset(count_arr, 0, digit_tot * kArgRadix * sizeof(size_t));
+  for (size_t i = 0; i < size; ++i) {
+    Key key = src[i].key;
+    for (int d = 0; d < digit_tot; ++d)
+      ++count_arr[d * kArgRadix + ((key >> (d * 8)) & 0xff)];
+  }
+
+  for (int d = 0; d < digit_tot; ++d) {
+    size_t *count = &count_arr[d * kArgRadix];
+    int shift = d * 8;
+    // Every key has the same digit here: the pass would change nothing.
+    if (size == count[(src[0].key >> shift) & 0xff])
+      continue;
+    // Counts become starting offsets.
+    size_t offset = 0;
+    for (int b = 0; b < kArgRadix; ++b) {
+      size_t bucket_tot = count[b];
+      count[b] = offset;
+      offset += bucket_tot;
+    }
+    for (size_t i = 0; i < size; ++i)
+      dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+    Pair *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  StorePerm(src, size, perm);
+  return 0;
+}
+
+// ArgMergeSort
+// Entry: key column
+//        size in elements
+//        permutation to fill
+//        arena for scratch (nullptr == heap)
+// Exit:  0 == success
+template <class T, class Index> int ArgMergeSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  typedef ArgPair<Key, Index> Pair;
+  if (nullptr == keys || nullptr == perm)
+    return -1;
+
+  Scratch scratch(arena);
+  Pair *src = (Pair *) scratch.Alloc(size * sizeof(Pair));
+  Pair *dst = (Pair *) scratch.Alloc(size * sizeof(Pair));
+  if (nullptr == src || nullptr == dst) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  LoadPairs(keys, size, src);
+
+  // Insertion sort each run; strict < keeps equal keys in row order
+  for (size_t start = 0; start < size; start += kArgInsertionMax) {
+    size_t end = std::min(start + kArgInsertionMax, size);
+    for (size_t i = start + 1; i < end; ++i) {
+      Pair pair = src[i];
+      size_t j = i;
+      while (j > start && pair.key < src[j - 1].key) {
+        src[j] = src[j - 1];
+        --j;
+      }
+      src[j] = pair;
+    }
+  }
+
+  // Merge runs pairwise, doubling the width, ping-ponging the buffers.
+  // Ties take the left run first, so the sort stays stable.
+  for (size_t width = kArgInsertionMax; width < size; width *= 2) {
+    for (size_t start = 0; start < size; start += 2 * width) {
+      size_t mid = std::min(start + width, size);
+      size_t end = std::min(start + 2 * width, size);
+      size_t left = start, right = mid, out = start;
+      while (left < mid && right < end) {
+        if (src[right].key < src[left].key)
+          dst[out++] = src[right++];
+        else
+          dst[out++] = src[left++];
+      }
+      while (left < mid)
+        dst[out++] = src[left++];
+      while (right < end)
+        dst[out++] = src[right++];
+    }
+    Pair *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  StorePerm(src, size, perm);
+  return 0;
+}
+
+// ArgQuickSortRecurse
+// Entry: pair array
+//        size in elements
+template <class Pair> static void ArgQuickSortRecurse(Pair *arr, size_t size)
+{
+  while (size > kArgInsertionMax) {
+    // Median of three to the front
+    size_t mid = size / 2;
+    if (arr[mid].key < arr[0].key)
+      std::swap(arr[mid], arr[0]);
+    if (arr[size - 1].key < arr[0].key)
+      std::swap(arr[size - 1], arr[0]);
+    if (arr[size - 1].key < arr[mid].key)
+      std::swap(arr[size - 1], arr[mid]);
+    std::swap(arr[0], arr[mid]);
+    auto pivot = arr[0].key;
+
+    // Hoare partition
+    size_t i = 0, j = size;
+    for (;;) {
+      do { ++i; } while (i < size && arr[i].key < pivot);
+      do { --j; } while (pivot < arr[j].key);
+      if (i >= j)
+        break;
+      std::swap(arr[i], arr[j]);
+    }
+    std::swap(arr[0], arr[j]);
+
+    // Recurse into the smaller side, loop on the larger
+    if (j < size - j - 1) {
+      ArgQuickSortRecurse(arr, j);
+      arr += j + 1;
+      size -= j + 1;
+    } else {
+      ArgQuickSortRecurse(arr + j + 1, size - j - 1);
+      size = j;
+    }
+  }
+  for (size_t i = 1; i < size; ++i) {
+    Pair pair = arr[i];
+    size_t j = i;
+    while (j && pair.key < arr[j - 1].key) {
+      arr[j] = arr[j - 1];
+      --j;
+    }
+    arr[j] = pair;
+  }
+}
+
+// ArgQuickSort
+// Entry: key column
+//        size in elements
+//        permutation to fill
+//        arena for scratch (nullptr == heap)
+// Exit:  0 == success
+template <class T, class Index> int ArgQuickSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  typedef ArgPair<Key, Index> Pair;
+  if (nullptr == keys || nullptr == perm)
+    return -1;
+
+  Scratch scratch(arena);
+  Pair *pair_arr = (Pair *) scratch.Alloc(size * sizeof(Pair));
+  if (nullptr == pair_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  LoadPairs(keys, size, pair_arr);
+  ArgQuickSortRecurse(pair_arr, size);
+  StorePerm(pair_arr, size, perm);
+  return 0;
+}
+
+// GatherParams
+// Parameter structure for gather threads: one range of rows
+template <class Index> struct GatherParams {
+  const Index *perm;
+  size_t start;
+  size_t end;
+  const int64_t * const *src_cols;
+  int64_t **dst_cols;
+  int col_tot;
+};
+
+// GatherRange
+// Thread body: gather rows [start, end) of every column, block by block
+// Entry: pointer to GatherParams
+template <class Index> static void *GatherRange(void *param)
+{
+  GatherParams<Index> *params = (GatherParams<Index> *) param;
+  const Index *perm = params->perm;
+  for (size_t block = params->start; block < params->end;
+       block += kGatherBlock) {
+    size_t block_end = std::min(block + kGatherBlock, params->end);
+    for (int c = 0; c < params->col_tot; ++c) {
+      const int64_t *src = params->src_cols[c];
+      int64_t *dst = params->dst_cols[c];
+      size_t i = block;
+      for (; i + kGatherPrefetch < block_end; ++i) {
+        __builtin_prefetch(&src[perm[i + kGatherPrefetch]]);
+        dst[i] = src[perm[i]];
+      }
+      for (; i < block_end; ++i)
+        dst[i] = src[perm[i]];
+    }
+  }
+  return nullptr;
+}
+
+// ParallelGather
+// Entry: permutation
+//        rows
+//        source columns
+//        destination columns (must not alias the sources)
+//        column count
+//        most threads to use
+// Exit:  0 == success
+template <class Index> int ParallelGather(
+  const Index *perm,
+  size_t size,
+  const int64_t * const *src_cols,
+  int64_t **dst_cols,
+  int col_tot,
+  int thread_max)
+{
+  if (nullptr == perm || nullptr == src_cols || nullptr == dst_cols)
+    return -1;
+  size_t thread_tot = std::min((size_t) std::max(thread_max, 1),
+    std::max(size / kGatherParallelMin, (size_t) 1));
+
+  // Thread ranges start on block boundaries
+  std::vector<GatherParams<Index> > params_arr(thread_tot);
+  size_t block_tot = (size + kGatherBlock - 1) / kGatherBlock;
+  for (size_t t = 0; t < thread_tot; ++t) {
+    GatherParams<Index>& params = params_arr[t];
+    params.perm = perm;
+    params.start = std::min(block_tot * t / thread_tot * kGatherBlock, size);
+    params.end =
+      std::min(block_tot * (t + 1) / thread_tot * kGatherBlock, size);
+    params.src_cols = src_cols;
+    params.dst_cols = dst_cols;
+    params.col_tot = col_tot;
+  }
+
+  // The last range runs on this thread
+  std::vector<pthread_t> thread_arr(thread_tot);
+  std::vector<bool> started_arr(thread_tot, false);
+  for (size_t t = 0; t + 1 < thread_tot; ++t) {
+    started_arr[t] = !pthread_create(&thread_arr[t], nullptr,
+      GatherRange<Index>, &params_arr[t]);
+    if (!started_arr[t]) {
+      // TODO: LOG ERROR
+      GatherRange<Index>(&params_arr[t]);
+    }
+  }
+  GatherRange<Index>(&params_arr[thread_tot - 1]);
+  for (size_t t = 0; t + 1 < thread_tot; ++t) {
+    if (started_arr[t])
+      pthread_join(thread_arr[t], nullptr);
+  }
+  return 0;
+}
+
+// Explicit instantiations
+#define ARG_SORT_INSTANTIATE(T, Index)                                  \
+  template int ArgRadixSort<T, Index>(                                  \
+    const T *keys, size_t size, Index *perm, Arena *arena);             \
+  template int ArgMergeSort<T, Index>(                                  \
+    const T *keys, size_t size, Index *perm, Arena *arena);             \
+  template int ArgQuickSort<T, Index>(                                  \
+    const T *keys, size_t size, Index *perm, Arena *arena);             \
+  template size_t ArgSortScratchSize<T, Index>(size_t size);
+#define ARG_SORT_INSTANTIATE_INDEXES(T)                                 \
+  ARG_SORT_INSTANTIATE(T, uint32_t)                                     \
+  ARG_SORT_INSTANTIATE(T, uint64_t)
+ARG_SORT_INSTANTIATE_INDEXES(int32_t)
+ARG_SORT_INSTANTIATE_INDEXES(uint32_t)
+ARG_SORT_INSTANTIATE_INDEXES(int64_t)
+ARG_SORT_INSTANTIATE_INDEXES(uint64_t)
+ARG_SORT_INSTANTIATE_INDEXES(float)
+ARG_SORT_INSTANTIATE_INDEXES(double)
+#undef ARG_SORT_INSTANTIATE_INDEXES
+#undef ARG_SORT_INSTANTIATE
+
+template int ParallelGather<uint32_t>(const uint32_t *perm, size_t size,
+  const int64_t * const *src_cols, int64_t **dst_cols, int col_tot,
+  int thread_max);
+template int ParallelGather<uint64_t>(const uint64_t *perm, size_t size,
+  const int64_t * const *src_cols, int64_t **dst_cols, int col_tot,
+  int thread_max);
+} // namespace hedger
@@ -0,0 +1,89 @@
+// arg_sort.h
+//
+// Argsort: sort permutations over a key column, and the gather that
+// applies one to payload columns.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef ARG_SORT_H_
+#define ARG_SORT_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "arena.h"
+#include "key_transform.h"
+
+namespace hedger
+{
+// Instantiated for keys of int32_t, uint32_t, int64_t, uint64_t, float and
+// double, with uint32_t or uint64_t permutations.  Each fills perm so that
+// keys[perm[0]], keys[perm[1]] .. is in order; the key column is left
+// alone.  Keys are compared as KeyTraits<T> keys, and every engine works
+// on (key, index) pairs copied into scratch, so the sort never chases an
+// index back into the column.
+
+// ArgRadixSort
+// Stable: LSD radix sort, one byte per pass, moving keys and indices
+// together; passes whose byte every key shares are skipped.
+template <class T, class Index> int ArgRadixSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena
+);
+
+// ArgMergeSort
+// Stable: bottom-up merge sort of the pairs, runs started by insertion sort.
+template <class T, class Index> int ArgMergeSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena
+);
+
+// ArgQuickSort
+// Not stable: quicksort of the pairs, median-of-three pivot.
+template <class T, class Index> int ArgQuickSort(
+  const T *keys,
+  size_t size,
+  Index *perm,
+  Arena *arena
+);
+
+// Arena bytes the largest of the above takes for size keys
+template <class T, class Index> size_t ArgSortScratchSize(size_t size);
+
+// ParallelGather
+// dst_cols[c][i] = src_cols[c][perm[i]] for every column.  Rows are split
+// over up to thread_max threads; each walks its rows in blocks small
+// enough that the block's indices stay in L1 while every column is
+// gathered through them.
+template <class Index> int ParallelGather(
+  const Index *perm,
+  size_t size,
+  const int64_t * const *src_cols,
+  int64_t **dst_cols,
+  int col_tot,
+  int thread_max
+);
+}
+
+#endif // ARG_SORT_H_
@@ -0,0 +1,303 @@
+// auto_sort.cc
+//
+// Adaptive sort that samples its input and dispatches to the engine best
+// suited to it.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cstddef>
+#include <algorithm>
+
+#include "auto_sort.h"
+#include "counting_sort.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "merge_sort_multicore.h"
+#include "quick_sort.h"
+#include "radix_sort.h"
+
+namespace hedger {
+
+// Upper bound on the number of keys examined when sampling.  Inversion
+// counting is quadratic in this.
+const size_t kSampleMax = 128;
+
+//
+// AutoSortProfile
+//
+
+// Constructor
+// Uncalibrated defaults.
+AutoSortProfile::AutoSortProfile() {
+  insertion_max = 32;
+  presorted_insertion_max = 4096;
+  presorted_descent_max = 0.01;
+  presorted_inversion_max = 0.05;
+  counting_range_factor = 4.0;
+  radix_min = 256;
+  multicore_min = 0;
+  duplicate_max = 0.25;
+  run_length_min = 256;
+}
+
+// Load
+// Read thresholds from a profile written by Save().  Unknown keys are
+// ignored and missing ones keep their current values.
+// Entry: path to profile
+// Exit:  true == success
+bool AutoSortProfile::Load(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (nullptr == file) {
+    printf("%s: unable to open %s\n", __FUNCTION__, path);
+    return false;
+  }
+  char line[256];
+  char key[64];
+  double value;
+  while (fgets(line, sizeof(line), file)) {
+    if ('#' == line[0] || 2 != sscanf(line, "%63s %lf", key, &value))
+      continue;
+    if (!strcmp(key, "insertion_max"))
+      insertion_max = (size_t) value;
+    else if (!strcmp(key, "presorted_insertion_max"))
+      presorted_insertion_max = (size_t) value;
+    else if (!strcmp(key, "presorted_descent_max"))
+      presorted_descent_max = value;
+    else if (!strcmp(key, "presorted_inversion_max"))
+      presorted_inversion_max = value;
+    else if (!strcmp(key, "counting_range_factor"))
+      counting_range_factor = value;
+    else if (!strcmp(key, "radix_min"))
+      radix_min = (size_t) value;
+    else if (!strcmp(key, "multicore_min"))
+      multicore_min = (size_t) value;
+    else if (!strcmp(key, "duplicate_max"))
+      duplicate_max = value;
+    else if (!strcmp(key, "run_length_min"))
+      run_length_min = (size_t) value;
+  }
+  fclose(file);
+  return true;
+}
+
+// Save
+// Write thresholds as "key value" lines.
+// Entry: path to profile
+// Exit:  true == success
+bool AutoSortProfile::Save(const char *path) const
+{
+  FILE *file = fopen(path, "w");
+  if (nullptr == file) {
+    printf("%s: unable to open %s\n", __FUNCTION__, path);
+    return false;
+  }
+  fprintf(file, "# sortbench AutoSort calibration profile\n");
+  fprintf(file, "insertion_max %zu\n", insertion_max);
+  fprintf(file, "presorted_insertion_max %zu\n", presorted_insertion_max);
+  fprintf(file, "presorted_descent_max %g\n", presorted_descent_max);
+  fprintf(file, "presorted_inversion_max %g\n", presorted_inversion_max);
+  fprintf(file, "counting_range_factor %g\n", counting_range_factor);
+  fprintf(file, "radix_min %zu\n", radix_min);
+  fprintf(file, "multicore_min %zu\n", multicore_min);
+  fprintf(file, "duplicate_max %g\n", duplicate_max);
+  fprintf(file, "run_length_min %zu\n", run_length_min);
+  fclose(file);
+  return true;
+}
+
+//
+// AutoSort
+//
+
+// Constructor
+AutoSort::AutoSort() {
+  insertion_sort_ = new InsertionSort();
+  counting_sort_ = new CountingSort();
+  radix_sort_ = new RadixSort();
+  quick_sort_ = new QuickSort();
+  merge_sort_ = new MergeSort();
+  merge_sort_multicore_ = new MergeSortMultiCore();
+}
+
+// Destructor
+AutoSort::~AutoSort() {
+  delete insertion_sort_;
+  delete counting_sort_;
+  delete radix_sort_;
+  delete quick_sort_;
+  delete merge_sort_;
+  delete merge_sort_multicore_;
+}
+
+// SetArena
+// Engines run one at a time, so they share the arena.
+// Entry: arena (nullptr == heap)
+void AutoSort::SetArena(Arena *arena)
+{
+  Algo *engine_arr[] = { insertion_sort_, counting_sort_, radix_sort_,
+    quick_sort_, merge_sort_, merge_sort_multicore_ };
+  arena_ = arena;
+  for (auto engine : engine_arr)
+    engine->SetArena(arena);
+}
+
+// GetScratchSize
+// Exit: the most any engine might need
+size_t AutoSort::GetScratchSize(size_t size)
+{
+  Algo *engine_arr[] = { insertion_sort_, counting_sort_, radix_sort_,
+    quick_sort_, merge_sort_, merge_sort_multicore_ };
+  size_t scratch_size = 0;
+  for (auto engine : engine_arr) {
+    if (scratch_size < engine->GetScratchSize(size))
+      scratch_size = engine->GetScratchSize(size);
+  }
+  return scratch_size;
+}
+
+// Test
+// Implementation of Algo's pure virtual Test()
+// Entry: pointer to array to sort
+//        size of array in hedger::S_T units
+int AutoSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+
+  AutoSortSample sample;
+  Sample(array, size, &sample);
+  Algo *algo = Choose(sample);
+
+  if (!instrumented_)
+    return algo->Test(array, size, sample.max);
+  // Counted through the call, not the engine's settings, which other
+  // callers share.  The report names the engine picked through the stats'
+  // detail.
+  CountStats stats;
+  int result = algo->TestCounted(array, size, sample.max, stats);
+  stats.detail = algo->GetName();
+  Finish(stats);
+  return result;
+}
+
+//
+// Class-specific Implementation
+//
+
+// Sample
+// Characterize the input.  Min and max come from a full pass, since the
+// counting and radix engines need them exact; everything else is estimated
+// from at most kSampleMax evenly strided keys.
+// Entry: pointer to array
+//        size in elements
+//        pointer to sample to fill in
+void AutoSort::Sample(
+  const hedger::S_T *arr,
+  size_t size,
+  AutoSortSample *s
+)
+{
+  s->size = size;
+  s->min = s->max = size ? arr[0] : 0;
+  for (size_t i = 1; i < size; ++i) {
+    if (arr[i] < s->min)
+      s->min = arr[i];
+    if (arr[i] > s->max)
+      s->max = arr[i];
+  }
+
+  size_t sample_tot = std::min(kSampleMax, size >> 4);
+  if (sample_tot < 2) {
+    s->duplicate_rate = s->descent_rate = s->inversion_rate = 0.0;
+    s->run_estimate = 1;
+    return;
+  }
+
+  hedger::S_T keys[kSampleMax];
+  size_t stride = size / sample_tot;
+  size_t descent_tot = 0;
+  for (size_t i = 0; i < sample_tot; ++i) {
+    size_t pos = i * stride;
+    keys[i] = arr[pos];
+    if (pos + 1 < size && arr[pos] > arr[pos + 1])
+      ++descent_tot;
+  }
+
+  size_t inversion_tot = 0;
+  for (size_t i = 0; i < sample_tot; ++i)
+    for (size_t j = i + 1; j < sample_tot; ++j)
+      inversion_tot += keys[i] > keys[j];
+
+  std::sort(keys, keys + sample_tot);
+  size_t duplicate_tot = 0;
+  for (size_t i = 1; i < sample_tot; ++i)
+    duplicate_tot += keys[i] == keys[i - 1];
+
+  s->descent_rate = (double) descent_tot / sample_tot;
+  s->inversion_rate =
+    (double) inversion_tot / (sample_tot * (sample_tot - 1) / 2);
+  s->run_estimate = 1 + (size_t) (s->descent_rate * (size - 1));
+
+  // A small sample rarely sees the same key twice, so also take the
+  // pigeonhole bound implied by the exact range.
+  double range = (double) s->max - (double) s->min + 1.0;
+  double pigeonhole_rate = 1.0 - range / size;
+  s->duplicate_rate = std::max((double) duplicate_tot / sample_tot,
+    pigeonhole_rate);
+}
+
+// Choose
+// Pick an engine for the sampled input according to the profile.  Input
+// is nearly sorted when both its local disorder (descents) and its global
+// disorder (inversions among the strided sample) are low.
+// Entry: sample of the input
+// Exit:  engine to use
+Algo *AutoSort::Choose(const AutoSortSample& sample)
+{
+  size_t size = sample.size;
+  bool presorted = sample.descent_rate <= profile_.presorted_descent_max &&
+    sample.inversion_rate <= profile_.presorted_inversion_max;
+  bool reversed =
+    sample.inversion_rate >= 1.0 - profile_.presorted_inversion_max;
+  bool long_runs = profile_.run_length_min &&
+    sample.run_estimate * profile_.run_length_min <= size;
+
+  if (size <= profile_.insertion_max)
+    return insertion_sort_;
+  if (presorted && size <= profile_.presorted_insertion_max)
+    return insertion_sort_;
+  if ((double) sample.max - sample.min + 1.0 <=
+      profile_.counting_range_factor * size)
+    return counting_sort_;
+  if (profile_.multicore_min && size >= profile_.multicore_min)
+    return merge_sort_multicore_;
+  if (size >= profile_.radix_min)
+    return radix_sort_;
+  // The Lomuto partition degrades on duplicates, long sorted runs and
+  // ordered or reversed input.
+  if (presorted || reversed || long_runs ||
+      sample.duplicate_rate > profile_.duplicate_max)
+    return merge_sort_;
+  return quick_sort_;
+}
+} // namespace hedger
@@ -0,0 +1,99 @@
+// auto_sort.h
+//
+// Adaptive sort that samples its input and dispatches to the engine best
+// suited to it.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef AUTO_SORT_H_
+#define AUTO_SORT_H_
+
+#include "algo.h"
+
+namespace hedger
+{
+// AutoSortProfile
+// Dispatch thresholds.  The defaults are reasonable guesses; the harness
+// can measure real crossovers on the target machine (-C) and save them as
+// a profile to be loaded later (-P).
+struct AutoSortProfile {
+  AutoSortProfile();
+  bool Load(const char *path);
+  bool Save(const char *path) const;
+  size_t insertion_max;           // n at or below which insertion sort wins
+  size_t presorted_insertion_max; // ditto, for nearly-sorted input
+  double presorted_descent_max;   // descent rate below which input is
+                                  //   treated as nearly sorted
+  double presorted_inversion_max; // ditto, for the sampled inversion rate;
+                                  //   its mirror (1 - it) marks reversed
+                                  //   input
+  double counting_range_factor;   // counting sort when range <= factor * n
+  size_t radix_min;               // n at or above which radix sort wins
+  size_t multicore_min;           // n at or above which multi-core merge
+                                  //   sort wins (0 == never)
+  double duplicate_max;           // duplicate rate above which merge sort
+                                  //   replaces quick sort
+  size_t run_length_min;          // mean ascending run length at or above
+                                  //   which merge sort replaces quick sort
+                                  //   (0 == never)
+};
+
+// AutoSortSample
+// What a cheap look at the input reveals.
+struct AutoSortSample {
+  size_t size;
+  hedger::S_T min;          // exact
+  hedger::S_T max;          // exact
+  double duplicate_rate;    // fraction of sampled keys equal to a neighbour
+  double descent_rate;      // fraction of sampled adjacent pairs descending
+  double inversion_rate;    // fraction of sampled pairs out of order
+  size_t run_estimate;      // ascending runs, extrapolated from descents
+};
+
+class AutoSort : public Algo
+{
+ public:
+  AutoSort();
+  virtual ~AutoSort();
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Auto Sort"; }
+  bool LoadProfile(const char *path) { return profile_.Load(path); }
+  void SetProfile(const AutoSortProfile& profile) { profile_ = profile; }
+  const AutoSortProfile& GetProfile() { return profile_; }
+  static void Sample(const hedger::S_T *arr, size_t size, AutoSortSample *s);
+  Algo *Choose(const AutoSortSample& sample);
+  bool CanInstrument() { return true; }
+  void SetArena(Arena *arena);
+  size_t GetScratchSize(size_t size);
+  void SetThreadMax(int thread_max) {
+    merge_sort_multicore_->SetThreadMax(thread_max);
+  }
+  int GetThreadMax() { return merge_sort_multicore_->GetThreadMax(); }
+ private:
+  AutoSortProfile profile_;
+  Algo *insertion_sort_;
+  Algo *counting_sort_;
+  Algo *radix_sort_;
+  Algo *quick_sort_;
+  Algo *merge_sort_;
+  Algo *merge_sort_multicore_;
+};
+}
+
+#endif // AUTO_SORT_H_
@@ -0,0 +1,151 @@
+// cache_info.cc
+//
+// Data cache sizes, read from sysfs.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cstddef>
+
+#include "cache_info.h"
+
+namespace hedger {
+
+// Highest cache index directory probed under sysfs
+const int kCacheIndexMax = 16;
+
+// Used for a level neither sysfs nor sysconf() reports
+const size_t kCacheDefaultL1 = 32 * 1024;
+const size_t kCacheDefaultL2 = 256 * 1024;
+const size_t kCacheDefaultLine = 64;
+
+// ReadCacheLine
+// Entry: cache index directory
+//        file in it
+//        output buffer and its size
+// Exit:  true == read
+static bool ReadCacheLine(const char *dir, const char *name, char *buffer,
+  size_t size)
+{
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *file = fopen(path, "r");
+  if (nullptr == file)
+    return false;
+  bool result = nullptr != fgets(buffer, (int) size, file);
+  fclose(file);
+  return result;
+}
+
+// ParseSize
+// Parse a sysfs size such as "48K" or "105M".
+// Entry: text
+// Exit:  bytes (0 == unparsable)
+static size_t ParseSize(const char *text)
+{
+  char *end;
+  size_t size = strtoull(text, &end, 10);
+  if (end == text)
+    return 0;
+  if ('K' == *end)
+    size <<= 10;
+  else if ('M' == *end)
+    size <<= 20;
+  else if ('G' == *end)
+    size <<= 30;
+  return size;
+}
+
+// SysconfSize
+// Entry: sysconf() name
+// Exit:  bytes (0 == not reported)
+static size_t SysconfSize(int name)
+{
+  long size = sysconf(name);
+  return size > 0 ? (size_t) size : 0;
+}
+
+// Constructor
+// Walk the cache index directories, keeping data and unified caches.
+CacheInfo::CacheInfo() {
+  l1_ = l2_ = l3_ = line_ = 0;
+  source_ = "sysfs";
+  for (int index = 0; index < kCacheIndexMax; ++index) {
+    char dir[128], buffer[64];
+    snprintf(dir, sizeof(dir), "/sys/devices/system/cpu/cpu0/cache/index%d",
+      index);
+    if (!ReadCacheLine(dir, "type", buffer, sizeof(buffer)))
+      break;
+    if (!strncmp(buffer, "Instruction", strlen("Instruction")))
+      continue;
+    if (!ReadCacheLine(dir, "level", buffer, sizeof(buffer)))
+      continue;
+    int level = atoi(buffer);
+    if (!ReadCacheLine(dir, "size", buffer, sizeof(buffer)))
+      continue;
+    size_t size = ParseSize(buffer);
+    if (1 == level)
+      l1_ = size;
+    else if (2 == level)
+      l2_ = size;
+    else if (3 == level)
+      l3_ = size;
+    if (!line_ && ReadCacheLine(dir, "coherency_line_size", buffer,
+        sizeof(buffer)))
+      line_ = strtoull(buffer, nullptr, 10);
+  }
+
+  // Fill in whatever sysfs left out.
+  if (!l1_ || !l2_ || !l3_ || !line_)
+    source_ = "sysfs + sysconf";
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+  if (!l1_)
+    l1_ = SysconfSize(_SC_LEVEL1_DCACHE_SIZE);
+  if (!l2_)
+    l2_ = SysconfSize(_SC_LEVEL2_CACHE_SIZE);
+  if (!l3_)
+    l3_ = SysconfSize(_SC_LEVEL3_CACHE_SIZE);
+  if (!line_)
+    line_ = SysconfSize(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+  if (!l1_ || !l2_ || !line_)
+    source_ = "defaults";
+  if (!l1_)
+    l1_ = kCacheDefaultL1;
+  if (!l2_)
+    l2_ = kCacheDefaultL2;
+  if (!line_)
+    line_ = kCacheDefaultLine;
+  // Parts without an L3 are treated as if L2 were the last level.
+  if (!l3_)
+    l3_ = l2_;
+}
+
+// Get
+// Exit: the cache sizes, read on first use
+CacheInfo& CacheInfo::Get()
+{
+  static CacheInfo info;
+  return info;
+}
+}
@@ -0,0 +1,55 @@
+// cache_info.h
+//
+// Data cache sizes, read from sysfs, for engines that block their work to
+// fit the cache hierarchy.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef CACHE_INFO_H_
+#define CACHE_INFO_H_
+
+#include <cstddef>
+
+namespace hedger
+{
+// CacheInfo
+// Per-core data (or unified) cache sizes of CPU 0, read once from
+// /sys/devices/system/cpu/cpu0/cache.  A level sysfs does not describe
+// comes from sysconf(), and failing that from a typical desktop part;
+// GetSource() says which.
+class CacheInfo
+{
+ public:
+  static CacheInfo& Get();
+  size_t GetL1() { return l1_; }            // bytes
+  size_t GetL2() { return l2_; }            // bytes
+  size_t GetL3() { return l3_; }            // bytes
+  size_t GetLineSize() { return line_; }    // bytes
+  const char *GetSource() { return source_; }
+ private:
+  CacheInfo();
+  size_t l1_;
+  size_t l2_;
+  size_t l3_;
+  size_t line_;
+  const char *source_;
+};
+}
+
+#endif // CACHE_INFO_H_
@@ -31,6 +31,7 @@
 #include <vector>
 
 #include "counting_sort.h"
+#include "sort_kernels.h"
 
 namespace hedger {
 
@@ -44,21 +45,51 @@ CountingSort::~CountingSort() {
 
 // Test
 // Implementation of Algo's pure virtual Test()
+// The key range is found by scanning rather than trusting the caller, so
+// negative keys and keys beyond the array size are handled.
 // Entry: pointer to array to sort
 //        size of array in hedger::S_T units
+//        range (ignored)
+// Exit:  0 == success
 int CountingSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
 {
-  int result = 0;
+  if (nullptr == array || !size)
+    return 0;
 
-  Sort(array, size, 0, range);
-
-  return result;
+  hedger::S_T range_low, range_high;
+  GetRange(array, size, &range_low, &range_high);
+  return Sort(array, size, range_low, range_high);
 }
 
 //
 // Class-specific Implementation
 //
 
+// GetRange
+// Find the lowest and highest keys.
+// Entry: pointer to array
+//        size (must be nonzero)
+//        pointer to lowest key
+//        pointer to highest key
+void CountingSort::GetRange(
+  const hedger::S_T *arr,
+  size_t size,
+  hedger::S_T *range_low,
+  hedger::S_T *range_high
+)
+{
+  hedger::S_T low = arr[0];
+  hedger::S_T high = arr[0];
+  for (size_t i = 1; i < size; ++i) {
+    if (arr[i] < low)
+      low = arr[i];
+    if (arr[i] > high)
+      high = arr[i];
+  }
+  *range_low = low;
+  *range_high = high;
+}
+
 // Sort
 //
 // Counts instances of unique elements and sorts them.
@@ -68,48 +99,48 @@ int CountingSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
 //        size
 //        lowest item value
 //        highest item value (inclusive)
-// Exit:  arr sorted
-void CountingSort::Sort(
+// Exit:  arr sorted, 0 == success
+int CountingSort::Sort(
   hedger::S_T *arr,
   int size,
   hedger::S_T range_low,
   hedger::S_T range_hi
 )
 {
-  assert(range_hi > range_low);
+  if (range_hi < range_low)
+    return -1;
 
-  int range = range_hi - range_low;
+  // Computed wide so that a full-width range does not overflow.
+  long long range = (long long) range_hi - range_low;
   // This allocates an array of unique element counts and clears it.
-  int *count_arr = (int *) calloc(range + 1, sizeof(int));
+  Scratch scratch(arena_);
+  int *count_arr = (int *) scratch.Alloc((range + 1) * sizeof(int));
   if (nullptr == count_arr) {
     // TODO: Log error
-    return;
+    return -1;
   }
-  assert(count_arr);
+  memset(count_arr, 0, (range + 1) * sizeof(int));
   // Here we count how many of each element and save the counts in count_arr.
-  for (auto i = 0; i < size; ++i) {
-    ++count_arr[arr[i] - range_low];
-  }
+  GetSortKernels().histogram(arr, size, range_low, count_arr);
   // Change count[i] so that count[i] now contains actual
   //  position of this digit in output[]
-  for (auto i = 1; i < range; i++)
+  for (long long i = 1; i <= range; i++)
     count_arr[i] += count_arr[i - 1];
 
   // Write the output
   int out_index = 0;
-  int count_index = 0;
+  long long count_index = 0;
   int next_delta_index = -1;
   hedger::S_T write_value = 0;
   while (out_index < size) {
     while (out_index >= next_delta_index) {
       next_delta_index = count_arr[count_index];
-      write_value = count_index;
+      write_value = (hedger::S_T) (count_index + range_low);
       ++count_index;
     }
     arr[out_index] = write_value;
     ++out_index;
   }
-  // Clean up and exit
-  free(count_arr);
+  return 0;
 }
 } // namespace hedger
@@ -24,6 +24,7 @@
 #define COUNTING_SORT_H_
 
 #include "algo.h"
+#include "roofline.h"
 
 namespace hedger
 {
@@ -34,11 +35,30 @@ class CountingSort : public Algo
   virtual ~CountingSort();
   int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
   const char *GetName() { return "Counting Sort"; }
-  void Sort(
+  size_t GetScratchSize(size_t size) {
+    return Arena::Round((size + 1) * sizeof(int));
+  }
+  // The range scan and the histogram read the keys and the output pass
+  // writes them; the count table, modelled as one entry per key as
+  // GetScratchSize() sizes it, is cleared, summed and read back.
+  double GetMemoryBytes(size_t size) {
+    size_t bytes = size * sizeof(hedger::S_T);
+    size_t table_bytes = size * sizeof(int);
+    if (!RooflineBeyondCache(bytes + table_bytes))
+      return 0.0;
+    return 3.0 * bytes + 4.0 * table_bytes;
+  }
+  static void GetRange(
+    const hedger::S_T *arr,
+    size_t size,
+    hedger::S_T *range_low,
+    hedger::S_T *range_high
+  );
+  int Sort(
     hedger::S_T *arr,
     int size,
     hedger::S_T range_low,
-    hedger::S_T range_hight
+    hedger::S_T range_high
   );
 };
 }
@@ -0,0 +1,338 @@
+// counting_sort_parallel.cc
+//
+// Multi-threaded counting sort over an arbitrary key range.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <memory.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstddef>
+#include <thread>
+
+#include "counting_sort_parallel.h"
+
+namespace hedger {
+
+// Interleaved sub-histograms per thread.  Consecutive keys land in
+// different tables, so a run of equal keys does not wait on its own store.
+const int kSubHistMax = 4;
+// Arrays smaller than this are not worth waking threads for.
+const size_t kParallelMin = 1 << 15;
+// Default histogram memory budget in bytes.
+const size_t kMemoryBudget = 256 << 20;
+
+// Constructor
+CountingSortParallel::CountingSortParallel() {
+  thread_max_ = std::thread::hardware_concurrency();
+  if (thread_max_ < 1)
+    thread_max_ = 1;
+  memory_budget_ = kMemoryBudget;
+  radix_fallback_ = true;
+}
+
+// Destructor
+CountingSortParallel::~CountingSortParallel() {
+}
+
+// GetScratchSize
+// Room for the largest plan on keys spanning size values: every
+// sub-histogram of every thread plus the merged histogram, within the
+// memory budget, and the per-thread tables.
+// Entry: size in elements
+// Exit:  bytes
+size_t CountingSortParallel::GetScratchSize(size_t size)
+{
+  size_t hist_bytes =
+    ((size_t) thread_max_ * kSubHistMax + 1) * (size + 1) * sizeof(int);
+  if (hist_bytes > memory_budget_)
+    hist_bytes = memory_budget_;
+  return Arena::Round(hist_bytes) + 2 * Arena::Round(
+    thread_max_ * (2 * sizeof(hedger::S_T) + sizeof(size_t) +
+      sizeof(pthread_t) + sizeof(CountingSortParallelParams)));
+}
+
+// Test
+// Implementation of Algo's pure virtual Test()
+// Entry: pointer to array to sort
+//        size of array in hedger::S_T units
+//        range (ignored; the range is found by scanning)
+// Exit:  0 == success, -1 == range over budget and no fallback
+int CountingSortParallel::Test(
+  hedger::S_T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+
+  Scratch scratch(arena_);
+  CountingSortParallelContext ctx;
+  ctx.arr = array;
+  ctx.size = size;
+  ctx.thread_tot = size < kParallelMin ? 1 : thread_max_;
+  ctx.hist_arr = ctx.count_arr = nullptr;
+  ctx.low_arr = (hedger::S_T *) scratch.Alloc(
+    ctx.thread_tot * sizeof(hedger::S_T));
+  ctx.high_arr = (hedger::S_T *) scratch.Alloc(
+    ctx.thread_tot * sizeof(hedger::S_T));
+  ctx.slice_offset_arr = (size_t *) scratch.Alloc(
+    ctx.thread_tot * sizeof(size_t));
+  ctx.memory_budget = memory_budget_;
+  ctx.radix_fallback = radix_fallback_;
+  ctx.scratch = &scratch;
+
+  // The calling thread works as thread 0.
+  pthread_t *thread_arr = (pthread_t *) scratch.Alloc(
+    ctx.thread_tot * sizeof(pthread_t));
+  CountingSortParallelParams *params_arr = (CountingSortParallelParams *)
+    scratch.Alloc(ctx.thread_tot * sizeof(CountingSortParallelParams));
+  if (nullptr == ctx.low_arr || nullptr == ctx.high_arr ||
+      nullptr == ctx.slice_offset_arr || nullptr == thread_arr ||
+      nullptr == params_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  for (int i = 0; i < ctx.thread_tot; ++i) {
+    params_arr[i].ctx = &ctx;
+    params_arr[i].thread_index = i;
+  }
+  // Threads are created first and held at the gate; if one cannot be
+  // created, the sort goes ahead with those that were, so the chunks and
+  // the barrier count only threads that exist.
+  ctx.go.store(false, std::memory_order_relaxed);
+  int started_tot = 1;
+  while (started_tot < ctx.thread_tot) {
+    int error = pthread_create(
+      &thread_arr[started_tot],
+      NULL,
+      &CountingSortParallel::Worker,
+      (void *) &params_arr[started_tot]);
+    if (error) {
+      // TODO: LOG ERROR
+      break;
+    }
+    ++started_tot;
+  }
+  ctx.thread_tot = started_tot;
+  pthread_barrier_init(&ctx.barrier, NULL, ctx.thread_tot);
+  ctx.go.store(true, std::memory_order_release);
+  Worker((void *) &params_arr[0]);
+  for (int i = 1; i < ctx.thread_tot; ++i) {
+    void *result;
+    pthread_join(thread_arr[i], &result);
+  }
+
+  int result = 0;
+  if (kModeRadix == ctx.mode) {
+    result = radix_sort_.Test(array, size);
+  } else if (kModeRefuse == ctx.mode) {
+    result = -1;
+  }
+
+  pthread_barrier_destroy(&ctx.barrier);
+  return result;
+}
+
+//
+// Class-specific Implementation
+//
+
+// Worker
+// Body of every counting thread.  Phases are separated by barriers; the
+// serial steps in between are done by thread 0.
+// Entry: pointer to CountingSortParallelParams
+// Exit:  nullptr (ignored)
+void *CountingSortParallel::Worker(void *params)
+{
+  CountingSortParallelParams *worker_params =
+    (CountingSortParallelParams *) params;
+  CountingSortParallelContext *ctx = worker_params->ctx;
+  int t = worker_params->thread_index;
+  while (!ctx->go.load(std::memory_order_acquire))
+    sched_yield();
+
+  // Phase 1: min and max of this thread's chunk
+  size_t start = ctx->Chunk(ctx->size, t);
+  size_t end = ctx->Chunk(ctx->size, t + 1);
+  GetRange(&ctx->arr[start], end - start,
+    &ctx->low_arr[t], &ctx->high_arr[t]);
+  pthread_barrier_wait(&ctx->barrier);
+  if (!t)
+    Plan(ctx);
+  pthread_barrier_wait(&ctx->barrier);
+  if (kModeCount != ctx->mode)
+    return nullptr;
+
+  // Phase 2: count into this thread's sub-histograms
+  Count(ctx, t);
+  pthread_barrier_wait(&ctx->barrier);
+
+  // Phase 3: fold all histograms together, one value slice per thread
+  MergeSlice(ctx, t);
+  pthread_barrier_wait(&ctx->barrier);
+  if (!t) {
+    // Slice totals become slice output offsets.
+    size_t offset = 0;
+    for (int i = 0; i < ctx->thread_tot; ++i) {
+      size_t slice_tot = ctx->slice_offset_arr[i];
+      ctx->slice_offset_arr[i] = offset;
+      offset += slice_tot;
+    }
+  }
+  pthread_barrier_wait(&ctx->barrier);
+
+  // Phase 4: write this thread's value slice at its offset
+  WriteSlice(ctx, t);
+  return nullptr;
+}
+
+// Plan
+// Combine the per-thread ranges and decide how to proceed: count with as
+// many sub-histograms as the memory budget allows, hand off to radix sort,
+// or refuse.  Allocates the histograms when counting; each thread clears
+// its own in Count().
+// Entry: sort context
+void CountingSortParallel::Plan(CountingSortParallelContext *ctx)
+{
+  ctx->range_low = ctx->low_arr[0];
+  ctx->range_high = ctx->high_arr[0];
+  for (int i = 1; i < ctx->thread_tot; ++i) {
+    if (ctx->low_arr[i] < ctx->range_low)
+      ctx->range_low = ctx->low_arr[i];
+    if (ctx->high_arr[i] > ctx->range_high)
+      ctx->range_high = ctx->high_arr[i];
+  }
+  long long range = (long long) ctx->range_high - ctx->range_low;
+  ctx->hist_size = (size_t) range + 1;
+
+  ctx->mode = kModeRefuse;
+  for (ctx->sub_hist_tot = kSubHistMax; ctx->sub_hist_tot;
+       ctx->sub_hist_tot >>= 1) {
+    size_t hist_tot = (size_t) ctx->thread_tot * ctx->sub_hist_tot + 1;
+    if (hist_tot * ctx->hist_size * sizeof(int) <= ctx->memory_budget) {
+      ctx->mode = kModeCount;
+      break;
+    }
+  }
+  if (kModeCount == ctx->mode) {
+    ctx->hist_arr = (int *) ctx->scratch->Alloc(
+      (size_t) ctx->thread_tot * ctx->sub_hist_tot * ctx->hist_size *
+      sizeof(int));
+    ctx->count_arr = (int *) ctx->scratch->Alloc(
+      ctx->hist_size * sizeof(int));
+    if (nullptr == ctx->hist_arr || nullptr == ctx->count_arr) {
+      // TODO: LOG ERROR
+      ctx->mode = kModeRefuse;
+    }
+  }
+  if (kModeRefuse == ctx->mode && ctx->radix_fallback)
+    ctx->mode = kModeRadix;
+}
+
+// Count
+// Clear this thread's sub-histograms, then tally its chunk into them,
+// rotating through the sub-histograms.
+// Entry: sort context
+//        thread index
+void CountingSortParallel::Count(
+  CountingSortParallelContext *ctx,
+  int thread_index)
+{
+  size_t start = ctx->Chunk(ctx->size, thread_index);
+  size_t end = ctx->Chunk(ctx->size, thread_index + 1);
+  size_t hist_size = ctx->hist_size;
+  int *hist =
+    &ctx->hist_arr[(size_t) thread_index * ctx->sub_hist_tot * hist_size];
+  const hedger::S_T *arr = ctx->arr;
+  unsigned low = (unsigned) ctx->range_low;
+  memset(hist, 0, ctx->sub_hist_tot * hist_size * sizeof(int));
+
+  size_t i = start;
+  if (kSubHistMax == ctx->sub_hist_tot) {
+    int *hist_1 = hist + hist_size;
+    int *hist_2 = hist_1 + hist_size;
+    int *hist_3 = hist_2 + hist_size;
+    for (; i + 4 <= end; i += 4) {
+      ++hist[(unsigned) arr[i] - low];
+      ++hist_1[(unsigned) arr[i + 1] - low];
+      ++hist_2[(unsigned) arr[i + 2] - low];
+      ++hist_3[(unsigned) arr[i + 3] - low];
+    }
+  } else if (2 == ctx->sub_hist_tot) {
+    int *hist_1 = hist + hist_size;
+    for (; i + 2 <= end; i += 2) {
+      ++hist[(unsigned) arr[i] - low];
+      ++hist_1[(unsigned) arr[i + 1] - low];
+    }
+  }
+  for (; i < end; ++i)
+    ++hist[(unsigned) arr[i] - low];
+}
+
+// MergeSlice
+// Sum every histogram over this thread's value slice into the merged
+// histogram and record the slice total.  The inner loops are straight
+// array adds.
+// Entry: sort context
+//        thread index
+void CountingSortParallel::MergeSlice(
+  CountingSortParallelContext *ctx,
+  int thread_index)
+{
+  size_t start = ctx->Chunk(ctx->hist_size, thread_index);
+  size_t end = ctx->Chunk(ctx->hist_size, thread_index + 1);
+  size_t hist_tot = (size_t) ctx->thread_tot * ctx->sub_hist_tot;
+  int *count_arr = ctx->count_arr;
+
+  memcpy(&count_arr[start], &ctx->hist_arr[start], (end - start) * sizeof(int));
+  for (size_t h = 1; h < hist_tot; ++h) {
+    const int *hist = &ctx->hist_arr[h * ctx->hist_size];
+    for (size_t v = start; v < end; ++v)
+      count_arr[v] += hist[v];
+  }
+
+  size_t slice_tot = 0;
+  for (size_t v = start; v < end; ++v)
+    slice_tot += count_arr[v];
+  ctx->slice_offset_arr[thread_index] = slice_tot;
+}
+
+// WriteSlice
+// Emit every key in this thread's value slice, starting at the slice's
+// prefix offset.
+// Entry: sort context
+//        thread index
+void CountingSortParallel::WriteSlice(
+  CountingSortParallelContext *ctx,
+  int thread_index)
+{
+  size_t start = ctx->Chunk(ctx->hist_size, thread_index);
+  size_t end = ctx->Chunk(ctx->hist_size, thread_index + 1);
+  hedger::S_T *out = &ctx->arr[ctx->slice_offset_arr[thread_index]];
+  for (size_t v = start; v < end; ++v) {
+    hedger::S_T value = (hedger::S_T) ((long long) ctx->range_low + v);
+    for (int c = ctx->count_arr[v]; c; --c)
+      *out++ = value;
+  }
+}
+} // namespace hedger
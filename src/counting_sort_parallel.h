@@ -0,0 +1,114 @@
+// counting_sort_parallel.h
+//
+// Multi-threaded counting sort over an arbitrary key range.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef COUNTING_SORT_PARALLEL_H_
+#define COUNTING_SORT_PARALLEL_H_
+
+#include <pthread.h>
+
+#include <atomic>
+
+#include "counting_sort.h"
+#include "radix_sort.h"
+
+namespace hedger
+{
+struct CountingSortParallelContext;
+
+// CountingSortParallel
+// Finds min and max in parallel, counts each thread's share of the input
+// into several interleaved sub-histograms (so runs of equal keys do not
+// serialize on one counter), merges the histograms by value slice and
+// writes each slice at its prefix offset in parallel.
+class CountingSortParallel : public CountingSort
+{
+ public:
+  CountingSortParallel();
+  virtual ~CountingSortParallel();
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Counting Sort Parallel"; }
+  void SetThreadMax(int thread_max) {
+    thread_max_ = thread_max < 1 ? 1 : thread_max;
+  }
+  int GetThreadMax() { return thread_max_; }
+  // Histogram bytes above which the sort hands off or refuses
+  void SetMemoryBudget(size_t memory_budget) {
+    memory_budget_ = memory_budget;
+  }
+  // Hand over-budget ranges to radix sort rather than failing
+  void SetRadixFallback(bool radix_fallback) {
+    radix_fallback_ = radix_fallback;
+  }
+  void SetArena(Arena *arena) {
+    arena_ = arena;
+    radix_sort_.SetArena(arena);
+  }
+  size_t GetScratchSize(size_t size);
+  static void *Worker(void *params);
+  enum Mode { kModeCount, kModeRadix, kModeRefuse };
+ private:
+  static void Plan(CountingSortParallelContext *ctx);
+  static void Count(CountingSortParallelContext *ctx, int thread_index);
+  static void MergeSlice(CountingSortParallelContext *ctx, int thread_index);
+  static void WriteSlice(CountingSortParallelContext *ctx, int thread_index);
+  // Configuration
+  int thread_max_;
+  size_t memory_budget_;
+  bool radix_fallback_;
+  RadixSort radix_sort_;
+};
+
+// CountingSortParallelContext
+// Per-sort state shared by the counting threads
+struct CountingSortParallelContext {
+  size_t Chunk(size_t total, int thread_index) const {
+    return total * thread_index / thread_tot;
+  }
+  hedger::S_T *arr;
+  size_t size;
+  int thread_tot;
+  int sub_hist_tot;
+  CountingSortParallel::Mode mode;
+  hedger::S_T range_low;
+  hedger::S_T range_high;
+  size_t hist_size;             // entries per histogram (range + 1)
+  int *hist_arr;                // thread_tot * sub_hist_tot histograms
+  int *count_arr;               // merged histogram
+  hedger::S_T *low_arr;         // per-thread minimum
+  hedger::S_T *high_arr;        // per-thread maximum
+  size_t *slice_offset_arr;     // per-thread output offset
+  size_t memory_budget;
+  bool radix_fallback;
+  hedger::Scratch *scratch;     // the calling thread's scratch memory
+  pthread_barrier_t barrier;    // for thread_tot threads, set up before go
+  std::atomic<bool> go;         // thread_tot is final; workers may start
+};
+
+// CountingSortParallelParams
+// Parameter structure for counting threads
+struct CountingSortParallelParams {
+  hedger::CountingSortParallelContext *ctx;
+  int thread_index;
+};
+}
+
+#endif // COUNTING_SORT_PARALLEL_H_
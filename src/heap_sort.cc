@@ -24,13 +24,16 @@
 #include <cstddef>
 
 #include "heap_sort.h"
+#include "sort_types.h"
 
 namespace hedger {
 
-HeapSort::HeapSort() {
+template <class T, class Compare>
+BasicHeapSort<T, Compare>::BasicHeapSort() {
 }
 
-HeapSort::~HeapSort() {
+template <class T, class Compare>
+BasicHeapSort<T, Compare>::~BasicHeapSort() {
 }
 
 // Test
@@ -39,10 +42,14 @@ HeapSort::~HeapSort() {
 //        size of array
 // Exit:  Result of test
 //
-int HeapSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+template <class T, class Compare>
+int BasicHeapSort<T, Compare>::Test(T *array, size_t size, hedger::S_T range)
 {
   int result = 0;
-  Sort(array, size);
+  if (this->instrumented_)
+    Sort<CountStats>(array, size);
+  else
+    Sort<NoStats>(array, size);
   return result;
 }
 
@@ -52,71 +59,95 @@ int HeapSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
 
 // Swap
 // Swap two array values identified by index
-// Entry: pointer to array
+// Entry: sort context
 //        index a
 //        index b
-void HeapSort::Swap(int index_a, int index_b)
+template <class T, class Compare>
+template <class Stats>
+void BasicHeapSort<T, Compare>::Swap(
+  Context<Stats>& ctx,
+  int index_a,
+  int index_b)
 {
-  hedger::S_T swap = arr_[index_a];
-  arr_[index_a] = arr_[index_b];
-  arr_[index_b] = swap;
+  T *arr = ctx.arr;
+  ctx.stats.Swap();
+  T swap = arr[index_a];
+  arr[index_a] = arr[index_b];
+  arr[index_b] = swap;
 }
 
-int HeapSort::Parent(int index){
- return index >> 1;
+// Parent, Left, Right
+// Navigate the heap.  The array is 0-based, so the root's children are
+// 1 and 2.
+template <class T, class Compare>
+int BasicHeapSort<T, Compare>::Parent(int index){
+ return (index - 1) >> 1;
 }
-int HeapSort::Right(int index) {
-  return (index << 1) + 1;
+template <class T, class Compare>
+int BasicHeapSort<T, Compare>::Right(int index) {
+  return (index << 1) + 2;
 }
-int HeapSort::Left(int index) {
-  return index << 1;
+template <class T, class Compare>
+int BasicHeapSort<T, Compare>::Left(int index) {
+  return (index << 1) + 1;
 }
 
 // MaxHeapify
-// Entry: size of array
+// Entry: sort context
+//        size of array
 //        index
-void HeapSort::MaxHeapify(int size, int index)
+template <class T, class Compare>
+template <class Stats>
+void BasicHeapSort<T, Compare>::MaxHeapify(
+  Context<Stats>& ctx,
+  int size,
+  int index)
 {
-  IncMaxRecurseDepth();
+  ctx.stats.Enter();
+  T *arr = ctx.arr;
   int left = Left(index);
   int right = Right(index);
-  hedger::S_T largest;
-  if ((left < size) && (arr_[left] > arr_[index]))
+  int largest;
+  if ((left < size) && ctx.Less(arr[index], arr[left]))
     largest = left;
   else
     largest = index;
-  if ((right < size) && (arr_[right] > arr_[largest]))
+  if ((right < size) && ctx.Less(arr[largest], arr[right]))
     largest = right;
   if (largest != index) {
-    Swap(index, largest);
-    MaxHeapify(size, largest);
+    Swap(ctx, index, largest);
+    MaxHeapify(ctx, size, largest);
   }
-  DecMaxRecurseDepth();
+  ctx.stats.Leave();
 }
 
 // BuildMaxHeap
-// Entry: size of array
-void HeapSort::BuildMaxHeap(int size)
+// Entry: sort context
+//        size of array
+template <class T, class Compare>
+template <class Stats>
+void BasicHeapSort<T, Compare>::BuildMaxHeap(Context<Stats>& ctx, int size)
 {
-  for (auto i = (size >> 1); i >= 0; --i) {
-    MaxHeapify(size, i);
+  for (auto i = (size >> 1) - 1; i >= 0; --i) {
+    MaxHeapify(ctx, size, i);
   }
 }
 
 // sort
 // API entry for sort.
-// Entry: pointer to array
-//        start index
-//        end index
-void HeapSort::SortRecurse(int size)
+// Entry: sort context
+//        size of array
+template <class T, class Compare>
+template <class Stats>
+void BasicHeapSort<T, Compare>::SortRecurse(Context<Stats>& ctx, int size)
 {
   int heap_size = size;
   if (size) {
-    BuildMaxHeap(size);
+    BuildMaxHeap(ctx, size);
     for (auto i = size - 1; i >= 1; --i) {
-      Swap(i, 0);
+      Swap(ctx, i, 0);
       --heap_size;
-      MaxHeapify(heap_size, 0);
+      MaxHeapify(ctx, heap_size, 0);
     }
   }
 }
@@ -125,11 +156,16 @@ void HeapSort::SortRecurse(int size)
 // Entry: pointer to array
 //        start index
 //        end index
-void HeapSort::Sort(hedger::S_T *arr, int size)
+template <class T, class Compare>
+template <class Stats>
+void BasicHeapSort<T, Compare>::Sort(T *arr, int size)
 {
   if (arr && size) {
-    arr_ = arr;
-    SortRecurse(size);
+    Context<Stats> ctx(arr, this->less_);
+    SortRecurse(ctx, size);
+    this->Finish(ctx.stats);
   }
 }
+
+SORT_TYPES_INSTANTIATE(BasicHeapSort)
 } // namespace hedger
@@ -27,23 +27,30 @@
 
 namespace hedger
 {
-class HeapSort : public Algo
+template <class T, class Compare = std::less<T> >
+class BasicHeapSort : public BasicAlgo<T, Compare>
 {
  public:
-  HeapSort();
-  ~HeapSort();
-  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicHeapSort();
+  ~BasicHeapSort();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
   const char *GetName() { return "Heap Sort"; }
+  bool CanInstrument() { return true; }
  private:
   inline int Parent(int index);
   inline int Left(int index);
   inline int Right(int index);
-  void MaxHeapify(int size, int index);
-  void BuildMaxHeap(int size);
-  void SortRecurse(int size);
-  void Sort(hedger::S_T *arr, int size);
-  inline void Swap(int index_a, int index_b);
+  template <class Stats>
+    void MaxHeapify(Context<Stats>& ctx, int size, int index);
+  template <class Stats> void BuildMaxHeap(Context<Stats>& ctx, int size);
+  template <class Stats> void SortRecurse(Context<Stats>& ctx, int size);
+  template <class Stats> void Sort(T *arr, int size);
+  template <class Stats>
+    inline void Swap(Context<Stats>& ctx, int index_a, int index_b);
 };
+
+typedef BasicHeapSort<hedger::S_T> HeapSort;
 }
 
 #endif // HEAP_SORT_H_
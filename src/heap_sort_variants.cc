@@ -0,0 +1,294 @@
+// heap_sort_variants.cc
+//
+// Heap sort variants that avoid the recursive sift-down of HeapSort:
+// iterative, Floyd's bottom-up, and a cache-line-aligned d-ary heap.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "heap_sort_variants.h"
+#include "sort_types.h"
+
+namespace hedger {
+
+//
+// HeapSortIterative
+//
+
+template <class T, class Compare>
+BasicHeapSortIterative<T, Compare>::BasicHeapSortIterative() {
+}
+
+template <class T, class Compare>
+BasicHeapSortIterative<T, Compare>::~BasicHeapSortIterative() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+template <class T, class Compare>
+int BasicHeapSortIterative<T, Compare>::Test(T *arr, size_t size, hedger::S_T range)
+{
+  if (nullptr == arr || size < 2)
+    return 0;
+  for (size_t i = size >> 1; i--; )
+    SiftDown(arr, size, i, this->less_);
+  for (size_t end = size - 1; end; --end) {
+    // Move the maximum out to the sorted tail and sift its replacement.
+    T value = arr[end];
+    arr[end] = arr[0];
+    arr[0] = value;
+    SiftDown(arr, end, 0, this->less_);
+  }
+  return 0;
+}
+
+// SiftDown
+// Restore the heap below index, moving larger children up into the hole.
+// Entry: pointer to heap
+//        heap size
+//        index of key to sift
+//        strict weak ordering
+template <class T, class Compare>
+void BasicHeapSortIterative<T, Compare>::SiftDown(
+  T *arr,
+  size_t size,
+  size_t index,
+  const Compare& less)
+{
+  T value = arr[index];
+  for (;;) {
+    size_t child = (index << 1) + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size && less(arr[child], arr[child + 1]))
+      ++child;
+    if (!less(value, arr[child]))
+      break;
+    arr[index] = arr[child];
+    index = child;
+  }
+  arr[index] = value;
+}
+
+//
+// HeapSortBottomUp
+//
+
+template <class T, class Compare>
+BasicHeapSortBottomUp<T, Compare>::BasicHeapSortBottomUp() {
+}
+
+template <class T, class Compare>
+BasicHeapSortBottomUp<T, Compare>::~BasicHeapSortBottomUp() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+template <class T, class Compare>
+int BasicHeapSortBottomUp<T, Compare>::Test(T *arr, size_t size, hedger::S_T range)
+{
+  if (nullptr == arr || size < 2)
+    return 0;
+  for (size_t i = size >> 1; i--; )
+    SiftDown(arr, size, i, this->less_);
+  for (size_t end = size - 1; end; --end) {
+    T value = arr[end];
+    arr[end] = arr[0];
+    arr[0] = value;
+    SiftDown(arr, end, 0, this->less_);
+  }
+  return 0;
+}
+
+// SiftDown
+// Descend to a leaf along the larger children without comparing against
+// the sifted key, back up to the first node not smaller than it, then
+// shift that path up one level and drop the key in.
+// Entry: pointer to heap
+//        heap size
+//        index of key to sift
+//        strict weak ordering
+template <class T, class Compare>
+void BasicHeapSortBottomUp<T, Compare>::SiftDown(
+  T *arr,
+  size_t size,
+  size_t index,
+  const Compare& less)
+{
+  T value = arr[index];
+  size_t leaf = index;
+  size_t child;
+  while ((child = (leaf << 1) + 1) < size) {
+    if (child + 1 < size && less(arr[child], arr[child + 1]))
+      ++child;
+    leaf = child;
+  }
+  // arr[index] holds the key itself, so the climb stops there at worst.
+  while (less(arr[leaf], value))
+    leaf = (leaf - 1) >> 1;
+  T carry = value;
+  while (leaf > index) {
+    T swap = arr[leaf];
+    arr[leaf] = carry;
+    carry = swap;
+    leaf = (leaf - 1) >> 1;
+  }
+  arr[index] = carry;
+}
+
+//
+// HeapSortDary
+//
+
+// Widest supported arity; bounds the unaligned prefix.
+const int kDaryMax = 8;
+
+// Constructor
+// Entry: children per node (4 or 8)
+template <class T, class Compare>
+BasicHeapSortDary<T, Compare>::BasicHeapSortDary(int arity) {
+  arity_ = (4 == arity) ? 4 : kDaryMax;
+  snprintf(name_, sizeof(name_), "Heap Sort %d-ary", arity_);
+}
+
+template <class T, class Compare>
+BasicHeapSortDary<T, Compare>::~BasicHeapSortDary() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+template <class T, class Compare>
+int BasicHeapSortDary<T, Compare>::Test(T *arr, size_t size, hedger::S_T range)
+{
+  if (nullptr == arr || size < 2)
+    return 0;
+  if (4 == arity_)
+    Sort<4>(arr, size, this->less_);
+  else
+    Sort<kDaryMax>(arr, size, this->less_);
+  return 0;
+}
+
+// SiftDown
+// Restore the d-ary heap below index.  Children of i are D*i+1 .. D*i+D.
+// Entry: pointer to heap
+//        heap size
+//        index of key to sift
+//        strict weak ordering
+template <class T, class Compare>
+template <int D>
+void BasicHeapSortDary<T, Compare>::SiftDown(
+  T *arr,
+  size_t size,
+  size_t index,
+  const Compare& less)
+{
+  T value = arr[index];
+  for (;;) {
+    size_t first = D * index + 1;
+    if (first >= size)
+      break;
+    size_t last = first + D < size ? first + D : size;
+    size_t largest = first;
+    for (size_t child = first + 1; child < last; ++child)
+      if (less(arr[largest], arr[child]))
+        largest = child;
+    if (!less(value, arr[largest]))
+      break;
+    arr[index] = arr[largest];
+    index = largest;
+  }
+  arr[index] = value;
+}
+
+// Sort
+// Heap sort the array from an offset chosen so that every child block
+// starts on a D-element boundary in memory, then merge the skipped prefix
+// back in.
+// Entry: pointer to array
+//        size of array
+//        strict weak ordering
+template <class T, class Compare>
+template <int D>
+void BasicHeapSortDary<T, Compare>::Sort(
+  T *arr,
+  size_t size,
+  const Compare& less)
+{
+  // First child of the root lands at heap[1]; align that.
+  size_t elem = (uintptr_t) arr / sizeof(T);
+  size_t offset = (D - (elem + 1) % D) % D;
+  if (offset >= size)
+    offset = size;
+  T *heap = arr + offset;
+  size_t heap_size = size - offset;
+
+  if (heap_size > 1) {
+    for (size_t i = (heap_size - 2) / D + 1; i--; )
+      SiftDown<D>(heap, heap_size, i, less);
+    for (size_t end = heap_size - 1; end; --end) {
+      T value = heap[end];
+      heap[end] = heap[0];
+      heap[0] = value;
+      SiftDown<D>(heap, end, 0, less);
+    }
+  }
+
+  if (offset) {
+    // Insertion sort the few prefix keys, then merge them with the heap
+    // output.  The write index never passes the next unread heap key.
+    T prefix[kDaryMax];
+    for (size_t j = 0; j < offset; ++j) {
+      T key = arr[j];
+      size_t i = j;
+      for (; i && less(key, prefix[i - 1]); --i)
+        prefix[i] = prefix[i - 1];
+      prefix[i] = key;
+    }
+    size_t left = 0;
+    size_t right = offset;
+    size_t out = 0;
+    while (left < offset && right < size) {
+      if (less(arr[right], prefix[left]))
+        arr[out++] = arr[right++];
+      else
+        arr[out++] = prefix[left++];
+    }
+    while (left < offset)
+      arr[out++] = prefix[left++];
+  }
+}
+
+SORT_TYPES_INSTANTIATE(BasicHeapSortIterative)
+SORT_TYPES_INSTANTIATE(BasicHeapSortBottomUp)
+SORT_TYPES_INSTANTIATE(BasicHeapSortDary)
+} // namespace hedger
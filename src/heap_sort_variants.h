@@ -0,0 +1,109 @@
+// heap_sort_variants.h
+//
+// Heap sort variants that avoid the recursive sift-down of HeapSort:
+// iterative, Floyd's bottom-up, and a cache-line-aligned d-ary heap.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef HEAP_SORT_VARIANTS_H_
+#define HEAP_SORT_VARIANTS_H_
+
+#include "algo.h"
+
+namespace hedger
+{
+// HeapSortIterative
+// Binary heap with a loop-based sift-down that carries the sifted key in
+// a hole instead of swapping at every level.
+template <class T, class Compare = std::less<T> >
+class BasicHeapSortIterative : public BasicAlgo<T, Compare>
+{
+ public:
+  BasicHeapSortIterative();
+  virtual ~BasicHeapSortIterative();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Heap Sort Iterative"; }
+ private:
+  static void SiftDown(
+    T *arr,
+    size_t size,
+    size_t index,
+    const Compare& less
+  );
+};
+
+typedef BasicHeapSortIterative<hedger::S_T> HeapSortIterative;
+
+// HeapSortBottomUp
+// Floyd's bottom-up heap sort: walk the larger-child path to a leaf with
+// one comparison per level, then climb back to where the key belongs.
+// Since a key taken from the bottom usually belongs near the bottom, this
+// roughly halves the comparisons of the standard sift-down.
+template <class T, class Compare = std::less<T> >
+class BasicHeapSortBottomUp : public BasicAlgo<T, Compare>
+{
+ public:
+  BasicHeapSortBottomUp();
+  virtual ~BasicHeapSortBottomUp();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Heap Sort Bottom-Up"; }
+ private:
+  static void SiftDown(
+    T *arr,
+    size_t size,
+    size_t index,
+    const Compare& less
+  );
+};
+
+typedef BasicHeapSortBottomUp<hedger::S_T> HeapSortBottomUp;
+
+// HeapSortDary
+// 4-ary or 8-ary heap laid out so each node's children share one aligned
+// block, keeping every level of a sift-down to a single cache line.  The
+// heap starts a few elements into the array to get that alignment; those
+// leading elements are merged in at the end.
+template <class T, class Compare = std::less<T> >
+class BasicHeapSortDary : public BasicAlgo<T, Compare>
+{
+ public:
+  BasicHeapSortDary(int arity = 8);
+  virtual ~BasicHeapSortDary();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return name_; }
+ private:
+  template <int D> static void Sort(
+    T *arr,
+    size_t size,
+    const Compare& less
+  );
+  template <int D> static void SiftDown(
+    T *arr,
+    size_t size,
+    size_t index,
+    const Compare& less
+  );
+  int arity_;
+  char name_[32];
+};
+
+typedef BasicHeapSortDary<hedger::S_T> HeapSortDary;
+}
+
+#endif // HEAP_SORT_VARIANTS_H_
@@ -0,0 +1,186 @@
+// incremental_sort.cc
+//
+// Maintains a sorted array and merges new batches of keys into it.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <memory.h>
+#include <malloc.h>
+
+#include <cstddef>
+
+#include "incremental_sort.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+
+namespace hedger {
+
+// At most this many keys per batch, binary insertion beats sort + merge.
+const size_t kSmallBatchMax = 8;
+
+// Constructor
+// Entry: algorithm used to sort each batch (nullptr == merge sort)
+IncrementalSort::IncrementalSort(Algo *batch_sorter) {
+  arr_ = nullptr;
+  size_ = capacity_ = 0;
+  batch_arr_ = nullptr;
+  batch_capacity_ = 0;
+  small_batch_max_ = kSmallBatchMax;
+  own_batch_sorter_ = (nullptr == batch_sorter);
+  batch_sorter_ = own_batch_sorter_ ? new MergeSort() : batch_sorter;
+}
+
+// Destructor
+IncrementalSort::~IncrementalSort() {
+  free(arr_);
+  free(batch_arr_);
+  if (own_batch_sorter_)
+    delete batch_sorter_;
+}
+
+// Reserve
+// Make room for at least capacity keys so later batches can be merged
+// in place.
+// Entry: capacity in elements
+// Exit:  true == success
+bool IncrementalSort::Reserve(size_t capacity)
+{
+  if (capacity <= capacity_)
+    return true;
+  hedger::S_T *arr =
+    (hedger::S_T *) realloc(arr_, capacity * sizeof(hedger::S_T));
+  if (nullptr == arr) {
+    // TODO: LOG ERROR
+    return false;
+  }
+  arr_ = arr;
+  capacity_ = capacity;
+  return true;
+}
+
+// Assign
+// Replace the contents with an already-sorted array.
+// Entry: pointer to sorted array
+//        size in elements
+// Exit:  true == success
+bool IncrementalSort::Assign(const hedger::S_T *arr, size_t size)
+{
+  if (!Reserve(size))
+    return false;
+  memcpy(arr_, arr, size * sizeof(hedger::S_T));
+  size_ = size;
+  return true;
+}
+
+// ReserveBatch
+// Grow the scratch array used to sort incoming batches.
+// Entry: batch size in elements
+// Exit:  true == success
+bool IncrementalSort::ReserveBatch(size_t batch_size)
+{
+  if (batch_size <= batch_capacity_)
+    return true;
+  free(batch_arr_);
+  batch_arr_ = (hedger::S_T *) malloc(batch_size * sizeof(hedger::S_T));
+  if (nullptr == batch_arr_) {
+    // TODO: LOG ERROR
+    batch_capacity_ = 0;
+    return false;
+  }
+  batch_capacity_ = batch_size;
+  return true;
+}
+
+// MergeForward
+// Merge the current array and a sorted batch into a separate destination,
+// left to right, as MergeSort::Merge does with its temporary array.
+// Entry: destination with room for size_ + batch_size elements
+//        pointer to sorted batch
+//        batch size in elements
+void IncrementalSort::MergeForward(
+  hedger::S_T *dest,
+  const hedger::S_T *batch,
+  size_t batch_size
+)
+{
+  size_t left = 0;
+  size_t right = 0;
+  while (left < size_ && right < batch_size) {
+    if (batch[right] < arr_[left])
+      *dest++ = batch[right++];
+    else
+      *dest++ = arr_[left++];
+  }
+  while (left < size_)
+    *dest++ = arr_[left++];
+  while (right < batch_size)
+    *dest++ = batch[right++];
+}
+
+// Insert
+// Merge a batch of unsorted keys into the sorted array.
+// Tiny batches are binary-inserted one key at a time; larger ones are
+// sorted and then merged right-to-left in place when capacity allows, or
+// merged forward into a freshly grown array when it does not.
+// Entry: pointer to batch (left untouched)
+//        batch size in elements
+// Exit:  true == success
+bool IncrementalSort::Insert(const hedger::S_T *batch, size_t batch_size)
+{
+  if (!batch_size)
+    return true;
+  if (nullptr == batch)
+    return false;
+
+  size_t new_size = size_ + batch_size;
+  if (batch_size <= small_batch_max_) {
+    if (new_size > capacity_ && !Reserve(new_size << 1))
+      return false;
+    for (size_t i = 0; i < batch_size; ++i)
+      InsertionSort::BinaryInsert(arr_, size_++, batch[i]);
+    return true;
+  }
+
+  if (!ReserveBatch(batch_size))
+    return false;
+  memcpy(batch_arr_, batch, batch_size * sizeof(hedger::S_T));
+  batch_sorter_->Test(batch_arr_, batch_size, 0);
+
+  if (new_size <= capacity_) {
+    MergeSort::MergeBackward(arr_, size_, batch_arr_, batch_size);
+  } else {
+    // Out of room: merge into a new array twice the needed size so that
+    // following batches can go in place.
+    size_t capacity = new_size << 1;
+    hedger::S_T *arr =
+      (hedger::S_T *) malloc(capacity * sizeof(hedger::S_T));
+    if (nullptr == arr) {
+      // TODO: LOG ERROR
+      return false;
+    }
+    MergeForward(arr, batch_arr_, batch_size);
+    free(arr_);
+    arr_ = arr;
+    capacity_ = capacity;
+  }
+  size_ = new_size;
+  return true;
+}
+} // namespace hedger
@@ -0,0 +1,64 @@
+// incremental_sort.h
+//
+// Maintains a sorted array and merges new batches of keys into it.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef INCREMENTAL_SORT_H_
+#define INCREMENTAL_SORT_H_
+
+#include "algo.h"
+
+namespace hedger
+{
+// IncrementalSort
+// Keeps a sorted array and accepts batches of unsorted keys.  Each batch is
+// sorted on its own and merged in, rather than re-sorting the whole array.
+class IncrementalSort
+{
+ public:
+  IncrementalSort(Algo *batch_sorter = nullptr);
+  ~IncrementalSort();
+  bool Reserve(size_t capacity);
+  bool Assign(const hedger::S_T *arr, size_t size);
+  bool Insert(const hedger::S_T *batch, size_t batch_size);
+  void Clear() { size_ = 0; }
+  const hedger::S_T *GetData() { return arr_; }
+  size_t GetSize() { return size_; }
+  size_t GetCapacity() { return capacity_; }
+  size_t GetSmallBatchMax() { return small_batch_max_; }
+  void SetSmallBatchMax(size_t small_batch_max) {
+    small_batch_max_ = small_batch_max;
+  }
+ private:
+  bool ReserveBatch(size_t batch_size);
+  void MergeForward(hedger::S_T *dest, const hedger::S_T *batch,
+    size_t batch_size);
+  hedger::S_T *arr_;            // sorted keys
+  size_t size_;                 // keys held
+  size_t capacity_;             // keys arr_ can hold
+  hedger::S_T *batch_arr_;      // scratch copy of the batch being sorted
+  size_t batch_capacity_;
+  size_t small_batch_max_;      // batches this small use binary insertion
+  Algo *batch_sorter_;
+  bool own_batch_sorter_;
+};
+}
+
+#endif // INCREMENTAL_SORT_H_
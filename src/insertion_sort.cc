@@ -21,16 +21,20 @@
 //
 
 #include <stdio.h>
+#include <memory.h>
 #include <cstddef>
 
 #include "insertion_sort.h"
+#include "sort_types.h"
 
 namespace hedger {
 
-InsertionSort::InsertionSort() {
+template <class T, class Compare>
+BasicInsertionSort<T, Compare>::BasicInsertionSort() {
 };
 
-InsertionSort::~InsertionSort() {
+template <class T, class Compare>
+BasicInsertionSort<T, Compare>::~BasicInsertionSort() {
 }
 
 // Test
@@ -39,13 +43,37 @@ InsertionSort::~InsertionSort() {
 //        size of array
 // Exit:  Result of test
 //
-int InsertionSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+template <class T, class Compare>
+int BasicInsertionSort<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
 {
   int result = 0;
-  Sort( array, 0, size - 1 );
+  if (this->instrumented_)
+    Sort<CountStats>(array, 0, size - 1);
+  else
+    Sort<NoStats>(array, 0, size - 1);
   return result;
 }
 
+// TestCounted
+// Entry: pointer to array
+//        size of array
+//        range (ignored)
+//        stats to add this call's counts to
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicInsertionSort<T, Compare>::TestCounted(
+  T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
+{
+  Sort<CountStats>(array, 0, size - 1, &stats);
+  return 0;
+}
+
 //
 // Class-specific Implementation
 //
@@ -55,30 +83,74 @@ int InsertionSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
 // Entry: pointer to array
 //        index a
 //        index b
-void InsertionSort::Swap(hedger::S_T *arr, int index_a, int index_b)
+template <class T, class Compare>
+void BasicInsertionSort<T, Compare>::Swap(T *arr, int index_a, int index_b)
 {
-  hedger::S_T swap = arr[index_a];
+  T swap = arr[index_a];
   arr[index_a] = arr[index_b];
   arr[index_b] = swap;
 }
 
+// BinaryInsert
+// Insert a single key into an already-sorted array, locating the slot by
+// binary search rather than a linear walk.  Equal keys land after existing
+// ones, so repeated insertion is stable.
+// Entry: pointer to sorted array with room for one more element
+//        number of elements currently in the array
+//        key to insert
+//        strict weak ordering
+// Exit:  index at which the key was placed
+template <class T, class Compare>
+size_t BasicInsertionSort<T, Compare>::BinaryInsert(
+  T *arr,
+  size_t size,
+  T key,
+  const Compare& less)
+{
+  size_t low = 0;
+  size_t high = size;
+  while (low < high) {
+    size_t mid = low + ((high - low) >> 1);
+    if (less(key, arr[mid]))
+      high = mid;
+    else
+      low = mid + 1;
+  }
+  memmove(&arr[low + 1], &arr[low], (size - low) * sizeof(T));
+  arr[low] = key;
+  return low;
+}
+
 // Sort
 // Entry: pointer to array
 //        start index
 //        end index
-void InsertionSort::Sort(hedger::S_T *arr, int start, int end)
+//        stats to add to (nullptr == the instance's)
+template <class T, class Compare>
+template <class Stats>
+void BasicInsertionSort<T, Compare>::Sort(
+  T *arr,
+  int start,
+  int end,
+  SortStats *sink)
 {
   if ((start < end) && nullptr != arr) {
+    SortContext<Stats, T, Compare> ctx(arr, this->less_);
     for (auto j = 1; j <= end; j++) {
-      hedger::S_T key = arr[j];
+      T key = arr[j];
       // Insert arr[j] into the sorted sequence.
       auto i = j - 1;
-      while (i >= 0 && arr[i] > key) {
+      while (i >= 0 && ctx.Less(key, arr[i])) {
         arr[i + 1] = arr[i];
+        ctx.stats.Move();
         --i;
       }
       arr[i + 1] = key;
+      ctx.stats.Move();
     }
+    this->Finish(ctx.stats, sink);
   }
 }
+
+SORT_TYPES_INSTANTIATE(BasicInsertionSort)
 } // namespace hedger
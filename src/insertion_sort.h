@@ -28,20 +28,31 @@
 
 namespace hedger
 {
-class InsertionSort : public Algo
+template <class T, class Compare = std::less<T> >
+class BasicInsertionSort : public BasicAlgo<T, Compare>
 {
  public:
-  InsertionSort();
-  ~InsertionSort();
-  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  BasicInsertionSort();
+  ~BasicInsertionSort();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
   const char *GetName() { return "Insertion Sort"; }
+  bool CanInstrument() { return true; }
+  static size_t BinaryInsert(
+    T *arr,
+    size_t size,
+    T key,
+    const Compare& less = Compare()
+  );
  protected:
-  int Partition(hedger::S_T *arr, int start, int end);
-  void Sort(hedger::S_T *arr, int start, int end);
-  void SortRecurse(hedger::S_T *arr, int start, int end);
+  template <class Stats>
+    void Sort(T *arr, int start, int end, SortStats *sink = nullptr);
  private:
-  inline void Swap(hedger::S_T *arr, int index_a, int index_b);
+  inline void Swap(T *arr, int index_a, int index_b);
 };
+
+typedef BasicInsertionSort<hedger::S_T> InsertionSort;
 }
 
 #endif // INSERTION_SORT_H_
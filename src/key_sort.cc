@@ -0,0 +1,173 @@
+// key_sort.cc
+//
+// Radix and counting sorts on the order-preserving unsigned keys of
+// key_transform.h, for 32- and 64-bit signed, unsigned and floating keys.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdint.h>
+#include <memory.h>
+
+#include <cstddef>
+
+#include "key_sort.h"
+
+namespace hedger {
+
+// Buckets per radix pass (one byte)
+const int kKeyRadix = 256;
+
+// KeyRadixScratchSize
+// Exit: arena bytes KeyRadixSort<T> takes for size keys
+template <class T> size_t KeyRadixScratchSize(size_t size)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  return 2 * Arena::Round(size * sizeof(Key)) +
+    Arena::Round(sizeof(Key) * kKeyRadix * sizeof(size_t));
+}
+
+// KeyRadixSort
+// Entry: pointer to array
+//        size in elements
+//        arena for scratch (nullptr == heap)
+//        out: digit passes made (nullptr == not wanted)
+// Exit:  0 == success
+template <class T> int KeyRadixSort(T *arr, size_t size, Arena *arena,
+  int *pass_tot)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  const int digit_tot = sizeof(Key);
+  if (nullptr != pass_tot)
+    *pass_tot = 0;
+  if (nullptr == arr || size < 2)
+    return 0;
+
+  Scratch scratch(arena);
+  Key *src = (Key *) scratch.Alloc(size * sizeof(Key));
+  Key *dst = (Key *) scratch.Alloc(size * sizeof(Key));
+  size_t *count_arr =
+    (size_t *) scratch.Alloc(digit_tot * kKeyRadix * sizeof(size_t));
+  if (nullptr == src || nullptr == dst || nullptr == count_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+
+  // Transform, counting every digit on the way through.
+  memset(count_arr, 0, digit_tot * kKeyRadix * sizeof(size_t));
+  for (size_t i = 0; i < size; ++i) {
+    Key key = KeyTraits<T>::ToKey(arr[i]);
+    src[i] = key;
+    for (int d = 0; d < digit_tot; ++d)
+      ++count_arr[d * kKeyRadix + ((key >> (d * 8)) & 0xff)];
+  }
+
+  for (int d = 0; d < digit_tot; ++d) {
+    size_t *count = &count_arr[d * kKeyRadix];
+    int shift = d * 8;
+    // Every key has the same digit here: the pass would change nothing.
+    if (size == count[(src[0] >> shift) & 0xff])
+      continue;
+    // Counts become starting offsets.
+    size_t offset = 0;
+    for (int b = 0; b < kKeyRadix; ++b) {
+      size_t bucket_tot = count[b];
+      count[b] = offset;
+      offset += bucket_tot;
+    }
+    for (size_t i = 0; i < size; ++i) {
+      Key key = src[i];
+      dst[count[(key >> shift) & 0xff]++] = key;
+    }
+    Key *swap = src;
+    src = dst;
+    dst = swap;
+    if (nullptr != pass_tot)
+      ++*pass_tot;
+  }
+
+  for (size_t i = 0; i < size; ++i)
+    arr[i] = KeyTraits<T>::FromKey(src[i]);
+  return 0;
+}
+
+// KeyCountingSort
+// Entry: pointer to array
+//        size in elements
+//        arena for scratch (nullptr == heap)
+//        most bytes the count table may take
+// Exit:  0 == success, -1 == span of keys over budget
+template <class T> int KeyCountingSort(
+  T *arr,
+  size_t size,
+  Arena *arena,
+  size_t memory_budget)
+{
+  typedef typename KeyTraits<T>::Key Key;
+  if (nullptr == arr || size < 2)
+    return 0;
+
+  Key low = KeyTraits<T>::ToKey(arr[0]);
+  Key high = low;
+  for (size_t i = 1; i < size; ++i) {
+    Key key = KeyTraits<T>::ToKey(arr[i]);
+    if (key < low)
+      low = key;
+    if (key > high)
+      high = key;
+  }
+  // Unsigned subtraction cannot overflow; the +1 can, at full width.
+  Key span = high - low;
+  if (span >= memory_budget / sizeof(size_t))
+    return -1;
+
+  Scratch scratch(arena);
+  size_t count_tot = (size_t) span + 1;
+  size_t *count_arr = (size_t *) scratch.Alloc(count_tot * sizeof(size_t));
+  if (nullptr == count_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  memset(count_arr, 0, count_tot * sizeof(size_t));
+  for (size_t i = 0; i < size; ++i)
+    ++count_arr[KeyTraits<T>::ToKey(arr[i]) - low];
+
+  T *out = arr;
+  for (size_t v = 0; v < count_tot; ++v) {
+    T value = KeyTraits<T>::FromKey((Key) (low + v));
+    for (size_t c = count_arr[v]; c; --c)
+      *out++ = value;
+  }
+  return 0;
+}
+
+// Explicit instantiations
+#define KEY_SORT_INSTANTIATE(T)                                         \
+  template int KeyRadixSort<T>(                                         \
+    T *arr, size_t size, Arena *arena, int *pass_tot);                  \
+  template size_t KeyRadixScratchSize<T>(size_t size);                  \
+  template int KeyCountingSort<T>(                                      \
+    T *arr, size_t size, Arena *arena, size_t memory_budget);
+KEY_SORT_INSTANTIATE(int32_t)
+KEY_SORT_INSTANTIATE(uint32_t)
+KEY_SORT_INSTANTIATE(int64_t)
+KEY_SORT_INSTANTIATE(uint64_t)
+KEY_SORT_INSTANTIATE(float)
+KEY_SORT_INSTANTIATE(double)
+#undef KEY_SORT_INSTANTIATE
+} // namespace hedger
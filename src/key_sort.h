@@ -0,0 +1,56 @@
+// key_sort.h
+//
+// Radix and counting sorts on the order-preserving unsigned keys of
+// key_transform.h, for 32- and 64-bit signed, unsigned and floating keys.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef KEY_SORT_H_
+#define KEY_SORT_H_
+
+#include <cstddef>
+
+#include "arena.h"
+#include "key_transform.h"
+
+namespace hedger
+{
+// Instantiated for int32_t, uint32_t, int64_t, uint64_t, float and double.
+
+// KeyRadixSort
+// LSD radix sort, one byte per pass, on KeyTraits<T> keys.  All byte
+// histograms are taken in the single pass that transforms the keys, and
+// passes whose byte is the same for every key are skipped; pass_tot, when
+// given, receives the digit passes actually made.
+template <class T> int KeyRadixSort(T *arr, size_t size, Arena *arena,
+  int *pass_tot = nullptr);
+template <class T> size_t KeyRadixScratchSize(size_t size);
+
+// KeyCountingSort
+// Counting sort over the span of KeyTraits<T> keys.  Refuses (-1) when the
+// count table would exceed memory_budget bytes.
+template <class T> int KeyCountingSort(
+  T *arr,
+  size_t size,
+  Arena *arena,
+  size_t memory_budget
+);
+}
+
+#endif // KEY_SORT_H_
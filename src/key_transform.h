@@ -0,0 +1,105 @@
+// key_transform.h
+//
+// Order-preserving maps from signed, unsigned and floating-point keys to
+// unsigned integer keys, for sorts that work on the bits of a key.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef KEY_TRANSFORM_H_
+#define KEY_TRANSFORM_H_
+
+#include <stdint.h>
+#include <memory.h>
+
+namespace hedger
+{
+// KeyTraits
+// KeyTraits<T>::ToKey(a) < KeyTraits<T>::ToKey(b) exactly when a < b, and
+// FromKey() undoes ToKey().  Key is an unsigned integer as wide as T.
+//   unsigned:  unchanged
+//   signed:    flip the sign bit, so negatives sort below positives
+//   IEEE:      flip the sign bit of positives and every bit of negatives,
+//              so larger magnitudes sort lower among negatives
+// Floating keys order -0.0 before +0.0 and NaNs beyond the infinities.
+template <class T> struct KeyTraits;
+
+template <> struct KeyTraits<uint32_t> {
+  typedef uint32_t Key;
+  static inline Key ToKey(uint32_t value) { return value; }
+  static inline uint32_t FromKey(Key key) { return key; }
+};
+
+template <> struct KeyTraits<uint64_t> {
+  typedef uint64_t Key;
+  static inline Key ToKey(uint64_t value) { return value; }
+  static inline uint64_t FromKey(Key key) { return key; }
+};
+
+template <> struct KeyTraits<int32_t> {
+  typedef uint32_t Key;
+  static inline Key ToKey(int32_t value) {
+    return (Key) value ^ 0x80000000u;
+  }
+  static inline int32_t FromKey(Key key) {
+    return (int32_t) (key ^ 0x80000000u);
+  }
+};
+
+template <> struct KeyTraits<int64_t> {
+  typedef uint64_t Key;
+  static inline Key ToKey(int64_t value) {
+    return (Key) value ^ 0x8000000000000000ull;
+  }
+  static inline int64_t FromKey(Key key) {
+    return (int64_t) (key ^ 0x8000000000000000ull);
+  }
+};
+
+template <> struct KeyTraits<float> {
+  typedef uint32_t Key;
+  static inline Key ToKey(float value) {
+    Key bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((Key) -(int32_t) (bits >> 31) | 0x80000000u);
+  }
+  static inline float FromKey(Key key) {
+    Key bits = key ^ (((key >> 31) - 1) | 0x80000000u);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+
+template <> struct KeyTraits<double> {
+  typedef uint64_t Key;
+  static inline Key ToKey(double value) {
+    Key bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((Key) -(int64_t) (bits >> 63) | 0x8000000000000000ull);
+  }
+  static inline double FromKey(Key key) {
+    Key bits = key ^ (((key >> 63) - 1) | 0x8000000000000000ull);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+};
+}
+
+#endif // KEY_TRANSFORM_H_
@@ -30,71 +30,152 @@
 #include <vector>
 
 #include "merge_sort.h"
+#include "sorting_network.h"
+#include "sort_types.h"
+#include "sort_kernels.h"
 
 namespace hedger {
 
 // Constructor
-MergeSort::MergeSort() {
+template <class T, class Compare>
+BasicMergeSort<T, Compare>::BasicMergeSort() {
 };
 
 // Destructor
-MergeSort::~MergeSort() {
+template <class T, class Compare>
+BasicMergeSort<T, Compare>::~BasicMergeSort() {
 }
 
 // Test
 // Implementation of Algo's pure virtual Test()
 // Entry: pointer to array to sort
-//        size of array in hedger::S_T units
-int MergeSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+//        size of array in elements
+template <class T, class Compare>
+int BasicMergeSort<T, Compare>::Test(T *array, size_t size, hedger::S_T range)
 {
   int result = 0;
-  Sort( array, 0, size - 1 );
+  if (this->instrumented_)
+    Sort<CountStats>(array, 0, size - 1);
+  else
+    Sort<NoStats>(array, 0, size - 1);
   return result;
 }
 
+// TestCounted
+// Entry: pointer to array
+//        size of array
+//        range (ignored)
+//        stats to add this call's counts to
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicMergeSort<T, Compare>::TestCounted(
+  T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
+{
+  Sort<CountStats>(array, 0, size - 1, &stats);
+  return 0;
+}
+
 //
 // Class-specific Implementation
 //
 
 // Merge
 // Merge two subarrays.  Typically called by the mergesort() function.
-// Entry: pointer to array
+// Entry: sort context
+//        scratch array as large as the whole array
 //        start index
 //        middle index
 //        end index
-void MergeSort::Merge(int start, int mid, int end)
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSort<T, Compare>::Merge(
+  Context<Stats>& ctx,
+  T *tmp_arr,
+  int start,
+  int mid,
+  int end)
 {
-  hedger::S_T *tmp_arr;     // pointer to temp array
+  T *arr = ctx.arr;
+
+  // Uninstrumented int merges take the dispatched vector kernel.
+  if (KernelMerge(ctx.stats, ctx.less, &arr[start], mid - start + 1,
+      &arr[mid + 1], end - mid, &tmp_arr[start])) {
+    memcpy(&arr[start], &tmp_arr[start], sizeof(T) * (end - start + 1));
+    return;
+  }
+
   int left1 = start;        // left of left-half <- start
   int right1 = mid;         // right of left-half <- mid
   int left2 = mid + 1;      // left of right-half <- mid + 1
   int right2 = end;         // right of right-half <- end
 
-  // Allocate a temporary array for swapping out and re-ordering words
-  // to be copied back to original array.
-  // NOTE: alloca is much faster but non-standard and not safe.
-  tmp_arr = (hedger::S_T *) malloc((end - start + 1) * sizeof(hedger::S_T));
-  hedger::S_T *next_tmp = tmp_arr;
+  // Merge into the same index range of the scratch array, to be copied
+  // back to the original array.  Merges in progress never overlap, so the
+  // one scratch array serves them all.
+  T *next_tmp = &tmp_arr[start];
 
   // Go through and save either left subarray or right subarray into swap array
   // according to the least at each index in the respective subarrays.
   while((left1 <= right1) && (left2 <= right2)) {
-    if(arr_[left1] < arr_[left2])
-      *next_tmp++ = arr_[left1++];    // save arr[left1]
+    if(ctx.Less(arr[left1], arr[left2]))
+      *next_tmp++ = arr[left1++];    // save arr[left1]
     else
-      *next_tmp++ = arr_[left2++];    // save arr[left2]
+      *next_tmp++ = arr[left2++];    // save arr[left2]
   }
 
   // Now, save off the rest of the data in the swap array
   // from each of the two subarrays
   while(left1 <= right1)
-    *next_tmp++ = arr_[left1++];      // save arr[left1]
+    *next_tmp++ = arr[left1++];      // save arr[left1]
   while(left2 <= right2)
-    *next_tmp++ = arr_[left2++];      // save arr[left2]
+    *next_tmp++ = arr[left2++];      // save arr[left2]
 
   // Finally, recover what we've saved, sorted, from the swap array.
-  memcpy(&arr_[start], tmp_arr, sizeof(hedger::S_T) * (end - start + 1));
-  free(tmp_arr);
+  memcpy(&arr[start], &tmp_arr[start],
+    sizeof(T) * (end - start + 1));
+  ctx.stats.Move(2 * (end - start + 1));    // into tmp_arr and back
+}
+
+// MergeBackward
+// Merge a sorted source run into a sorted array that has room for it,
+// working right-to-left so no temporary array is needed: the free slots at
+// the tail are filled first, and a destination slot is never ahead of the
+// unread part of the array.
+// Entry: pointer to sorted array with capacity >= size + src_size
+//        elements currently in the array
+//        pointer to sorted source run
+//        elements in the source run
+//        strict weak ordering
+// Exit:  arr holds size + src_size sorted elements
+template <class T, class Compare>
+void BasicMergeSort<T, Compare>::MergeBackward(
+  T *arr,
+  size_t size,
+  const T *src,
+  size_t src_size,
+  const Compare& less
+)
+{
+  size_t left = size;           // one past the next unread array element
+  size_t right = src_size;      // one past the next unread source element
+  size_t out = size + src_size; // one past the next write slot
+
+  // Take the greater of the two tails at each step; ties go to the source
+  // so that existing elements keep their place ahead of new ones.
+  while (left && right) {
+    if (less(src[right - 1], arr[left - 1]))
+      arr[--out] = arr[--left];
+    else
+      arr[--out] = src[--right];
+  }
+
+  // Whatever is left of the source belongs at the front.  Leftover array
+  // elements are already in position.
+  while (right)
+    arr[--out] = src[--right];
 }
 
 // SortRecurse
@@ -103,40 +184,67 @@ void MergeSort::Merge(int start, int mid, int end)
 // the merge function.
 // (Recursive)
 //
-// Entry: pointer to array
+// Entry: sort context
+//        scratch array as large as the whole array
 //        start index (typically 0)
 //        end index (typically end-1)
 // Exit:  -
-void MergeSort::SortRecurse(int start, int end)
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSort<T, Compare>::SortRecurse(
+  Context<Stats>& ctx,
+  T *tmp_arr,
+  int start,
+  int end)
 {
-  IncMaxRecurseDepth();
+  ctx.stats.Enter();
   int mid = 0;
-  if(start < end)
+  size_t size = end - start + 1;
+  if (start < end &&
+      !(size <= this->small_sort_max_ &&
+        SortNetwork(&ctx.arr[start], size, ctx.CountedLess())))
   {
     mid = (start + end) / 2;
     // We're going to break the data set into progressively smaller pieces,
     // merging each as we unwind.
 
-    SortRecurse(start, mid);
-    SortRecurse(mid + 1, end);
+    SortRecurse(ctx, tmp_arr, start, mid);
+    SortRecurse(ctx, tmp_arr, mid + 1, end);
 
     // On the unwind, we merge each of the subarrays, breaking each sub array
     // into two in the Merge function.  As the Sort function unwinds, the arrays
     // processed by merge get progressively larger until the final Merge,
     // leaving a perfectly sorted array.
-    Merge(start, mid, end);
+    Merge(ctx, tmp_arr, start, mid, end);
   }
-  DecMaxRecurseDepth();
+  ctx.stats.Leave();
 }
 // Sort
 // Entry: array
 //        start index
 //        end index
-void MergeSort::Sort(hedger::S_T *arr, int start, int end)
+//        stats to add to (nullptr == the instance's)
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSort<T, Compare>::Sort(
+  T *arr,
+  int start,
+  int end,
+  SortStats *sink)
 {
   if (arr && start < end) {
-    arr_ = arr;
-    SortRecurse(start, end);
+    Scratch scratch(this->arena_);
+    T *tmp_arr = (T *) scratch.Alloc((end + 1) * sizeof(T));
+    if (nullptr == tmp_arr) {
+      // TODO: LOG ERROR
+      return;
+    }
+    Context<Stats> ctx(arr, this->less_);
+    ctx.stats.Alloc();
+    SortRecurse(ctx, tmp_arr, start, end);
+    this->Finish(ctx.stats, sink);
   }
 }
+
+SORT_TYPES_INSTANTIATE(BasicMergeSort)
 } // namespace hedger
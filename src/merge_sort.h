@@ -24,21 +24,56 @@
 #define MERGE_SORT_H_
 
 #include "algo.h"
+#include "roofline.h"
 
 namespace hedger
 {
-class MergeSort : public Algo
+template <class T, class Compare = std::less<T> >
+class BasicMergeSort : public BasicAlgo<T, Compare>
 {
  public:
-  MergeSort();
-  virtual ~MergeSort();
-  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicMergeSort();
+  virtual ~BasicMergeSort();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
   const char *GetName() { return "Merge Sort"; }
+  bool CanInstrument() { return true; }
+  size_t GetScratchSize(size_t size) {
+    return Arena::Round(size * sizeof(T));
+  }
+  // Each binary level merges into the scratch and copies back, reading and
+  // writing every key twice; its working set is both arrays
+  double GetMemoryBytes(size_t size) {
+    return 4.0 * size * sizeof(T) * RooflineLevels(2 * size * sizeof(T));
+  }
+  static void MergeBackward(
+    T *arr,
+    size_t size,
+    const T *src,
+    size_t src_size,
+    const Compare& less = Compare()
+  );
  private:
-  void Merge(int start, int mid, int end);
-  void SortRecurse(int start, int end);
-  void Sort(hedger::S_T *arr, int start, int end);
+  template <class Stats> void Merge(
+    Context<Stats>& ctx,
+    T *tmp_arr,
+    int start,
+    int mid,
+    int end
+  );
+  template <class Stats> void SortRecurse(
+    Context<Stats>& ctx,
+    T *tmp_arr,
+    int start,
+    int end
+  );
+  template <class Stats>
+    void Sort(T *arr, int start, int end, SortStats *sink = nullptr);
 };
+
+typedef BasicMergeSort<hedger::S_T> MergeSort;
 }
 
 #endif // MERGE_SORT_H_
@@ -0,0 +1,709 @@
+// merge_sort_cache.cc
+//
+// Merge sorts that limit memory traffic: a cache-aware tiled merge sort
+// sized from the detected caches, and a cache-oblivious lazy funnelsort.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <memory.h>
+
+#include <cstddef>
+#include <algorithm>
+
+#include "merge_sort_cache.h"
+#include "cache_info.h"
+#include "roofline.h"
+#include "sorting_network.h"
+#include "sort_types.h"
+#include "sort_kernels.h"
+
+namespace hedger {
+
+// Runs this short are insertion sorted before a tile's merges start
+const size_t kTiledRunMin = 16;
+// Smallest tile, for caches too small to be worth tiling
+const size_t kTiledTileMin = 1024;
+// Ranges this small end the funnelsort recursion
+const size_t kFunnelBaseMax = 32;
+
+//
+// MergeTraffic
+//
+
+// Add
+// Entry: level (clamped to kMergeLevelMax - 1)
+//        length of the runs produced
+//        key array bytes read plus written
+//        bytes moved inside cache-sized blocks
+void MergeTraffic::Add(
+  int level,
+  size_t run_size,
+  unsigned long long stream_bytes,
+  unsigned long long local_bytes)
+{
+  if (level < 0)
+    level = 0;
+  if (level >= kMergeLevelMax)
+    level = kMergeLevelMax - 1;
+  MergeLevel& entry = level_arr_[level];
+  __sync_fetch_and_add(&entry.stream_bytes, stream_bytes);
+  __sync_fetch_and_add(&entry.local_bytes, local_bytes);
+  unsigned long long run_max;
+  while ((run_max = entry.run_max) < run_size &&
+    !__sync_bool_compare_and_swap(&entry.run_max, run_max,
+      (unsigned long long) run_size));
+  int level_tot;
+  while ((level_tot = level_tot_) <= level &&
+    !__sync_bool_compare_and_swap(&level_tot_, level_tot, level + 1));
+}
+
+//
+// MergeSortTiled
+//
+
+// Constructor
+// Size the tiles and the merge fan-in from the cache hierarchy.
+template <class T, class Compare>
+BasicMergeSortTiled<T, Compare>::BasicMergeSortTiled() {
+  CacheInfo& cache = CacheInfo::Get();
+  // A tile and its half of the scratch take half of L2, leaving the rest
+  // to the other core's traffic, the stack and the page tables.
+  tile_size_ = std::max(kTiledTileMin, cache.GetL2() / 4 / sizeof(T));
+  // Each input of a multiway merge keeps a line in flight, alongside a
+  // line of output; the loser tree is small beside them.
+  fan_in_ = cache.GetL1() / (2 * cache.GetLineSize());
+  fan_in_ = std::max((size_t) 2, std::min(kTiledFanInMax, fan_in_));
+}
+
+// Destructor
+template <class T, class Compare>
+BasicMergeSortTiled<T, Compare>::~BasicMergeSortTiled() {
+}
+
+// Test
+// Implementation of Algo's pure virtual Test()
+// Entry: pointer to array to sort
+//        size of array in elements
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicMergeSortTiled<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+  Scratch scratch(this->arena_);
+  T *tmp_arr = (T *) scratch.Alloc(size * sizeof(T));
+  if (nullptr == tmp_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  if (this->instrumented_) {
+    Context<CountStats> ctx(array, this->less_);
+    ctx.stats.Alloc();
+    Sort(ctx, tmp_arr, size);
+    this->Finish(ctx.stats);
+  } else {
+    Context<NoStats> ctx(array, this->less_);
+    Sort(ctx, tmp_arr, size);
+  }
+  return 0;
+}
+
+//
+// Class-specific Implementation
+//
+
+// Sort
+// Sort every tile, then merge fan_in_ runs at a time, alternating between
+// the array and the scratch.  The tiles are left in whichever buffer makes
+// the last pass land in the array, so nothing is copied back.
+// Entry: sort context
+//        scratch array as large as the whole array
+//        size of array in elements
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSortTiled<T, Compare>::Sort(
+  Context<Stats>& ctx,
+  T *tmp_arr,
+  size_t size)
+{
+  T *arr = ctx.arr;
+  int pass_tot = GetPassTot(size);
+  bool into_tmp = pass_tot & 1;
+  unsigned long long stream_bytes = 2ULL * size * sizeof(T);
+
+  unsigned long long local_bytes = 0;
+  for (size_t start = 0; start < size; start += tile_size_) {
+    size_t tile_size = std::min(tile_size_, size - start);
+    SortTile(ctx, &arr[start], &tmp_arr[start], tile_size, into_tmp);
+    // Every in-tile merge level reads and writes the tile once.
+    size_t width = kTiledRunMin;
+    int copy_tot = 0;
+    for (; width < tile_size; width <<= 1)
+      ++copy_tot;
+    if ((copy_tot & 1) != into_tmp)
+      ++copy_tot;
+    local_bytes += 2ULL * copy_tot * tile_size * sizeof(T);
+  }
+  if (this->instrumented_)
+    traffic_.Add(0, std::min(tile_size_, size), stream_bytes, local_bytes);
+
+  T *src = into_tmp ? tmp_arr : arr;
+  T *dst = into_tmp ? arr : tmp_arr;
+  size_t run_size = tile_size_;
+  for (int pass = 1; pass <= pass_tot; ++pass) {
+    MultiwayMerge(ctx, src, dst, run_size, size);
+    run_size = run_size * fan_in_ < size ? run_size * fan_in_ : size;
+    if (this->instrumented_)
+      traffic_.Add(pass, run_size, stream_bytes, 0);
+    std::swap(src, dst);
+  }
+}
+
+// GetPassTot
+// Entry: size of array in elements
+// Exit:  multiway merge passes after the tiles are sorted
+template <class T, class Compare>
+int BasicMergeSortTiled<T, Compare>::GetPassTot(size_t size)
+{
+  size_t tile_tot = (size + tile_size_ - 1) / tile_size_;
+  int pass_tot = 0;
+  for (size_t run_tot = tile_tot; run_tot > 1;
+       run_tot = (run_tot + fan_in_ - 1) / fan_in_)
+    ++pass_tot;
+  return pass_tot;
+}
+
+// GetMemoryBytes
+// The tile pass and every merge pass each read and write the array once,
+// when the array and scratch outgrow the last-level cache.
+// Entry: size of array in elements
+// Exit:  bytes
+template <class T, class Compare>
+double BasicMergeSortTiled<T, Compare>::GetMemoryBytes(size_t size)
+{
+  if (!RooflineBeyondCache(2 * size * sizeof(T)))
+    return 0.0;
+  return 2.0 * size * sizeof(T) * (1 + GetPassTot(size));
+}
+
+// SortTile
+// Sort a tile with bottom-up binary merges between it and its part of the
+// scratch; both stay in L2 throughout.
+// Entry: sort context
+//        pointer to tile
+//        pointer to the tile's part of the scratch
+//        size of tile in elements
+//        true == leave the sorted tile in the scratch
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSortTiled<T, Compare>::SortTile(
+  Context<Stats>& ctx,
+  T *arr,
+  T *tmp_arr,
+  size_t size,
+  bool into_tmp)
+{
+  ctx.stats.Enter();
+  for (size_t start = 0; start < size; start += kTiledRunMin) {
+    size_t run = std::min(kTiledRunMin, size - start);
+    T *base = &arr[start];
+    if (run <= this->small_sort_max_ && SortNetwork(base, run, ctx.CountedLess()))
+      continue;
+    for (size_t i = 1; i < run; ++i) {
+      T key = base[i];
+      size_t j = i;
+      while (j && ctx.Less(key, base[j - 1])) {
+        base[j] = base[j - 1];
+        ctx.stats.Move();
+        --j;
+      }
+      base[j] = key;
+      ctx.stats.Move(2);
+    }
+  }
+
+  T *src = arr;
+  T *dst = tmp_arr;
+  for (size_t width = kTiledRunMin; width < size; width <<= 1) {
+    for (size_t start = 0; start < size; start += 2 * width) {
+      size_t mid = std::min(start + width, size);
+      size_t end = std::min(start + 2 * width, size);
+      Merge(ctx, &src[start], mid - start, &src[mid], end - mid,
+        &dst[start]);
+    }
+    std::swap(src, dst);
+  }
+  T *target = into_tmp ? tmp_arr : arr;
+  if (src != target) {
+    memcpy(target, src, size * sizeof(T));
+    ctx.stats.Move(size);
+  }
+  ctx.stats.Leave();
+}
+
+// Merge
+// Stable merge of two adjacent sorted runs into out.
+// Entry: sort context
+//        left run and its size
+//        right run and its size
+//        output, room for both
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSortTiled<T, Compare>::Merge(
+  Context<Stats>& ctx,
+  const T *a,
+  size_t a_size,
+  const T *b,
+  size_t b_size,
+  T *out)
+{
+  if (!b_size) {
+    memcpy(out, a, a_size * sizeof(T));
+    ctx.stats.Move(a_size);
+    return;
+  }
+  // Uninstrumented int merges take the dispatched vector kernel.
+  if (KernelMerge(ctx.stats, ctx.less, a, a_size, b, b_size, out))
+    return;
+  const T *a_end = a + a_size;
+  const T *b_end = b + b_size;
+  while (a < a_end && b < b_end) {
+    if (ctx.Less(*b, *a))
+      *out++ = *b++;
+    else
+      *out++ = *a++;
+  }
+  while (a < a_end)
+    *out++ = *a++;
+  while (b < b_end)
+    *out++ = *b++;
+  ctx.stats.Move(a_size + b_size);
+}
+
+// MultiwayMerge
+// One pass: merge each group of fan_in_ consecutive runs of src into dst
+// through a loser tree.  An exhausted run loses to everything and equal
+// keys go to the lower run, so the merge is stable.
+// Entry: sort context
+//        source, holding sorted runs of run_size (the last may be short)
+//        destination, as large as the source
+//        run size in elements
+//        size of array in elements
+template <class T, class Compare>
+template <class Stats>
+void BasicMergeSortTiled<T, Compare>::MultiwayMerge(
+  Context<Stats>& ctx,
+  const T *src,
+  T *dst,
+  size_t run_size,
+  size_t size)
+{
+  const T *cur[kTiledFanInMax];
+  const T *lim[kTiledFanInMax];
+  size_t tree[kTiledFanInMax];          // loser at each node, winner at 0
+  size_t win[2 * kTiledFanInMax];       // winners while building
+
+  // Does run a's head go out before run b's?
+  auto beats = [&](size_t a, size_t b) -> bool {
+    if (cur[a] == lim[a])
+      return false;
+    if (cur[b] == lim[b])
+      return true;
+    return a < b ? !ctx.Less(*cur[b], *cur[a]) : ctx.Less(*cur[a], *cur[b]);
+  };
+
+  size_t group_size = run_size * fan_in_;
+  for (size_t start = 0; start < size; start += group_size) {
+    size_t end = std::min(start + group_size, size);
+    size_t run_tot = (end - start + run_size - 1) / run_size;
+    if (1 == run_tot) {
+      memcpy(&dst[start], &src[start], (end - start) * sizeof(T));
+      ctx.stats.Move(end - start);
+      continue;
+    }
+    size_t leaf_tot = 1;
+    while (leaf_tot < run_tot)
+      leaf_tot <<= 1;
+    for (size_t i = 0; i < leaf_tot; ++i) {
+      size_t run_start = std::min(start + i * run_size, end);
+      cur[i] = &src[run_start];
+      lim[i] = &src[std::min(run_start + run_size, end)];
+      win[leaf_tot + i] = i;
+    }
+    for (size_t node = leaf_tot - 1; node; --node) {
+      size_t left = win[2 * node];
+      size_t right = win[2 * node + 1];
+      if (beats(left, right)) {
+        win[node] = left;
+        tree[node] = right;
+      } else {
+        win[node] = right;
+        tree[node] = left;
+      }
+    }
+    size_t winner = win[1];
+
+    // Emit the winner, then replay its path against the stored losers.
+    for (size_t out = start; out < end; ++out) {
+      dst[out] = *cur[winner]++;
+      for (size_t node = (winner + leaf_tot) >> 1; node; node >>= 1) {
+        if (beats(tree[node], winner))
+          std::swap(tree[node], winner);
+      }
+    }
+    ctx.stats.Move(end - start);
+  }
+}
+
+//
+// FunnelSort
+//
+
+// Funnel
+// The node array and buffer space of the funnel being merged.  Only one
+// funnel is live at a time (segments are sorted before their parent's
+// funnel is built), so the largest one's space serves the whole sort.
+template <class T, class Compare>
+struct BasicFunnelSort<T, Compare>::Funnel {
+  FunnelNode<T> *node_arr;      // heap order, root at 1
+  T *buf_arr;
+  unsigned long long local_bytes;
+};
+
+// FunnelSplit
+// Entry: elements to sort (> kFunnelBaseMax)
+//        out: segment count k, about size^(1/3), at least 2
+//        out: elements per segment (the last may be short)
+static void FunnelSplit(size_t size, size_t& seg_tot, size_t& seg_size)
+{
+  seg_tot = std::max((size_t) 2, (size_t) ceil(cbrt((double) size)));
+  seg_size = (size + seg_tot - 1) / seg_tot;
+  seg_tot = (size + seg_size - 1) / seg_size;
+}
+
+// FunnelHeight
+// Entry: leaves
+// Exit:  height of the smallest complete binary tree with that many
+static int FunnelHeight(size_t leaf_tot)
+{
+  int height = 0;
+  while (((size_t) 1 << height) < leaf_tot)
+    ++height;
+  return height;
+}
+
+// FunnelDepth
+// Entry: elements to sort
+// Exit:  funnel levels above the base case
+static int FunnelDepth(size_t size)
+{
+  int depth = 0;
+  while (size > kFunnelBaseMax) {
+    size_t seg_tot, seg_size;
+    FunnelSplit(size, seg_tot, seg_size);
+    size = seg_size;
+    ++depth;
+  }
+  return depth;
+}
+
+// FunnelLayout
+// Give the buffers below node, whose subtree has the given height, their
+// sizes and places.  The tree is split at half its height; the buffers at
+// the roots of the bottom trees hold k^(3/2) elements, k = 2^height being
+// the leaves of the tree split, and are laid out after the top tree, each
+// just ahead of its own bottom tree (van Emde Boas order).
+// Entry: node array (nullptr == only count)
+//        subtree root
+//        subtree height
+//        in/out: elements of buffer space used
+//        buffer space
+template <class T>
+static void FunnelLayout(
+  FunnelNode<T> *node_arr,
+  size_t node,
+  int height,
+  size_t& offset,
+  T *buf_arr)
+{
+  if (height <= 1)
+    return;
+  int bottom = height / 2;
+  int top = height - bottom;
+  size_t cap = (size_t) ceil(pow(2.0, 1.5 * height));
+  FunnelLayout(node_arr, node, top, offset, buf_arr);
+  for (size_t root = node << top; root < (node + 1) << top; ++root) {
+    if (node_arr) {
+      node_arr[root].buf = &buf_arr[offset];
+      node_arr[root].cap = cap;
+    }
+    offset += cap;
+    FunnelLayout(node_arr, root, bottom, offset, buf_arr);
+  }
+}
+
+// Constructor
+template <class T, class Compare>
+BasicFunnelSort<T, Compare>::BasicFunnelSort() {
+}
+
+// Destructor
+template <class T, class Compare>
+BasicFunnelSort<T, Compare>::~BasicFunnelSort() {
+}
+
+// GetScratchSize
+// The output array, plus the top-level funnel, which is the largest.
+// Entry: size of array in elements
+// Exit:  arena bytes
+template <class T, class Compare>
+size_t BasicFunnelSort<T, Compare>::GetScratchSize(size_t size)
+{
+  size_t bytes = Arena::Round(size * sizeof(T));
+  if (size <= kFunnelBaseMax)
+    return bytes;
+  size_t seg_tot, seg_size, buf_tot = 0;
+  FunnelSplit(size, seg_tot, seg_size);
+  int height = FunnelHeight(seg_tot);
+  FunnelLayout<T>(nullptr, 1, height, buf_tot, nullptr);
+  return bytes + Arena::Round(buf_tot * sizeof(T)) +
+    Arena::Round(((size_t) 2 << height) * sizeof(FunnelNode<T>));
+}
+
+// GetMemoryBytes
+// Every funnel level whose output and input runs outgrow the last-level
+// cache reads and writes the array once.
+// Entry: size of array in elements
+// Exit:  bytes
+template <class T, class Compare>
+double BasicFunnelSort<T, Compare>::GetMemoryBytes(size_t size)
+{
+  int level_tot = 0;
+  for (size_t seg = size; seg > kFunnelBaseMax &&
+       RooflineBeyondCache(2 * seg * sizeof(T)); ++level_tot) {
+    size_t seg_tot, seg_size;
+    FunnelSplit(seg, seg_tot, seg_size);
+    seg = seg_size;
+  }
+  return 2.0 * size * sizeof(T) * level_tot;
+}
+
+// Test
+// Implementation of Algo's pure virtual Test()
+// Entry: pointer to array to sort
+//        size of array in elements
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicFunnelSort<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+  Scratch scratch(this->arena_);
+  T *tmp_arr = (T *) scratch.Alloc(size * sizeof(T));
+  Funnel funnel;
+  funnel.node_arr = nullptr;
+  funnel.buf_arr = nullptr;
+  if (size > kFunnelBaseMax) {
+    size_t seg_tot, seg_size, buf_tot = 0;
+    FunnelSplit(size, seg_tot, seg_size);
+    int height = FunnelHeight(seg_tot);
+    FunnelLayout<T>(nullptr, 1, height, buf_tot, nullptr);
+    funnel.buf_arr = (T *) scratch.Alloc(buf_tot * sizeof(T));
+    funnel.node_arr = (FunnelNode<T> *)
+      scratch.Alloc(((size_t) 2 << height) * sizeof(FunnelNode<T>));
+    if (nullptr == funnel.buf_arr || nullptr == funnel.node_arr)
+      tmp_arr = nullptr;
+  }
+  if (nullptr == tmp_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  int depth = FunnelDepth(size);
+  if (this->instrumented_) {
+    Context<CountStats> ctx(array, this->less_);
+    ctx.stats.Alloc();
+    SortRecurse(ctx, funnel, array, tmp_arr, size, false, depth);
+    this->Finish(ctx.stats);
+  } else {
+    Context<NoStats> ctx(array, this->less_);
+    SortRecurse(ctx, funnel, array, tmp_arr, size, false, depth);
+  }
+  return 0;
+}
+
+// SortRecurse
+// Sort the segments into the other buffer, then funnel them back.
+// Entry: sort context
+//        funnel space
+//        range to sort
+//        the range's part of the scratch
+//        size in elements
+//        true == leave the result in the scratch
+//        traffic level of this call's merge
+template <class T, class Compare>
+template <class Stats>
+void BasicFunnelSort<T, Compare>::SortRecurse(
+  Context<Stats>& ctx,
+  Funnel& funnel,
+  T *arr,
+  T *tmp_arr,
+  size_t size,
+  bool into_tmp,
+  int level)
+{
+  if (size <= kFunnelBaseMax) {
+    InsertionSort(ctx, arr, size);
+    if (into_tmp) {
+      memcpy(tmp_arr, arr, size * sizeof(T));
+      ctx.stats.Move(size);
+    }
+    if (this->instrumented_)
+      traffic_.Add(0, size, (into_tmp ? 4ULL : 2ULL) * size * sizeof(T), 0);
+    return;
+  }
+  ctx.stats.Enter();
+  size_t seg_tot, seg_size;
+  FunnelSplit(size, seg_tot, seg_size);
+  for (size_t start = 0; start < size; start += seg_size) {
+    SortRecurse(ctx, funnel, &arr[start], &tmp_arr[start],
+      std::min(seg_size, size - start), !into_tmp, level - 1);
+  }
+  T *src = into_tmp ? arr : tmp_arr;
+  T *dst = into_tmp ? tmp_arr : arr;
+
+  // Build the funnel: the root writes straight to the output, and the
+  // leaves are the sorted segments.
+  int height = FunnelHeight(seg_tot);
+  size_t leaf_tot = (size_t) 1 << height;
+  FunnelNode<T> *node_arr = funnel.node_arr;
+  size_t offset = 0;
+  FunnelLayout(node_arr, 1, height, offset, funnel.buf_arr);
+  for (size_t node = 1; node < leaf_tot; ++node) {
+    node_arr[node].head = node_arr[node].tail = 0;
+    node_arr[node].done = false;
+  }
+  node_arr[1].buf = dst;
+  node_arr[1].cap = size;
+  for (size_t i = 0; i < leaf_tot; ++i) {
+    FunnelNode<T>& leaf = node_arr[leaf_tot + i];
+    size_t start = std::min(i * seg_size, size);
+    leaf.buf = &src[start];
+    leaf.head = 0;
+    leaf.tail = leaf.cap = std::min(seg_size, size - start);
+    leaf.done = true;
+  }
+  funnel.local_bytes = 0;
+  Fill(ctx, funnel, 1);
+  if (this->instrumented_)
+    traffic_.Add(level, size, 2ULL * size * sizeof(T), funnel.local_bytes);
+  ctx.stats.Leave();
+}
+
+// Fill
+// Refill an empty node's buffer by merging its children, refilling each
+// child (recursively) whenever it runs dry.  A node whose children are
+// both drained and done is done.  Ties go to the left child, which holds
+// the earlier segment, so the funnel is stable.
+// Entry: sort context
+//        funnel space
+//        node to fill (an internal node; its buffer is empty)
+template <class T, class Compare>
+template <class Stats>
+void BasicFunnelSort<T, Compare>::Fill(
+  Context<Stats>& ctx,
+  Funnel& funnel,
+  size_t node)
+{
+  FunnelNode<T>& out = funnel.node_arr[node];
+  FunnelNode<T>& left = funnel.node_arr[2 * node];
+  FunnelNode<T>& right = funnel.node_arr[2 * node + 1];
+  size_t tail = 0;
+  out.head = 0;
+  while (tail < out.cap) {
+    if (left.head == left.tail && !left.done)
+      Fill(ctx, funnel, 2 * node);
+    if (right.head == right.tail && !right.done)
+      Fill(ctx, funnel, 2 * node + 1);
+    bool left_more = left.head < left.tail;
+    bool right_more = right.head < right.tail;
+    if (!left_more && !right_more) {
+      out.done = true;
+      break;
+    }
+    if (!left_more || !right_more) {
+      // One side is exhausted for good: copy what the other holds.
+      FunnelNode<T>& only = left_more ? left : right;
+      size_t n = std::min(out.cap - tail, only.tail - only.head);
+      memcpy(&out.buf[tail], &only.buf[only.head], n * sizeof(T));
+      tail += n;
+      only.head += n;
+      continue;
+    }
+    while (tail < out.cap && left.head < left.tail &&
+           right.head < right.tail) {
+      if (ctx.Less(right.buf[right.head], left.buf[left.head]))
+        out.buf[tail++] = right.buf[right.head++];
+      else
+        out.buf[tail++] = left.buf[left.head++];
+    }
+  }
+  out.tail = tail;
+  ctx.stats.Move(tail);
+  if (node > 1)
+    funnel.local_bytes += 2ULL * tail * sizeof(T);
+}
+
+// InsertionSort
+// Base case of the recursion.
+// Entry: sort context
+//        pointer to range
+//        size of range in elements
+template <class T, class Compare>
+template <class Stats>
+void BasicFunnelSort<T, Compare>::InsertionSort(
+  Context<Stats>& ctx,
+  T *arr,
+  size_t size)
+{
+  if (size <= this->small_sort_max_ && SortNetwork(arr, size, ctx.CountedLess()))
+    return;
+  for (size_t i = 1; i < size; ++i) {
+    T key = arr[i];
+    size_t j = i;
+    while (j && ctx.Less(key, arr[j - 1])) {
+      arr[j] = arr[j - 1];
+      ctx.stats.Move();
+      --j;
+    }
+    arr[j] = key;
+    ctx.stats.Move(2);
+  }
+}
+
+SORT_TYPES_INSTANTIATE(BasicMergeSortTiled)
+SORT_TYPES_INSTANTIATE(BasicFunnelSort)
+} // namespace hedger
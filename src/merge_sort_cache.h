@@ -0,0 +1,191 @@
+// merge_sort_cache.h
+//
+// Merge sorts that limit memory traffic: a cache-aware tiled merge sort
+// sized from the detected caches, and a cache-oblivious lazy funnelsort.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef MERGE_SORT_CACHE_H_
+#define MERGE_SORT_CACHE_H_
+
+#include "algo.h"
+
+namespace hedger
+{
+// Deepest level MergeTraffic records
+const int kMergeLevelMax = 32;
+// Widest multiway merge of the tiled sort (loser tree leaves)
+const size_t kTiledFanInMax = 256;
+
+// MergeLevel
+// Traffic of one level of a merge sort: level 0 is the first pass over
+// the keys (the one producing the shortest sorted runs), the last level
+// produces the whole sorted array.
+struct MergeLevel {
+  unsigned long long run_max;       // longest run the level produced
+  unsigned long long stream_bytes;  // key array bytes read plus written
+  unsigned long long local_bytes;   // bytes moved inside cache-sized blocks
+};
+
+// MergeTraffic
+// Per-level byte counts, summed over every instrumented call.  Stream bytes
+// are those a level moves through the array-sized buffers (memory once the
+// array outgrows the cache); local bytes are moves confined to a tile or a
+// funnel buffer, meant to stay in cache.
+class MergeTraffic {
+ public:
+  MergeTraffic() { Reset(); }
+  void Reset() {
+    level_tot_ = 0;
+    for (int i = 0; i < kMergeLevelMax; ++i)
+      level_arr_[i].run_max = level_arr_[i].stream_bytes =
+        level_arr_[i].local_bytes = 0;
+  }
+  void Add(int level, size_t run_size, unsigned long long stream_bytes,
+    unsigned long long local_bytes);
+  int GetLevelTot() const { return level_tot_; }
+  const MergeLevel& GetLevel(int level) const { return level_arr_[level]; }
+ private:
+  int level_tot_;
+  MergeLevel level_arr_[kMergeLevelMax];
+};
+
+// MergeSortTiled
+// Cache-aware merge sort.  The array is cut into tiles small enough that a
+// tile and its scratch share the L2 cache; each tile is sorted there,
+// from insertion-sorted (or network-sorted) runs up, so its merge levels
+// never reach memory.  The sorted tiles are then combined by multiway
+// merges whose fan-in keeps one cache line per input, and the loser tree,
+// in L1, so the whole array is streamed once per ceil(log_fanin(tiles))
+// passes instead of once per binary level.  The merges are stable.
+template <class T, class Compare = std::less<T> >
+class BasicMergeSortTiled : public BasicAlgo<T, Compare>
+{
+ public:
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicMergeSortTiled();
+  virtual ~BasicMergeSortTiled();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Merge Sort (cache tiled)"; }
+  bool CanInstrument() { return true; }
+  size_t GetScratchSize(size_t size) {
+    return Arena::Round(size * sizeof(T));
+  }
+  double GetMemoryBytes(size_t size);
+  size_t GetTileSize() { return tile_size_; }   // elements
+  size_t GetFanIn() { return fan_in_; }
+  // Per-level traffic of the instrumented calls since ResetTraffic()
+  const MergeTraffic& GetTraffic() { return traffic_; }
+  void ResetTraffic() { traffic_.Reset(); }
+ private:
+  template <class Stats> void Sort(Context<Stats>& ctx, T *tmp_arr,
+    size_t size);
+  template <class Stats> void SortTile(
+    Context<Stats>& ctx,
+    T *arr,
+    T *tmp_arr,
+    size_t size,
+    bool into_tmp
+  );
+  template <class Stats> void Merge(
+    Context<Stats>& ctx,
+    const T *a,
+    size_t a_size,
+    const T *b,
+    size_t b_size,
+    T *out
+  );
+  template <class Stats> void MultiwayMerge(
+    Context<Stats>& ctx,
+    const T *src,
+    T *dst,
+    size_t run_size,
+    size_t size
+  );
+  int GetPassTot(size_t size);
+  // Member variables
+  size_t tile_size_;
+  size_t fan_in_;
+  MergeTraffic traffic_;
+};
+
+typedef BasicMergeSortTiled<hedger::S_T> MergeSortTiled;
+
+// FunnelNode
+// One merger of a funnel.  Internal nodes own a buffer they refill, only
+// when their parent has drained it, by merging their two children; leaves
+// are the sorted input runs and are never refilled.
+template <class T> struct FunnelNode {
+  T *buf;
+  size_t cap;
+  size_t head;                  // next element to read
+  size_t tail;                  // one past the last element held
+  bool done;                    // nothing further will arrive
+};
+
+// FunnelSort
+// Cache-oblivious lazy funnelsort (Frigo et al., Brodal and Fagerberg).
+// The array is cut into k = n^(1/3) segments, each funnelsorted
+// recursively, and the segments are merged by a k-funnel: a binary tree of
+// mergers whose buffers are sized by the recursive van Emde Boas split of
+// the tree (k^(3/2) at the middle of a k-merger) and laid out in that
+// order, so any subtree that fits a cache, whatever its size, is merged
+// without leaving it.  No cache size is consulted; compare its traffic
+// with MergeSortTiled's.
+template <class T, class Compare = std::less<T> >
+class BasicFunnelSort : public BasicAlgo<T, Compare>
+{
+ public:
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicFunnelSort();
+  virtual ~BasicFunnelSort();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Funnelsort"; }
+  bool CanInstrument() { return true; }
+  size_t GetScratchSize(size_t size);
+  double GetMemoryBytes(size_t size);
+  // Per-level traffic of the instrumented calls since ResetTraffic()
+  const MergeTraffic& GetTraffic() { return traffic_; }
+  void ResetTraffic() { traffic_.Reset(); }
+ private:
+  struct Funnel;
+  template <class Stats> void SortRecurse(
+    Context<Stats>& ctx,
+    Funnel& funnel,
+    T *arr,
+    T *tmp_arr,
+    size_t size,
+    bool into_tmp,
+    int level
+  );
+  template <class Stats> void Fill(
+    Context<Stats>& ctx,
+    Funnel& funnel,
+    size_t node
+  );
+  template <class Stats>
+    void InsertionSort(Context<Stats>& ctx, T *arr, size_t size);
+  // Member variables
+  MergeTraffic traffic_;
+};
+
+typedef BasicFunnelSort<hedger::S_T> FunnelSort;
+}
+
+#endif // MERGE_SORT_CACHE_H_
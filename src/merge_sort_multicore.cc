@@ -31,42 +31,42 @@
 
 #include <cstddef>
 #include <thread>
+#include <algorithm>
 
 #include "merge_sort_multicore.h"
+#include "numa_util.h"
+#include "sorting_network.h"
+#include "sort_types.h"
+#include "sort_kernels.h"
+#include "trace.h"
 namespace hedger {
 
-// Static variable definitions
-volatile int MergeSortMultiCore::thread_tot_ = 0;
-int MergeSortMultiCore::kThreadMax = 8;
-Lock *MergeSortMultiCore::merge_lock_;
-
 // Constructor
-MergeSortMultiCore::MergeSortMultiCore() {
-  // Get and set # of cores
-  MergeSortMultiCore::kThreadMax = std::thread::hardware_concurrency();
-
-  if (!MergeSortMultiCore::kThreadMax) {
+// Defaults to every core; SetThreadMax() overrides.
+template <class T, class Compare>
+BasicMergeSortMultiCore<T, Compare>::BasicMergeSortMultiCore() {
+  thread_max_ = std::thread::hardware_concurrency();
+  if (thread_max_ < 1) {
     // If unable to detect, singlethreaded
-    MergeSortMultiCore::kThreadMax = 1;
-  } else {
-    if (MergeSortMultiCore::kThreadMax > 2) {
-      printf("Detected %d cores.\n", MergeSortMultiCore::kThreadMax);
-      MergeSortMultiCore::kThreadMax -= 2;
-    }
+    thread_max_ = 1;
   }
-  printf("Using %d cores.\n", MergeSortMultiCore::kThreadMax);
-
+  numa_aware_ = false;
 };
 
 // Destructor
-MergeSortMultiCore::~MergeSortMultiCore() {
+template <class T, class Compare>
+BasicMergeSortMultiCore<T, Compare>::~BasicMergeSortMultiCore() {
 }
 
 // Test
 // Implementation of Algo's pure virtual Test()
 // Entry: pointer to array to sort
-//        size of array in hedger::S_T units
-int MergeSortMultiCore::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+//        size of array in elements
+template <class T, class Compare>
+int BasicMergeSortMultiCore<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
 {
   int result = 0;
 
@@ -75,71 +75,143 @@ int MergeSortMultiCore::Test(hedger::S_T *array, size_t size, hedger::S_T range)
   return result;
 }
 
+// SetArena
+// Entry: arena for the scratch array (nullptr == heap)
+template <class T, class Compare>
+void BasicMergeSortMultiCore<T, Compare>::SetArena(Arena *arena)
+{
+  this->arena_ = arena;
+  PlaceScratch();
+}
+
 //
 // Class-specific Implementation
 //
 
+// SetNumaAware
+// Entry: true == pin threads and place the scratch by chunk
+template <class T, class Compare>
+void BasicMergeSortMultiCore<T, Compare>::SetNumaAware(bool numa_aware)
+{
+  numa_aware_ = numa_aware;
+  PlaceScratch();
+}
+
+// PlaceScratch
+// Bind the arena's free space by chunk, as NumaChunkNode() splits the
+// array, so Sort() finds its scratch in place without an mbind of its own.
+// The arena should be sized from GetScratchSize(); the binding is not
+// undone when NUMA awareness is turned off.
+template <class T, class Compare>
+void BasicMergeSortMultiCore<T, Compare>::PlaceScratch()
+{
+  if (numa_aware_ && this->arena_ && this->arena_->GetFreeBytes())
+    NumaBindChunks(this->arena_->GetFree(), this->arena_->GetFreeBytes());
+}
+
 // Sort
 // Entry point for sort start.
-// Sets up our local pool so we aren't constantly allocating from heap
+// Sets up the context shared by this sort's threads
 // Entry: pointer to array
 //        size of array in elements
-void MergeSortMultiCore::Sort(hedger::S_T *arr, int size)
+template <class T, class Compare>
+void BasicMergeSortMultiCore<T, Compare>::Sort(T *arr, int size)
 {
   if (arr && size)
   {
-    arr_ = arr;
-    MergeSortMultiParams params;
-    params.arr =        arr;
-    params.start =      0;
-    params.end =        size - 1;
-    params.merge_sort = this;
-    SortRecurse((void *)&params);
+    Scratch scratch(this->arena_);
+    MergeSortMultiContext<T, Compare> ctx;
+    ctx.arr =             arr;
+    ctx.tmp_arr =         (T *) scratch.Alloc(size * sizeof(T));
+    if (nullptr == ctx.tmp_arr) {
+      // TODO: LOG ERROR
+      return;
+    }
+    ctx.size =            size;
+    ctx.numa_aware =      numa_aware_;
+    ctx.thread_max =      thread_max_;
+    ctx.small_sort_max =  this->small_sort_max_;
+    ctx.trace_merge_min = std::max((size_t) 2, ctx.size /
+      (2 * (size_t) thread_max_));
+    ctx.less =            this->less_;
+    MergeSortMultiParams<T, Compare> params;
+    params.ctx =          &ctx;
+    params.start =        0;
+    params.end =          size - 1;
+    TraceBeginEvent(kTraceSort, size);
+    SortThread((void *)&params);
+    TraceEndEvent(kTraceSort);
   }
 }
 
 // Merge
 // Merge two subarrays.  Typically called by the mergesort() function.
-// Entry: pointer to array
+// Entry: sort context (array, scratch as large as it, ordering)
 //        start index
 //        middle index
 //        end index
 // Exit:  -
-void MergeSortMultiCore::Merge(int start, int mid, int end)
+template <class T, class Compare>
+void BasicMergeSortMultiCore<T, Compare>::Merge(
+  MergeSortMultiContext<T, Compare> *ctx,
+  int start,
+  int mid,
+  int end)
 {
-  hedger::S_T *tmp_arr;     // pointer to temp array
+  T *arr = ctx->arr;
+  T *tmp_arr = ctx->tmp_arr;
+
+  // Int merges in natural order take the dispatched vector kernel.
+  NoStats stats;
+  if (KernelMerge(stats, ctx->less, &arr[start], mid - start + 1,
+      &arr[mid + 1], end - mid, &tmp_arr[start])) {
+    memcpy(&arr[start], &tmp_arr[start], sizeof(T) * (end - start + 1));
+    return;
+  }
+
   int left1 = start;        // left of left-half <- start
   int right1 = mid;         // right of left-half <- mid
   int left2 = mid + 1;      // left of right-half <- mid + 1
   int right2 = end;         // right of right-half <- end
 
-  // Allocate a temporary array for swapping out and re-ordering words
-  // to be copied back to original array.
-  // NOTE: alloca is much faster but non-standard and not safe.
-  //tmp_arr = Pop();
-  tmp_arr = (hedger::S_T *) malloc((end - start + 1) * sizeof(hedger::S_T));
-  hedger::S_T *next_tmp = tmp_arr;
+  // Merge into the same index range of the scratch array.  Threads only
+  // ever merge disjoint ranges, so they share the one scratch array.
+  T *next_tmp = &tmp_arr[start];
 
   // Go through and save either left subarray or right subarray into swap array
   // according to the least at each index in the respective subarrays.
   while((left1 <= right1) && (left2 <= right2)) {
-    if(arr_[left1] < arr_[left2])
-      *next_tmp++ = arr_[left1++];    // save arr[left1]
+    if(ctx->less(arr[left1], arr[left2]))
+      *next_tmp++ = arr[left1++];    // save arr[left1]
     else
-      *next_tmp++ = arr_[left2++];    // save arr[left2]
+      *next_tmp++ = arr[left2++];    // save arr[left2]
   }
 
   // Now, save off the rest of the data in the swap array
   // from each of the two subarrays
   while(left1 <= right1)
-    *next_tmp++ = arr_[left1++];      // save arr[left1]
+    *next_tmp++ = arr[left1++];      // save arr[left1]
   while(left2 <= right2)
-    *next_tmp++ = arr_[left2++];      // save arr[left2]
+    *next_tmp++ = arr[left2++];      // save arr[left2]
 
   // Finally, recover what we've saved, sorted, from the swap array.
-  memcpy(&arr_[start], tmp_arr, sizeof(hedger::S_T) * (end - start + 1));
-  free(tmp_arr);
-  //Push(tmp_arr);
+  memcpy(&arr[start], &tmp_arr[start],
+    sizeof(T) * (end - start + 1));
+}
+
+// SortThread
+// Thread entry: one traced task around SortRecurse.
+// Entry: pointer to params, as SortRecurse
+// Exit:  nullptr (ignored)
+template <class T, class Compare>
+void *BasicMergeSortMultiCore<T, Compare>::SortThread(void *params)
+{
+  MergeSortMultiParams<T, Compare> *sort_params =
+    (MergeSortMultiParams<T, Compare> *)params;
+  TraceBeginEvent(kTraceTask, sort_params->end - sort_params->start + 1);
+  SortRecurse(params);
+  TraceEndEvent(kTraceTask);
+  return nullptr;
 }
 
 // Sort
@@ -150,10 +222,16 @@ void MergeSortMultiCore::Merge(int start, int mid, int end)
 //          - start index (typically 0)
 //          - end index (typically end-1)
 // Exit:  nullptr (ignored)
-void *MergeSortMultiCore::SortRecurse(void *params)
+template <class T, class Compare>
+void *BasicMergeSortMultiCore<T, Compare>::SortRecurse(void *params)
 {
-  MergeSortMultiParams *sort_params = (MergeSortMultiParams *)params;
-  if(sort_params->start < sort_params->end)
+  MergeSortMultiParams<T, Compare> *sort_params =
+    (MergeSortMultiParams<T, Compare> *)params;
+  MergeSortMultiContext<T, Compare> *ctx = sort_params->ctx;
+  size_t size = sort_params->end - sort_params->start + 1;
+  if (sort_params->start < sort_params->end &&
+      !(size <= ctx->small_sort_max &&
+        SortNetwork(&ctx->arr[sort_params->start], size, ctx->less)))
   {
     int mid = (sort_params->start + sort_params->end) / 2;
     // We're going to break the data set into progressively smaller pieces,
@@ -161,55 +239,74 @@ void *MergeSortMultiCore::SortRecurse(void *params)
 
     // This sets up the thread paramter blocks telling the threads which
     // part of the array they are assigned.
-    pthread_t thread_1, thread_2;
-    MergeSortMultiParams threadparams_1, threadparams_2;
-    threadparams_1.arr = threadparams_2.arr = sort_params->arr;
+    pthread_t thread_2;
+    MergeSortMultiParams<T, Compare> threadparams_1, threadparams_2;
+    threadparams_1.ctx = threadparams_2.ctx = ctx;
     threadparams_1.start = sort_params->start;
     threadparams_1.end = mid;
-    threadparams_1.merge_sort = sort_params->merge_sort;
     threadparams_2.start = mid + 1;
     threadparams_2.end = sort_params->end;
-    threadparams_2.merge_sort = sort_params->merge_sort;
 
-    if (GetThreadTot() < kThreadMax) {
-      SetThreadTot(GetThreadTot() + 2);
-      // Here we will instantiate the threads - two of them, one of the left,
-      // one for the right with mid as the partition.
-      int error = pthread_create(
-        &thread_1,
-        NULL,
-        &MergeSortMultiCore::SortRecurse,
-        (void *)&threadparams_1);
-      if (error) {
-        // TODO: LOG ERROR
+    // Reserve one thread against this sort's cap.  The calling thread is
+    // itself one of the thread_max sorting threads, so at most
+    // thread_max - 1 are spawned.  The reservation is a compare-and-swap
+    // so sibling threads cannot both claim the last slot.
+    if (ctx->thread_tot.TryAdd(1, ctx->thread_max - 1)) {
+      // Hand the right half to a new thread and sort the left half here,
+      // so no reserved thread sits in a join while its children work.
+      // NUMA-aware sorts run the new thread on the node holding its data.
+      TraceBeginEvent(kTraceSpawn, 1);
+      pthread_attr_t attr_2;
+      pthread_attr_init(&attr_2);
+      if (ctx->numa_aware) {
+        NumaSetAffinity(&attr_2, NumaChunkNode(threadparams_2.start,
+          ctx->size));
       }
-      error = pthread_create(
+      int error = pthread_create(
         &thread_2,
-        NULL,
-        &MergeSortMultiCore::SortRecurse,
+        &attr_2,
+        &BasicMergeSortMultiCore<T, Compare>::SortThread,
         (void *)&threadparams_2);
+      pthread_attr_destroy(&attr_2);
+      TraceEndEvent(kTraceSpawn);
+      SortRecurse((void *)&threadparams_1);
       if (error) {
         // TODO: LOG ERROR
+        // No thread took the right half: give back the slot and sort it
+        // here, so the merge below still sees two sorted halves.
+        ctx->thread_tot.Sub(1);
+        SortRecurse((void *)&threadparams_2);
+      } else {
+        // This re-syncs with the child thread we spawned.  This must be
+        // done before Merge() is called
+        void *result;
+        TraceBeginEvent(kTraceJoin, 1);
+        pthread_join(thread_2, &result);
+        TraceEndEvent(kTraceJoin);
+        ctx->thread_tot.Sub(1);
       }
-     // This re-syncs with the two child threads we spawned.  This must be
-     // done before Merge() is called
-     void *result;
-     pthread_join(thread_2,&result);
-     pthread_join(thread_1,&result);
-     SetThreadTot(GetThreadTot() - 2);
     } else {
       // If we're here, it means we've exceeded our
       // thread cap, so we'll execute these sorts in this thread.
       SortRecurse((void *)&threadparams_1);
       SortRecurse((void *)&threadparams_2);
     }
-    // Merge the subarrays on unwind.
-    sort_params->merge_sort->Merge(
+    // Merge the subarrays on unwind.  Only merges of a thread's share or
+    // more are traced, so small ones cost no events.
+    bool traced = TraceEnabled() && size >= ctx->trace_merge_min;
+    if (traced)
+      TraceRecord(kTraceMerge, kTraceBegin, size);
+    Merge(
+      ctx,
       sort_params->start,
       mid,
       sort_params->end
     );
+    if (traced)
+      TraceRecord(kTraceMerge, kTraceEnd, 0);
   }
   return nullptr; // return value is ignored
 }
+
+SORT_TYPES_INSTANTIATE(BasicMergeSortMultiCore)
 } // namespace hedger
@@ -24,42 +24,82 @@
 #define MERGE_SORT_MULTICORE_H_
 
 #include "algo.h"
+#include "roofline.h"
 #include "sortbench_lock.h"
 
 namespace hedger
 {
+template <class T, class Compare> struct MergeSortMultiContext;
+
 #define BLOCKMAX 12
 // MergeSortMultiCore
-// Implementation of high-performance multi-core merge sort
-class MergeSortMultiCore : public Algo
+// Implementation of high-performance multi-core merge sort.  With tracing
+// on (trace.h), each sort records its threads' tasks, the spawns, the
+// joins spent idle and the merges of at least half a thread's share of
+// the array, so the timeline shows the imbalance and the serial top
+// merges.
+template <class T, class Compare = std::less<T> >
+class BasicMergeSortMultiCore : public BasicAlgo<T, Compare>
 {
  public:
-  MergeSortMultiCore();
-  virtual ~MergeSortMultiCore();
-  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  BasicMergeSortMultiCore();
+  virtual ~BasicMergeSortMultiCore();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
   const char *GetName() { return "Merge Sort Multi-Core"; }
-  void Merge(int start, int mid, int end);
+  size_t GetScratchSize(size_t size) {
+    return Arena::Round(size * sizeof(T));
+  }
+  // As MergeSort: every level merges into the scratch and copies back
+  double GetMemoryBytes(size_t size) {
+    return 4.0 * size * sizeof(T) * RooflineLevels(2 * size * sizeof(T));
+  }
+  static void Merge(
+    MergeSortMultiContext<T, Compare> *ctx,
+    int start,
+    int mid,
+    int end
+  );
   static void *SortRecurse(void *params);
+  static void *SortThread(void *params);
+  void SetThreadMax(int thread_max) {
+    thread_max_ = thread_max < 1 ? 1 : thread_max;
+  }
+  int GetThreadMax() { return thread_max_; }
+  // Pin each thread to the NUMA node holding its chunk and place the
+  // scratch array to match (no effect on one node).  The scratch is placed
+  // once, in the arena, so it needs SetArena(); heap scratch is left alone.
+  void SetNumaAware(bool numa_aware);
+  void SetArena(Arena *arena);
  private:
-  static int GetThreadTot() { return thread_tot_; }
-  static void SetThreadTot(int thread_tot) { thread_tot_ = thread_tot; }
-  void Sort(hedger::S_T *arr, int size);
-  // Block stack stuff
-  static bool InitAlloc(int size);
-  static void ShutdownAlloc();
+  void Sort(T *arr, int size);
+  void PlaceScratch();
   // Member variables
-  static hedger::Lock *merge_lock_;
-  static volatile int thread_tot_;
-  static int kThreadMax;
+  int thread_max_;
+  bool numa_aware_;
+};
+
+typedef BasicMergeSortMultiCore<hedger::S_T> MergeSortMultiCore;
+
+// MergeSortMultiContext
+// Per-sort state shared by every thread working on one array
+template <class T, class Compare> struct MergeSortMultiContext {
+  T *arr;
+  T *tmp_arr;                   // scratch as large as arr
+  size_t size;
+  bool numa_aware;
+  int thread_max;
+  hedger::AtomicCounter thread_tot;
+  size_t small_sort_max;
+  size_t trace_merge_min;       // smallest merge traced, in elements
+  Compare less;
 };
 
 // MergeSortMultiParams
 // Parameter structure for sorting threads
-struct MergeSortMultiParams {
-  hedger::S_T *arr;
+template <class T, class Compare> struct MergeSortMultiParams {
+  hedger::MergeSortMultiContext<T, Compare> *ctx;
   int start;
   int end;
-  hedger::MergeSortMultiCore *merge_sort;
 };
 
 
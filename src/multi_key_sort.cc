@@ -0,0 +1,238 @@
+// multi_key_sort.cc
+//
+// Multi-column lexicographic sort (ORDER BY a, b, c) over integer columns.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdint.h>
+#include <memory.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "multi_key_sort.h"
+
+namespace hedger {
+
+// Buckets per radix pass (one byte)
+const int kMultiKeyRadix = 256;
+// Bytes in a composite word
+const int kMultiKeyDigitTot = 8;
+
+// MultiKeyPair
+// A composite word and the row it came from
+template <class Index> struct MultiKeyPair {
+  uint64_t key;
+  Index index;
+};
+
+// MultiKeyField
+// One column's bits in a composite word: the offset from the column
+// minimum shifted left by shift, or right by -shift for the high part of a
+// column that straddles two words
+struct MultiKeyField {
+  int column;
+  uint64_t min;                 // column minimum, as unsigned bits
+  int shift;
+};
+
+// MultiKeyWord
+// 64 bits of the composite key
+struct MultiKeyWord {
+  std::vector<MultiKeyField> field_arr;
+  int bit_tot;
+};
+
+// MultiKeyScratchSize
+// Exit: arena bytes MultiKeySort<Index> takes for size rows
+template <class Index> size_t MultiKeyScratchSize(size_t size)
+{
+  return Arena::Round(size * sizeof(uint64_t)) +
+    2 * Arena::Round(size * sizeof(MultiKeyPair<Index>)) +
+    Arena::Round(kMultiKeyDigitTot * kMultiKeyRadix * sizeof(size_t));
+}
+
+// RadixRefine
+// Stable LSD radix sort of the rows in perm's order by word_arr[row], so
+// rows with equal words keep their order from the previous refinement.
+// Entry: composite word per row
+//        rows
+//        permutation to refine (identity on the first call)
+//        significant bits in the words
+//        pair buffers and count table from scratch
+// Exit:  byte passes run
+template <class Index> static int RadixRefine(
+  const uint64_t *word_arr,
+  size_t size,
+  Index *perm,
+  int bit_tot,
+  MultiKeyPair<Index> *src,
+  MultiKeyPair<Index> *dst,
+  size_t *count_arr)
+{
+  int digit_tot = (bit_tot + 7) / 8;
+  memset(count_arr, 0, digit_tot * kMultiKeyRadix * sizeof(size_t));
+  for (size_t i = 0; i < size; ++i) {
+    Index row = perm[i];
+    uint64_t key = word_arr[row];
+    src[i].key = key;
+    src[i].index = row;
+    for (int d = 0; d < digit_tot; ++d)
+      ++count_arr[d * kMultiKeyRadix + ((key >> (d * 8)) & 0xff)];
+  }
+
+  int pass_tot = 0;
+  for (int d = 0; d < digit_tot; ++d) {
+    size_t *count = &count_arr[d * kMultiKeyRadix];
+    int shift = d * 8;
+    // Every row has the same digit here: the pass would change nothing.
+    if (size == count[(src[0].key >> shift) & 0xff])
+      continue;
+    size_t offset = 0;
+    for (int b = 0; b < kMultiKeyRadix; ++b) {
+      size_t bucket_tot = count[b];
+      count[b] = offset;
+      offset += bucket_tot;
+    }
+    for (size_t i = 0; i < size; ++i)
+      dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+    MultiKeyPair<Index> *swap = src;
+    src = dst;
+    dst = swap;
+    ++pass_tot;
+  }
+
+  for (size_t i = 0; i < size; ++i)
+    perm[i] = src[i].index;
+  return pass_tot;
+}
+
+// MultiKeySort
+// Entry: columns, most significant first
+//        column count
+//        rows
+//        permutation to fill
+//        arena for scratch (nullptr == heap)
+//        plan out (nullptr == not wanted)
+// Exit:  0 == success
+template <class Index> int MultiKeySort(
+  const int64_t * const *col_arr,
+  int col_tot,
+  size_t size,
+  Index *perm,
+  Arena *arena,
+  MultiKeyPlan *plan)
+{
+  if (nullptr == col_arr || nullptr == perm || col_tot < 1)
+    return -1;
+  for (size_t i = 0; i < size; ++i)
+    perm[i] = (Index) i;
+  if (plan)
+    plan->bit_tot = plan->word_tot = plan->pass_tot = 0;
+  if (size < 2)
+    return 0;
+
+  // Lay the columns end to end from the least significant up.  A column
+  // needs the bits of its range; constant columns need none.
+  std::vector<int> offset_arr(col_tot), width_arr(col_tot);
+  std::vector<uint64_t> min_arr(col_tot);
+  int bit_tot = 0;
+  for (int c = col_tot - 1; c >= 0; --c) {
+    const int64_t *col = col_arr[c];
+    int64_t low = col[0], high = col[0];
+    for (size_t i = 1; i < size; ++i) {
+      if (col[i] < low)
+        low = col[i];
+      if (col[i] > high)
+        high = col[i];
+    }
+    uint64_t span = (uint64_t) high - (uint64_t) low;
+    min_arr[c] = (uint64_t) low;
+    width_arr[c] = span ? 64 - __builtin_clzll(span) : 0;
+    offset_arr[c] = bit_tot;
+    bit_tot += width_arr[c];
+  }
+
+  // Cut that bit string into 64-bit words; a column crossing a word
+  // boundary puts its low bits in one word and its high bits in the next.
+  std::vector<MultiKeyWord> word_list((bit_tot + 63) / 64);
+  for (size_t k = 0; k < word_list.size(); ++k) {
+    int word_start = (int) k * 64;
+    MultiKeyWord& word = word_list[k];
+    word.bit_tot = std::min(64, bit_tot - word_start);
+    for (int c = 0; c < col_tot; ++c) {
+      int start = offset_arr[c], end = offset_arr[c] + width_arr[c];
+      if (!width_arr[c] || end <= word_start || start >= word_start + 64)
+        continue;
+      MultiKeyField field = { c, min_arr[c], start - word_start };
+      word.field_arr.push_back(field);
+    }
+  }
+  if (plan) {
+    plan->bit_tot = bit_tot;
+    plan->word_tot = (int) word_list.size();
+  }
+
+  Scratch scratch(arena);
+  uint64_t *packed = (uint64_t *) scratch.Alloc(size * sizeof(uint64_t));
+  MultiKeyPair<Index> *src = (MultiKeyPair<Index> *)
+    scratch.Alloc(size * sizeof(MultiKeyPair<Index>));
+  MultiKeyPair<Index> *dst = (MultiKeyPair<Index> *)
+    scratch.Alloc(size * sizeof(MultiKeyPair<Index>));
+  size_t *count_arr = (size_t *)
+    scratch.Alloc(kMultiKeyDigitTot * kMultiKeyRadix * sizeof(size_t));
+  if (nullptr == packed || nullptr == src || nullptr == dst ||
+      nullptr == count_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+
+  // Least significant word first; each sort is stable, so the more
+  // significant words only reorder rows they tell apart.
+  for (auto& word : word_list) {
+    memset(packed, 0, size * sizeof(uint64_t));
+    for (auto& field : word.field_arr) {
+      const int64_t *col = col_arr[field.column];
+      if (field.shift >= 0) {
+        for (size_t i = 0; i < size; ++i)
+          packed[i] |= ((uint64_t) col[i] - field.min) << field.shift;
+      } else {
+        for (size_t i = 0; i < size; ++i)
+          packed[i] |= ((uint64_t) col[i] - field.min) >> -field.shift;
+      }
+    }
+    int pass_tot = RadixRefine(packed, size, perm, word.bit_tot, src, dst,
+      count_arr);
+    if (plan)
+      plan->pass_tot += pass_tot;
+  }
+  return 0;
+}
+
+// Explicit instantiations
+template int MultiKeySort<uint32_t>(const int64_t * const *col_arr,
+  int col_tot, size_t size, uint32_t *perm, Arena *arena,
+  MultiKeyPlan *plan);
+template int MultiKeySort<uint64_t>(const int64_t * const *col_arr,
+  int col_tot, size_t size, uint64_t *perm, Arena *arena,
+  MultiKeyPlan *plan);
+template size_t MultiKeyScratchSize<uint32_t>(size_t size);
+template size_t MultiKeyScratchSize<uint64_t>(size_t size);
+} // namespace hedger
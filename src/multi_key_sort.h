@@ -0,0 +1,69 @@
+// multi_key_sort.h
+//
+// Multi-column lexicographic sort (ORDER BY a, b, c) over integer columns.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef MULTI_KEY_SORT_H_
+#define MULTI_KEY_SORT_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "arena.h"
+
+namespace hedger
+{
+// MultiKeyPlan
+// How MultiKeySort packed the columns
+struct MultiKeyPlan {
+  int bit_tot;                  // normalized key bits over every column
+  int word_tot;                 // 64-bit composite words (one radix sort each)
+  int pass_tot;                 // byte passes actually run
+};
+
+// MultiKeySort
+// Stable argsort of rows by col_arr[0], then col_arr[1] .. as signed
+// 64-bit values.  Each column is normalized to its offset from the column
+// minimum, which needs only as many bits as its range, and the columns are
+// laid end to end and cut into 64-bit composite words.  A table whose key
+// fits in 64 or 128 bits takes one or two LSD radix sorts; wider ones take
+// one stable LSD radix sort per word, least significant first, each
+// refining the previous order (about a column at a time for wide columns).
+// Instantiated for uint32_t and uint64_t permutations.
+// Entry: columns, most significant first
+//        column count
+//        rows
+//        permutation to fill
+//        arena for scratch (nullptr == heap)
+//        plan out (nullptr == not wanted)
+// Exit:  0 == success
+template <class Index> int MultiKeySort(
+  const int64_t * const *col_arr,
+  int col_tot,
+  size_t size,
+  Index *perm,
+  Arena *arena,
+  MultiKeyPlan *plan = nullptr
+);
+template <class Index> size_t MultiKeyScratchSize(size_t size);
+}
+
+#endif // MULTI_KEY_SORT_H_
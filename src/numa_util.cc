@@ -0,0 +1,399 @@
+// numa_util.cc
+//
+// NUMA topology discovery and memory placement, through sysfs and raw
+// system calls so that no NUMA library is required.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "numa_util.h"
+
+namespace hedger {
+
+// Most pages NumaCountPages() asks the kernel about
+const size_t kNumaSampleMax = 4096;
+
+// ParseList
+// Parse a sysfs list such as "0-3,8-11".
+// Entry: text
+//        output ids
+static void ParseList(const char *text, std::vector<int>& id_arr)
+{
+  const char *p = text;
+  while (*p && '\n' != *p) {
+    char *end;
+    long low = strtol(p, &end, 10);
+    if (end == p)
+      break;
+    long high = low;
+    p = end;
+    if ('-' == *p) {
+      high = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long id = low; id <= high; ++id)
+      id_arr.push_back((int) id);
+    if (',' == *p)
+      ++p;
+  }
+}
+
+// ReadLine
+// Entry: path
+//        output buffer and its size
+// Exit:  true == read
+static bool ReadLine(const char *path, char *buffer, size_t size)
+{
+  FILE *file = fopen(path, "r");
+  if (nullptr == file)
+    return false;
+  bool result = nullptr != fgets(buffer, (int) size, file);
+  fclose(file);
+  return result;
+}
+
+// Constructor
+// Read the topology from sysfs, or fall back to one node.
+NumaTopology::NumaTopology() {
+  char buffer[4096];
+  if (ReadLine("/sys/devices/system/node/online", buffer, sizeof(buffer)))
+    ParseList(buffer, node_arr_);
+  for (auto node : node_arr_) {
+    char path[128];
+    std::vector<int> cpus;
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+      node);
+    if (ReadLine(path, buffer, sizeof(buffer)))
+      ParseList(buffer, cpus);
+    cpu_arr_.push_back(cpus);
+
+    size_t mem_total = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo",
+      node);
+    FILE *file = fopen(path, "r");
+    if (file) {
+      while (fgets(buffer, sizeof(buffer), file)) {
+        const char *field = strstr(buffer, "MemTotal:");
+        if (field) {
+          mem_total = strtoull(field + strlen("MemTotal:"), nullptr, 10);
+          break;
+        }
+      }
+      fclose(file);
+    }
+    mem_total_arr_.push_back(mem_total);
+  }
+
+  if (node_arr_.empty()) {
+    node_arr_.push_back(0);
+    std::vector<int> cpus;
+    int cpu_tot = std::thread::hardware_concurrency();
+    for (int cpu = 0; cpu < cpu_tot; ++cpu)
+      cpus.push_back(cpu);
+    cpu_arr_.push_back(cpus);
+    mem_total_arr_.push_back(0);
+  }
+}
+
+// Get
+// Exit: the topology, read on first use
+NumaTopology& NumaTopology::Get()
+{
+  static NumaTopology topology;
+  return topology;
+}
+
+// NumaAllocPages
+// Map page-aligned memory without touching it, so that its placement is
+// decided later by a policy or by first touch.
+// Entry: bytes
+// Exit:  pointer, or nullptr
+void *NumaAllocPages(size_t bytes)
+{
+  void *addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return MAP_FAILED == addr ? nullptr : addr;
+}
+
+// NumaFreePages
+// Entry: pointer from NumaAllocPages()
+//        bytes
+void NumaFreePages(void *addr, size_t bytes)
+{
+  if (addr)
+    munmap(addr, bytes);
+}
+
+// Bits in one word of a node mask
+const size_t kMaskWordBits = sizeof(unsigned long) * 8;
+
+// NumaNodeMask
+// Size a node mask for the highest node id, so that ids of 64 and up
+// land in later words rather than shifting past the first.
+// Entry: out: mask, cleared
+static void NumaNodeMask(std::vector<unsigned long>& mask)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  int id_max = 0;
+  for (int node = 0; node < topology.GetNodeTot(); ++node)
+    id_max = std::max(id_max, topology.GetNodeId(node));
+  mask.assign(id_max / kMaskWordBits + 1, 0);
+}
+
+// NumaMaskSet
+// Entry: mask from NumaNodeMask()
+//        node id
+static void NumaMaskSet(std::vector<unsigned long>& mask, int id)
+{
+  mask[id / kMaskWordBits] |= 1UL << (id % kMaskWordBits);
+}
+
+// Mbind
+// Apply a memory policy to a range, moving pages already in place.
+// Entry: page-aligned address
+//        bytes
+//        MPOL_* mode
+//        node mask
+// Exit:  true == success
+static bool Mbind(
+  void *addr,
+  size_t bytes,
+  int mode,
+  const std::vector<unsigned long>& mask)
+{
+  // The kernel reads one bit fewer than maxnode
+  return !syscall(SYS_mbind, addr, bytes, mode, mask.data(),
+    mask.size() * kMaskWordBits + 1, MPOL_MF_MOVE);
+}
+
+// PageSize
+static size_t PageSize()
+{
+  static size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+// AlignToPages
+// Shrink a range to the whole pages inside it.
+// Entry: address
+//        bytes
+// Exit:  false == no whole page
+static bool AlignToPages(void **addr, size_t *bytes)
+{
+  size_t page_size = PageSize();
+  size_t lead = (page_size - (size_t) *addr % page_size) % page_size;
+  if (*bytes < lead + page_size)
+    return false;
+  *addr = (char *) *addr + lead;
+  *bytes = (*bytes - lead) / page_size * page_size;
+  return true;
+}
+
+// NumaInterleave
+// Spread a range's pages round-robin over every node.  Partial pages at
+// either end are left alone.
+// Entry: address
+//        bytes
+// Exit:  true == placed
+bool NumaInterleave(void *addr, size_t bytes)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  if (topology.GetNodeTot() < 2 || !AlignToPages(&addr, &bytes))
+    return false;
+  std::vector<unsigned long> mask;
+  NumaNodeMask(mask);
+  for (int node = 0; node < topology.GetNodeTot(); ++node)
+    NumaMaskSet(mask, topology.GetNodeId(node));
+  return Mbind(addr, bytes, MPOL_INTERLEAVE, mask);
+}
+
+// NumaChunkNode
+// Exit: node that chunked placement gives element index of size
+int NumaChunkNode(size_t index, size_t size)
+{
+  int node_tot = NumaTopology::Get().GetNodeTot();
+  return size ? (int) (index * node_tot / size) : 0;
+}
+
+// NumaBindChunks
+// Chunked placement of a range whose pages may already be touched.
+// Partial pages at either end are left alone.
+// Entry: address
+//        bytes
+// Exit:  true == placed
+bool NumaBindChunks(void *addr, size_t bytes)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  int node_tot = topology.GetNodeTot();
+  if (node_tot < 2 || !AlignToPages(&addr, &bytes))
+    return false;
+  size_t page_size = PageSize();
+  bool result = true;
+  std::vector<unsigned long> mask;
+  for (int node = 0; node < node_tot; ++node) {
+    size_t start = bytes * node / node_tot / page_size * page_size;
+    size_t end = node + 1 == node_tot ? bytes :
+      bytes * (node + 1) / node_tot / page_size * page_size;
+    if (end > start) {
+      NumaNodeMask(mask);
+      NumaMaskSet(mask, topology.GetNodeId(node));
+      result &= Mbind((char *) addr + start, end - start, MPOL_BIND, mask);
+    }
+  }
+  return result;
+}
+
+// FirstTouchParams
+// Parameter structure for first-touch threads
+struct FirstTouchParams {
+  char *start;
+  size_t bytes;
+};
+
+// FirstTouchWorker
+// Zero one chunk from a thread pinned to its node.
+static void *FirstTouchWorker(void *params)
+{
+  FirstTouchParams *touch = (FirstTouchParams *) params;
+  memset(touch->start, 0, touch->bytes);
+  return nullptr;
+}
+
+// NumaFirstTouch
+// Chunked placement of untouched memory by the default local-allocation
+// policy: one thread pinned to each node zeroes that node's chunk.
+// Entry: page-aligned address, not yet touched
+//        bytes
+// Exit:  true == placed
+bool NumaFirstTouch(void *addr, size_t bytes)
+{
+  int node_tot = NumaTopology::Get().GetNodeTot();
+  if (node_tot < 2)
+    return false;
+  size_t page_size = PageSize();
+  std::vector<pthread_t> thread_arr(node_tot);
+  std::vector<FirstTouchParams> params_arr(node_tot);
+  std::vector<bool> started_arr(node_tot);
+  bool result = true;
+  for (int node = 0; node < node_tot; ++node) {
+    size_t start = bytes * node / node_tot / page_size * page_size;
+    size_t end = node + 1 == node_tot ? bytes :
+      bytes * (node + 1) / node_tot / page_size * page_size;
+    params_arr[node].start = (char *) addr + start;
+    params_arr[node].bytes = end - start;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    result &= NumaSetAffinity(&attr, node);
+    started_arr[node] = !pthread_create(&thread_arr[node], &attr,
+      FirstTouchWorker, (void *) &params_arr[node]);
+    pthread_attr_destroy(&attr);
+    if (!started_arr[node]) {
+      // TODO: LOG ERROR
+      FirstTouchWorker((void *) &params_arr[node]);
+      result = false;
+    }
+  }
+  for (int node = 0; node < node_tot; ++node) {
+    if (started_arr[node])
+      pthread_join(thread_arr[node], nullptr);
+  }
+  return result;
+}
+
+// NumaSetAffinity
+// Restrict threads created with attr to one node's CPUs.
+// Entry: thread attributes
+//        node
+// Exit:  true == set
+bool NumaSetAffinity(pthread_attr_t *attr, int node)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  if (topology.GetNodeTot() < 2 || topology.GetCpuArr(node).empty())
+    return false;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (auto cpu : topology.GetCpuArr(node))
+    CPU_SET(cpu, &cpu_set);
+  return !pthread_attr_setaffinity_np(attr, sizeof(cpu_set), &cpu_set);
+}
+
+// NumaGetNode
+// Exit: node index holding the page at addr, or -1 if unknown
+int NumaGetNode(const void *addr)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  void *page = (void *) ((size_t) addr & ~(PageSize() - 1));
+  int status = -1;
+  if (syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) ||
+      status < 0)
+    return topology.GetNodeTot() < 2 ? 0 : -1;
+  for (int node = 0; node < topology.GetNodeTot(); ++node) {
+    if (topology.GetNodeId(node) == status)
+      return node;
+  }
+  return -1;
+}
+
+// NumaCountPages
+// Sample up to kNumaSampleMax pages of a range and count them per node.
+// A page is local when it sits where chunked placement would put it.
+// Entry: address
+//        bytes
+//        output count per node (unknown pages are not counted)
+//        output locally placed pages
+//        output pages sampled
+void NumaCountPages(
+  const void *addr,
+  size_t bytes,
+  std::vector<size_t>& count_arr,
+  size_t *local_tot,
+  size_t *sample_tot)
+{
+  NumaTopology& topology = NumaTopology::Get();
+  size_t page_size = PageSize();
+  size_t page_tot = (bytes + page_size - 1) / page_size;
+  size_t step = page_tot > kNumaSampleMax ? page_tot / kNumaSampleMax : 1;
+  count_arr.assign(topology.GetNodeTot(), 0);
+  *local_tot = *sample_tot = 0;
+  for (size_t page = 0; page < page_tot; page += step) {
+    int node = NumaGetNode((const char *) addr + page * page_size);
+    ++*sample_tot;
+    if (node < 0)
+      continue;
+    ++count_arr[node];
+    if (node == NumaChunkNode(page, page_tot))
+      ++*local_tot;
+  }
+}
+} // namespace hedger
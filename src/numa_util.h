@@ -0,0 +1,77 @@
+// numa_util.h
+//
+// NUMA topology discovery and memory placement, through sysfs and raw
+// system calls so that no NUMA library is required.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef NUMA_UTIL_H_
+#define NUMA_UTIL_H_
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace hedger
+{
+// NumaTopology
+// Nodes, their CPUs and their memory, read once from
+// /sys/devices/system/node.  Without sysfs NUMA support the machine is
+// reported as one node holding every CPU.
+class NumaTopology
+{
+ public:
+  static NumaTopology& Get();
+  int GetNodeTot() { return (int) node_arr_.size(); }
+  int GetNodeId(int node) { return node_arr_[node]; }
+  const std::vector<int>& GetCpuArr(int node) { return cpu_arr_[node]; }
+  size_t GetMemTotal(int node) { return mem_total_arr_[node]; }  // kB
+ private:
+  NumaTopology();
+  std::vector<int> node_arr_;               // sysfs node ids
+  std::vector<std::vector<int>> cpu_arr_;   // CPUs of each node
+  std::vector<size_t> mem_total_arr_;       // kB of each node
+};
+
+// Placement
+// Node indices below are positions in NumaTopology (0 .. node_tot - 1).
+// "Chunked" placement puts part k of node_tot equal parts on node k.
+// Every call is a no-op returning false on a single-node machine or when
+// the kernel refuses; memory is still usable, just not placed.
+void *NumaAllocPages(size_t bytes);
+void NumaFreePages(void *addr, size_t bytes);
+bool NumaInterleave(void *addr, size_t bytes);
+bool NumaBindChunks(void *addr, size_t bytes);
+bool NumaFirstTouch(void *addr, size_t bytes);
+int NumaChunkNode(size_t index, size_t size);
+bool NumaSetAffinity(pthread_attr_t *attr, int node);
+
+// Inspection
+int NumaGetNode(const void *addr);
+void NumaCountPages(
+  const void *addr,
+  size_t bytes,
+  std::vector<size_t>& count_arr,
+  size_t *local_tot,
+  size_t *sample_tot
+);
+}
+
+#endif // NUMA_UTIL_H_
@@ -24,13 +24,17 @@
 #include <cstddef>
 
 #include "quick_sort.h"
+#include "sorting_network.h"
+#include "sort_types.h"
 
 namespace hedger {
 
-QuickSort::QuickSort() {
+template <class T, class Compare>
+BasicQuickSort<T, Compare>::BasicQuickSort() {
 }
 
-QuickSort::~QuickSort() {
+template <class T, class Compare>
+BasicQuickSort<T, Compare>::~BasicQuickSort() {
 }
 
 // Test
@@ -39,72 +43,65 @@ QuickSort::~QuickSort() {
 //        size of array
 // Exit:  Result of test
 //
-int QuickSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
+template <class T, class Compare>
+int BasicQuickSort<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
 {
   int result = 0;
-  Sort( array, 0, size - 1 );
+  if (this->instrumented_)
+    Sort<CountStats>(array, 0, size - 1);
+  else
+    Sort<NoStats>(array, 0, size - 1);
   return result;
 }
 
-//
-// Class-specific Implementation
-//
-
-// Swap
-// Swap two array values identified by index
+// TestCounted
 // Entry: pointer to array
-//        index a
-//        index b
-void QuickSort::Swap(int index_a, int index_b)
+//        size of array
+//        range (ignored)
+//        stats to add this call's counts to
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicQuickSort<T, Compare>::TestCounted(
+  T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
 {
-  hedger::S_T swap = arr_[index_a];
-  arr_[index_a] = arr_[index_b];
-  arr_[index_b] = swap;
+  Sort<CountStats>(array, 0, size - 1, &stats);
+  return 0;
 }
 
-// findPartition
-// Find the next partition for sorting
-// Entry: pointer to array
-//        start index
-//        end index
-int QuickSort::Partition(int start, int end)
-{
-  int pivot_mag = arr_[end];     // magnitude: lesser, left; greater, right
-  int partition = start;
-
-  for (int i = start; i < end; ++i) {
-    if (arr_[i] < pivot_mag) {
-      // Need to swap current index value with partition index value
-      // to get the greater value to the right of the partition
-      // We place the lesser value at the partition index and move
-      // the partition to the right.
-      Swap(i, partition);
-      partition++;
-    }
-  }
-
-  // Swap the last element with the partition.
-  // At this point, all the items to the left of the partition will be less
-  // than those to the right.
-  Swap(end, partition);
-  return partition;
-}
+//
+// Class-specific Implementation
+//
 
 // SortRecurse
 // Perform the sorting.
 // TODO: Apply R.C. Singleton's optimization (Knuth Vol.3 2nd Ed. p.123) or
 //   a variant thereof to avoid the O(n^2) penalty for an already-sorted array.
-// Entry: start index
+// Entry: sort context
+//        start index
 //        end index
-void QuickSort::SortRecurse(int start, int end)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort<T, Compare>::SortRecurse(
+  Context<Stats>& ctx,
+  int start,
+  int end)
 {
-  IncMaxRecurseDepth();
-  if (start < end) {
-    int partition = Partition(start, end);
-    SortRecurse(start, partition - 1);
-    SortRecurse(partition + 1, end);
+  ctx.stats.Enter();
+  size_t size = end - start + 1;
+  if (start < end &&
+      !(size <= this->small_sort_max_ &&
+        SortNetwork(&ctx.arr[start], size, ctx.CountedLess()))) {
+    int partition = Partition(ctx, start, end);
+    SortRecurse(ctx, start, partition - 1);
+    SortRecurse(ctx, partition + 1, end);
   }
-  DecMaxRecurseDepth();
+  ctx.stats.Leave();
 }
 
 // sort
@@ -112,11 +109,21 @@ void QuickSort::SortRecurse(int start, int end)
 // Entry: pointer to array
 //        start index
 //        end index
-void QuickSort::Sort(hedger::S_T *arr, int start, int end)
+//        stats to add to (nullptr == the instance's)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort<T, Compare>::Sort(
+  T *arr,
+  int start,
+  int end,
+  SortStats *sink)
 {
   if ((start < end) && nullptr != arr) {
-    arr_ = arr;
-    SortRecurse(start, end);
+    Context<Stats> ctx(arr, this->less_);
+    SortRecurse(ctx, start, end);
+    this->Finish(ctx.stats, sink);
   }
 }
+
+SORT_TYPES_INSTANTIATE(BasicQuickSort)
 } // namespace hedger
@@ -24,22 +24,81 @@
 #define QUICK_SORT_H_
 
 #include "algo.h"
+#include "sort_kernels.h"
+#include "roofline.h"
 
 namespace hedger
 {
-class QuickSort : public Algo
+template <class T, class Compare = std::less<T> >
+class BasicQuickSort : public BasicAlgo<T, Compare>
 {
  public:
-  QuickSort();
-  virtual ~QuickSort();
-  virtual int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicQuickSort();
+  virtual ~BasicQuickSort();
+  virtual int Test(T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
   virtual const char *GetName() { return "Quick Sort"; }
+  bool CanInstrument() { return true; }
+  // Each partition level reads and writes its ranges once
+  double GetMemoryBytes(size_t size) {
+    return 2.0 * size * sizeof(T) * RooflineLevels(size * sizeof(T));
+  }
  protected:
-  virtual int Partition(int start, int end);
-  virtual void Sort(hedger::S_T *arr, int start, int end);
-  virtual void SortRecurse(int start, int end);
-  virtual void Swap(int index_a, int index_b);
+  template <class Stats>
+    void Sort(T *arr, int start, int end, SortStats *sink = nullptr);
+  template <class Stats>
+    void SortRecurse(Context<Stats>& ctx, int start, int end);
+  // Partition
+  // Lomuto partition around the last element.
+  // Entry: sort context
+  //        start index
+  //        end index
+  // Exit:  final index of the pivot
+  template <class Stats>
+    int Partition(Context<Stats>& ctx, int start, int end) {
+    T *arr = ctx.arr;
+    T pivot_mag = arr[end];   // magnitude: lesser, left; greater, right
+    int partition = start;
+
+    // Uninstrumented int sorts take the dispatched vector kernel.
+    size_t split;
+    if (KernelPartition(ctx.stats, ctx.less, &arr[start], end - start,
+        pivot_mag, &split)) {
+      partition = start + (int) split;
+      Swap(ctx, end, partition);
+      return partition;
+    }
+
+    for (int i = start; i < end; ++i) {
+      if (ctx.Less(arr[i], pivot_mag)) {
+        // Need to swap current index value with partition index value
+        // to get the greater value to the right of the partition
+        // We place the lesser value at the partition index and move
+        // the partition to the right.
+        Swap(ctx, i, partition);
+        partition++;
+      }
+    }
+
+    // Swap the last element with the partition.
+    // At this point, all the items to the left of the partition will be less
+    // than those to the right.
+    Swap(ctx, end, partition);
+    return partition;
+  }
+  // Swap two array values identified by index
+  template <class Stats>
+    inline void Swap(Context<Stats>& ctx, int index_a, int index_b) {
+    ctx.stats.Swap();
+    T swap = ctx.arr[index_a];
+    ctx.arr[index_a] = ctx.arr[index_b];
+    ctx.arr[index_b] = swap;
+  }
 };
+
+typedef BasicQuickSort<hedger::S_T> QuickSort;
 }
 
 #endif // QUICK_SORT_H_
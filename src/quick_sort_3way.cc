@@ -0,0 +1,251 @@
+// quick_sort_3way.cc
+//
+// Three-way (Dutch national flag) quick sort, with fused sort+unique and
+// sort+count.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cstddef>
+
+#include "quick_sort_3way.h"
+#include "sorting_network.h"
+#include "sort_types.h"
+
+namespace hedger {
+
+// Ranges this small are finished by insertion sort
+const size_t kQuick3WayInsertionMax = 16;
+
+template <class T, class Compare>
+BasicQuickSort3Way<T, Compare>::BasicQuickSort3Way() {
+}
+
+template <class T, class Compare>
+BasicQuickSort3Way<T, Compare>::~BasicQuickSort3Way() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+//
+template <class T, class Compare>
+int BasicQuickSort3Way<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+  if (this->instrumented_) {
+    Context<CountStats> ctx(array, this->less_);
+    SortRecurse(ctx, 0, size);
+    this->Finish(ctx.stats);
+  } else {
+    Context<NoStats> ctx(array, this->less_);
+    SortRecurse(ctx, 0, size);
+  }
+  return 0;
+}
+
+// SortUnique
+// Entry: pointer to array
+//        size of array
+// Exit:  distinct keys, now sorted at the front of the array
+template <class T, class Compare>
+size_t BasicQuickSort3Way<T, Compare>::SortUnique(T *array, size_t size)
+{
+  return SortCount(array, size, nullptr);
+}
+
+// SortCount
+// Entry: pointer to array
+//        size of array
+//        count per distinct key out (nullptr == not wanted)
+// Exit:  distinct keys, now sorted at the front of the array
+template <class T, class Compare>
+size_t BasicQuickSort3Way<T, Compare>::SortCount(
+  T *array,
+  size_t size,
+  size_t *count_arr)
+{
+  size_t out = 0;
+  if (nullptr == array)
+    return 0;
+  if (this->instrumented_) {
+    Context<CountStats> ctx(array, this->less_);
+    SortEmit(ctx, 0, size, out, count_arr);
+    this->Finish(ctx.stats);
+  } else {
+    Context<NoStats> ctx(array, this->less_);
+    SortEmit(ctx, 0, size, out, count_arr);
+  }
+  return out;
+}
+
+//
+// Class-specific Implementation
+//
+
+// Partition
+// Dutch national flag partition of [start, end) around a random pivot.
+// Entry: sort context
+//        start index
+//        end index (exclusive)
+//        out: first key equal to the pivot
+//        out: first key greater than the pivot
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort3Way<T, Compare>::Partition(
+  Context<Stats>& ctx,
+  size_t start,
+  size_t end,
+  size_t& lt,
+  size_t& gt)
+{
+  T *arr = ctx.arr;
+  T pivot = arr[start + ctx.Random() % (end - start)];
+  ctx.stats.Move();
+  size_t i = start;
+  lt = start;
+  gt = end;
+  while (i < gt) {
+    if (ctx.Less(arr[i], pivot))
+      Swap(ctx, lt++, i++);
+    else if (ctx.Less(pivot, arr[i]))
+      Swap(ctx, i, --gt);
+    else
+      ++i;
+  }
+}
+
+// InsertionSort
+// Entry: sort context
+//        start index
+//        end index (exclusive)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort3Way<T, Compare>::InsertionSort(
+  Context<Stats>& ctx,
+  size_t start,
+  size_t end)
+{
+  T *arr = ctx.arr;
+  size_t size = end - start;
+  if (size <= this->small_sort_max_ &&
+      SortNetwork(&arr[start], size, ctx.CountedLess()))
+    return;
+  for (size_t i = start + 1; i < end; ++i) {
+    T key = arr[i];
+    size_t j = i;
+    while (j > start && ctx.Less(key, arr[j - 1])) {
+      arr[j] = arr[j - 1];
+      ctx.stats.Move();
+      --j;
+    }
+    arr[j] = key;
+    ctx.stats.Move(2);
+  }
+}
+
+// SortRecurse
+// Entry: sort context
+//        start index
+//        end index (exclusive)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort3Way<T, Compare>::SortRecurse(
+  Context<Stats>& ctx,
+  size_t start,
+  size_t end)
+{
+  ctx.stats.Enter();
+  while (end - start > kQuick3WayInsertionMax) {
+    size_t lt, gt;
+    Partition(ctx, start, end, lt, gt);
+    // Recurse into the smaller side and loop on the larger; [lt, gt) is
+    // already in place.
+    if (lt - start < end - gt) {
+      SortRecurse(ctx, start, lt);
+      start = gt;
+    } else {
+      SortRecurse(ctx, gt, end);
+      end = lt;
+    }
+  }
+  InsertionSort(ctx, start, end);
+  ctx.stats.Leave();
+}
+
+// SortEmit
+// Sort [start, end) in order, writing each distinct key to arr[out++]
+// (and its count to count_arr).  Every key read produces at most one
+// output, so out never passes start and the writes only land on keys
+// that have been consumed.
+// Entry: sort context
+//        start index
+//        end index (exclusive)
+//        output cursor
+//        count per distinct key out (nullptr == not wanted)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSort3Way<T, Compare>::SortEmit(
+  Context<Stats>& ctx,
+  size_t start,
+  size_t end,
+  size_t& out,
+  size_t *count_arr)
+{
+  T *arr = ctx.arr;
+  ctx.stats.Enter();
+  // The lesser side must be written before the equal range, so only the
+  // greater side can be a loop; the random pivot keeps the depth
+  // logarithmic in expectation.
+  while (end - start > kQuick3WayInsertionMax) {
+    size_t lt, gt;
+    Partition(ctx, start, end, lt, gt);
+    SortEmit(ctx, start, lt, out, count_arr);
+    arr[out] = arr[lt];
+    ctx.stats.Move();
+    if (count_arr)
+      count_arr[out] = gt - lt;
+    ++out;
+    start = gt;
+  }
+  InsertionSort(ctx, start, end);
+  for (size_t i = start; i < end; ++i) {
+    if (i > start && !ctx.Less(arr[out - 1], arr[i])) {
+      if (count_arr)
+        ++count_arr[out - 1];
+      continue;
+    }
+    arr[out] = arr[i];
+    ctx.stats.Move();
+    if (count_arr)
+      count_arr[out] = 1;
+    ++out;
+  }
+  ctx.stats.Leave();
+}
+
+SORT_TYPES_INSTANTIATE(BasicQuickSort3Way)
+} // namespace hedger
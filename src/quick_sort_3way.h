@@ -0,0 +1,94 @@
+// quick_sort_3way.h
+//
+// Three-way (Dutch national flag) quick sort, with fused sort+unique and
+// sort+count.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef QUICK_SORT_3WAY_H_
+#define QUICK_SORT_3WAY_H_
+
+#include "algo.h"
+#include "roofline.h"
+
+namespace hedger
+{
+// QuickSort3Way
+// Quick sort that splits each range into keys less than, equal to and
+// greater than a random pivot (Dijkstra's Dutch national flag).  Equal
+// keys are final after one pass, so a range of k distinct keys costs
+// O(n log k) rather than the O(n^2) a two-way partition pays when every
+// key is equal.
+// SortUnique() and SortCount() visit the ranges in order and write each
+// equal range out as one key (and its count) as soon as it is final, so
+// the sorted duplicates are never written back or scanned again.
+template <class T, class Compare = std::less<T> >
+class BasicQuickSort3Way : public BasicAlgo<T, Compare>
+{
+ public:
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicQuickSort3Way();
+  virtual ~BasicQuickSort3Way();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Quick Sort 3-Way"; }
+  bool CanInstrument() { return true; }
+  // Each partition level reads and writes its ranges once
+  double GetMemoryBytes(size_t size) {
+    return 2.0 * size * sizeof(T) * RooflineLevels(size * sizeof(T));
+  }
+  // Fused outputs (instrumented like Test when SetInstrumented(true))
+  // Sort and keep one of each key at the front of arr
+  // Exit: distinct keys
+  size_t SortUnique(T *arr, size_t size);
+  // As SortUnique, with each key's count in count_arr (size long)
+  // Exit: distinct keys
+  size_t SortCount(T *arr, size_t size, size_t *count_arr);
+ private:
+  template <class Stats>
+    void SortRecurse(Context<Stats>& ctx, size_t start, size_t end);
+  template <class Stats> void SortEmit(
+    Context<Stats>& ctx,
+    size_t start,
+    size_t end,
+    size_t& out,
+    size_t *count_arr
+  );
+  template <class Stats> void Partition(
+    Context<Stats>& ctx,
+    size_t start,
+    size_t end,
+    size_t& lt,
+    size_t& gt
+  );
+  template <class Stats>
+    void InsertionSort(Context<Stats>& ctx, size_t start, size_t end);
+  // Swap two array values identified by index
+  template <class Stats>
+    inline void Swap(Context<Stats>& ctx, size_t index_a, size_t index_b) {
+    ctx.stats.Swap();
+    T swap = ctx.arr[index_a];
+    ctx.arr[index_a] = ctx.arr[index_b];
+    ctx.arr[index_b] = swap;
+  }
+};
+
+typedef BasicQuickSort3Way<hedger::S_T> QuickSort3Way;
+}
+
+#endif // QUICK_SORT_3WAY_H_
@@ -0,0 +1,268 @@
+// quick_sort_incremental.cc
+//
+// Incremental quick sort: a lazy iterator that yields keys in sorted order
+// and sorts only as far as it has been read.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+#include <cstddef>
+#include <algorithm>
+
+#include "quick_sort_incremental.h"
+#include "sorting_network.h"
+#include "sort_types.h"
+
+namespace hedger {
+
+// Ranges this small are insertion sorted whole instead of partitioned
+const size_t kIncrementalInsertionMax = 16;
+// Pivot stack entries reserved up front (the expected depth is log n)
+const size_t kIncrementalStackReserve = 64;
+
+template <class T, class Compare>
+BasicQuickSortIncremental<T, Compare>::BasicQuickSortIncremental() {
+}
+
+template <class T, class Compare>
+BasicQuickSortIncremental<T, Compare>::~BasicQuickSortIncremental() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class: read
+// every key, which sorts the whole array.
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+//
+template <class T, class Compare>
+int BasicQuickSortIncremental<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+  IncrementalState state;
+  Reset(state, size);
+  if (this->instrumented_) {
+    Context<CountStats> ctx(array, this->less_);
+    Advance(ctx, state, size);
+    this->Finish(ctx.stats);
+  } else {
+    Context<NoStats> ctx(array, this->less_);
+    Advance(ctx, state, size);
+  }
+  return 0;
+}
+
+// TestCounted
+// Entry: pointer to array
+//        size of array
+//        range (ignored)
+//        stats to add this call's counts to
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicQuickSortIncremental<T, Compare>::TestCounted(
+  T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
+{
+  if (nullptr == array || size < 2)
+    return 0;
+  IncrementalState state;
+  Reset(state, size);
+  Context<CountStats> ctx(array, this->less_);
+  Advance(ctx, state, size);
+  this->Finish(ctx.stats, &stats);
+  return 0;
+}
+
+//
+// Iterator
+//
+
+// Constructor
+// Entry: engine (for its comparator and small-sort setting)
+//        pointer to array
+//        size of array
+template <class T, class Compare>
+BasicQuickSortIncremental<T, Compare>::Iterator::Iterator(
+  BasicQuickSortIncremental *engine,
+  T *arr,
+  size_t size) : engine_(engine), ctx_(arr, engine->less_)
+{
+  Reset(state_, nullptr == arr ? 0 : size);
+}
+
+// Next
+// Exit: pointer to the next key in order (valid until the iterator is
+//       destroyed), or nullptr at the end
+template <class T, class Compare>
+const T *BasicQuickSortIncremental<T, Compare>::Iterator::Next()
+{
+  if (!engine_->Advance(ctx_, state_, 1))
+    return nullptr;
+  return &ctx_.arr[state_.pos - 1];
+}
+
+// Read
+// Entry: output, room for k keys
+//        keys wanted
+// Exit:  keys copied
+template <class T, class Compare>
+size_t BasicQuickSortIncremental<T, Compare>::Iterator::Read(
+  T *out,
+  size_t k)
+{
+  size_t start = state_.pos;
+  size_t n = engine_->Advance(ctx_, state_, k);
+  std::copy(&ctx_.arr[start], &ctx_.arr[start] + n, out);
+  return n;
+}
+
+// Advance
+// Entry: keys wanted
+// Exit:  keys stepped past
+template <class T, class Compare>
+size_t BasicQuickSortIncremental<T, Compare>::Iterator::Advance(size_t k)
+{
+  return engine_->Advance(ctx_, state_, k);
+}
+
+//
+// Class-specific Implementation
+//
+
+// Reset
+// Entry: state to start over
+//        size of array
+template <class T, class Compare>
+void BasicQuickSortIncremental<T, Compare>::Reset(
+  IncrementalState& state,
+  size_t size)
+{
+  state.size = size;
+  state.pos = state.sorted_end = 0;
+  state.pivot_stack.clear();
+  state.pivot_stack.reserve(kIncrementalStackReserve);
+  state.pivot_stack.push_back(size);
+}
+
+// Advance
+// Entry: sort context
+//        state of the lazy sort
+//        keys wanted
+// Exit:  keys stepped past (fewer than k only at the end)
+template <class T, class Compare>
+template <class Stats>
+size_t BasicQuickSortIncremental<T, Compare>::Advance(
+  Context<Stats>& ctx,
+  IncrementalState& state,
+  size_t k)
+{
+  size_t start = state.pos;
+  while (k && state.pos < state.size) {
+    if (state.pos == state.sorted_end)
+      Settle(ctx, state);
+    size_t n = std::min(k, state.sorted_end - state.pos);
+    state.pos += n;
+    k -= n;
+  }
+  return state.pos - start;
+}
+
+// Settle
+// Make the key at pos final, and with it every key up to the pivot that
+// bounds its range (or, when a pivot turns out least, every key equal to
+// it).
+// Entry: sort context
+//        state of the lazy sort, with pos == sorted_end < size
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSortIncremental<T, Compare>::Settle(
+  Context<Stats>& ctx,
+  IncrementalState& state)
+{
+  size_t start = state.pos;
+  std::vector<size_t>& stack = state.pivot_stack;
+  // Keys before the pivot on top are all less than it, so partitioning
+  // only that range is enough to place the next pivot.
+  while (stack.back() - start > kIncrementalInsertionMax) {
+    size_t end = stack.back() - 1;
+    size_t pivot = start + ctx.Random() % (end - start + 1);
+    this->Swap(ctx, (int) pivot, (int) end);
+    pivot = (size_t) this->Partition(ctx, (int) start, (int) end);
+    if (pivot == start) {
+      // The pivot is the least key of the range, so every key equal to it
+      // is final as well.  Gather them now: left to the partition they
+      // would be split off one at a time, quadratic on runs of equal keys.
+      T *arr = ctx.arr;
+      size_t equal_end = start + 1;
+      for (size_t i = start + 1; i <= end; ++i) {
+        if (!ctx.Less(arr[start], arr[i]))
+          this->Swap(ctx, (int) i, (int) equal_end++);
+      }
+      state.sorted_end = equal_end;
+      return;
+    }
+    stack.push_back(pivot);
+  }
+  size_t bound = stack.back();
+  stack.pop_back();
+  InsertionSort(ctx, start, bound);
+  // The bounding pivot is final too (unless it is the size sentinel).
+  state.sorted_end = bound < state.size ? bound + 1 : bound;
+}
+
+// InsertionSort
+// Entry: sort context
+//        start index
+//        end index (exclusive)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSortIncremental<T, Compare>::InsertionSort(
+  Context<Stats>& ctx,
+  size_t start,
+  size_t end)
+{
+  T *arr = ctx.arr;
+  size_t size = end - start;
+  if (size <= this->small_sort_max_ &&
+      SortNetwork(&arr[start], size, ctx.CountedLess()))
+    return;
+  for (size_t i = start + 1; i < end; ++i) {
+    T key = arr[i];
+    size_t j = i;
+    while (j > start && ctx.Less(key, arr[j - 1])) {
+      arr[j] = arr[j - 1];
+      ctx.stats.Move();
+      --j;
+    }
+    arr[j] = key;
+    ctx.stats.Move(2);
+  }
+}
+
+SORT_TYPES_INSTANTIATE(BasicQuickSortIncremental)
+} // namespace hedger
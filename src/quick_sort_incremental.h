@@ -0,0 +1,104 @@
+// quick_sort_incremental.h
+//
+// Incremental quick sort: a lazy iterator that yields keys in sorted order
+// and sorts only as far as it has been read.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef QUICK_SORT_INCREMENTAL_H_
+#define QUICK_SORT_INCREMENTAL_H_
+
+#include <vector>
+
+#include "quick_sort.h"
+
+namespace hedger
+{
+// IncrementalState
+// How far one lazy sort has got.  Keys before sorted_end are final; the
+// stack holds the indices of the pivots placed beyond it, nearest on top,
+// with size at the bottom as a sentinel.
+struct IncrementalState {
+  size_t size;
+  size_t pos;                   // next key to hand out
+  size_t sorted_end;            // one past the last final key
+  std::vector<size_t> pivot_stack;
+};
+
+// QuickSortIncremental
+// Incremental quick sort (Paredes and Navarro).  To produce the key at
+// pos, the range from pos to the nearest placed pivot is partitioned with
+// QuickSort::Partition around a random pivot, and the pivot's index is
+// pushed, until the range is small enough to insertion sort; every pivot
+// placed stays on the stack and bounds the next range.  Reading the first
+// k keys costs O(n + k log k) expected, and reading all of them is a
+// randomized quick sort, so a consumer that stops early pays only for what
+// it read.  Iterator sorts the array in place as it goes: after k keys,
+// arr[0 .. k) is sorted.  Test() reads every key.
+template <class T, class Compare = std::less<T> >
+class BasicQuickSortIncremental : public BasicQuickSort<T, Compare>
+{
+ public:
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicQuickSortIncremental();
+  virtual ~BasicQuickSortIncremental();
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
+  const char *GetName() { return "Quick Sort Incremental"; }
+
+  // Iterator
+  // One lazy sort in progress.  It holds the array, which must outlive it
+  // and not be touched by anyone else until the iterator is done with it.
+  class Iterator
+  {
+   public:
+    Iterator(BasicQuickSortIncremental *engine, T *arr, size_t size);
+    // Next key in order, or nullptr at the end
+    const T *Next();
+    // Copy out up to k next keys in order
+    // Exit: keys copied
+    size_t Read(T *out, size_t k);
+    // Step past up to k next keys in order, leaving them sorted in place
+    // Exit: keys stepped past
+    size_t Advance(size_t k);
+    // Keys handed out so far; arr[0 .. GetPosition()) is sorted
+    size_t GetPosition() { return state_.pos; }
+    bool Done() { return state_.pos == state_.size; }
+   private:
+    BasicQuickSortIncremental *engine_;
+    Context<NoStats> ctx_;
+    IncrementalState state_;
+  };
+  Iterator Begin(T *arr, size_t size) { return Iterator(this, arr, size); }
+
+ private:
+  static void Reset(IncrementalState& state, size_t size);
+  template <class Stats>
+    size_t Advance(Context<Stats>& ctx, IncrementalState& state, size_t k);
+  template <class Stats>
+    void Settle(Context<Stats>& ctx, IncrementalState& state);
+  template <class Stats>
+    void InsertionSort(Context<Stats>& ctx, size_t start, size_t end);
+};
+
+typedef BasicQuickSortIncremental<hedger::S_T> QuickSortIncremental;
+}
+
+#endif // QUICK_SORT_INCREMENTAL_H_
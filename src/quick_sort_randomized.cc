@@ -25,43 +25,121 @@
 #include <cstddef>
 
 #include "quick_sort_randomized.h"
+#include "sorting_network.h"
+#include "sort_types.h"
 
 namespace hedger {
 
-QuickSortRandomized::QuickSortRandomized() {
+template <class T, class Compare>
+BasicQuickSortRandomized<T, Compare>::BasicQuickSortRandomized() {
 }
 
-QuickSortRandomized::~QuickSortRandomized() {
+template <class T, class Compare>
+BasicQuickSortRandomized<T, Compare>::~BasicQuickSortRandomized() {
+}
+
+// Test
+// Implement the Test function as dictated by the Algo parent class
+// Entry: pointer to array
+//        size of array
+// Exit:  Result of test
+//
+template <class T, class Compare>
+int BasicQuickSortRandomized<T, Compare>::Test(
+  T *array,
+  size_t size,
+  hedger::S_T range)
+{
+  int result = 0;
+  if (this->instrumented_)
+    Sort<CountStats>(array, 0, size - 1);
+  else
+    Sort<NoStats>(array, 0, size - 1);
+  return result;
+}
+
+// TestCounted
+// Entry: pointer to array
+//        size of array
+//        range (ignored)
+//        stats to add this call's counts to
+// Exit:  0 == success
+template <class T, class Compare>
+int BasicQuickSortRandomized<T, Compare>::TestCounted(
+  T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
+{
+  Sort<CountStats>(array, 0, size - 1, &stats);
+  return 0;
 }
 
 // RadomizedPartition
 // Take a partition from a random spot within the distribution.
 // (Per T. Corman "Introduction to Algorithms" p. 179)
-// Entry: array
+// Entry: sort context
 //        start index
 //        end index
 // Exit: partition index
-int QuickSortRandomized::RandomizedPartition(int start, int end)
+template <class T, class Compare>
+template <class Stats>
+int BasicQuickSortRandomized<T, Compare>::RandomizedPartition(
+  Context<Stats>& ctx,
+  int start,
+  int end)
 {
-    int i = (rand() % (end - start)) + start;
-    Swap(i, end - 1);
-    return Partition(start, end);
+    int i = (ctx.Random() % (end - start)) + start;
+    this->Swap(ctx, i, end - 1);
+    return this->Partition(ctx, start, end);
 }
 
 // SortRecurse
 // Perform the sorting.
 // TODO: Apply R.C. Singleton's optimization (Knuth Vol.3 2nd Ed. p.123) or
 //   a variant thereof to avoid the O(n^2) penalty for an already-sorted array.
-// Entry: start index
+// Entry: sort context
+//        start index
 //        end index
-void QuickSortRandomized::SortRecurse(int start, int end)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSortRandomized<T, Compare>::SortRecurse(
+  Context<Stats>& ctx,
+  int start,
+  int end)
 {
-  IncMaxRecurseDepth();
-  if (start < end) {
-    int partition = RandomizedPartition(start, end);
-    SortRecurse(start, partition - 1);
-    SortRecurse(partition + 1, end);
+  ctx.stats.Enter();
+  size_t size = end - start + 1;
+  if (start < end &&
+      !(size <= this->small_sort_max_ &&
+        SortNetwork(&ctx.arr[start], size, ctx.CountedLess()))) {
+    int partition = RandomizedPartition(ctx, start, end);
+    SortRecurse(ctx, start, partition - 1);
+    SortRecurse(ctx, partition + 1, end);
   }
-  DecMaxRecurseDepth();
+  ctx.stats.Leave();
 }
+
+// Sort
+// API entry for sort.
+// Entry: pointer to array
+//        start index
+//        end index
+//        stats to add to (nullptr == the instance's)
+template <class T, class Compare>
+template <class Stats>
+void BasicQuickSortRandomized<T, Compare>::Sort(
+  T *arr,
+  int start,
+  int end,
+  SortStats *sink)
+{
+  if ((start < end) && nullptr != arr) {
+    Context<Stats> ctx(arr, this->less_);
+    SortRecurse(ctx, start, end);
+    this->Finish(ctx.stats, sink);
+  }
+}
+
+SORT_TYPES_INSTANTIATE(BasicQuickSortRandomized)
 } // namespace hedger
@@ -27,16 +27,27 @@
 
 namespace hedger
 {
-class QuickSortRandomized : public QuickSort
+template <class T, class Compare = std::less<T> >
+class BasicQuickSortRandomized : public BasicQuickSort<T, Compare>
 {
  public:
-  QuickSortRandomized();
-  ~QuickSortRandomized();
+  template <class Stats> using Context = SortContext<Stats, T, Compare>;
+  BasicQuickSortRandomized();
+  ~BasicQuickSortRandomized();
   const char *GetName() { return "Quick Sort Randomized Partition"; }
+  int Test(T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
  protected:
-  int RandomizedPartition(int start, int end);
-  virtual void SortRecurse(int start, int end);
+  template <class Stats>
+    void Sort(T *arr, int start, int end, SortStats *sink = nullptr);
+  template <class Stats>
+    int RandomizedPartition(Context<Stats>& ctx, int start, int end);
+  template <class Stats>
+    void SortRecurse(Context<Stats>& ctx, int start, int end);
 };
+
+typedef BasicQuickSortRandomized<hedger::S_T> QuickSortRandomized;
 }
 
 #endif // QUICK_SORT_H_
@@ -22,10 +22,9 @@
 
 #include <stdio.h>
 #include <cstddef>
-#include <malloc.h>
-#include <memory.h>
 
 #include "radix_sort.h"
+#include "sorting_network.h"
 
 namespace hedger {
 
@@ -43,79 +42,67 @@ RadixSort::~RadixSort() {
 //
 int RadixSort::Test(hedger::S_T *array, size_t size, hedger::S_T range)
 {
-  int result = 0;
-  Sort(array, size, 256);
+  if (!instrumented_)
+    return Sort(array, size, nullptr);
+  CountStats stats;
+  int result = Sort(array, size, &stats);
+  Finish(stats);
   return result;
 }
 
-//
-// Class-specific Implementation
-//
-
-// GetMax
-// A utility function to get maximum value in arr[]
-hedger::S_T RadixSort::GetMax(hedger::S_T *arr, int size)
+// TestCounted
+// Implementation of Algo's TestCounted()
+// Entry: pointer to array
+//        size of array
+//        range (unused)
+//        stats the call's counts are added to
+// Exit:  Result of test
+int RadixSort::TestCounted(
+  hedger::S_T *array,
+  size_t size,
+  hedger::S_T range,
+  SortStats& stats)
 {
-  int max = arr[0];
-  for (int i = 1; i < size; i++)
-    if (arr[i] > max)
-      max = arr[i];
-  return max;
+  CountStats counted;
+  int result = Sort(array, size, &counted);
+  Finish(counted, &stats);
+  return result;
 }
 
-// CountSort
-// Perform a counting sort on the given data
-// the digit represented by exp.
-void RadixSort::CountSort(int arr[], int size, int exp, int radix)
-{
-  int *output = (int *) malloc(size * sizeof(hedger::S_T)); // output array
-  int *count = (int *) malloc(radix * sizeof(hedger::S_T));
-  int i;
-  memset(count, 0, radix * sizeof(int));
-
-  if (nullptr == output || nullptr == count) {
-    // TODO: LOG ERROR
-    return;
-  }
-
-  // Store count of occurrences in count[]
-  for (i = 0; i < size; i++)
-    ++count[ arr[i] / exp % radix ];
-
-  // Change count[i] so that count[i] now contains actual
-  //  position of this digit in output[]
-  for (i = 1; i < radix; i++)
-    count[i] += count[i - 1];
-
-  // Build the output array
-  for (i = size - 1; i >= 0; --i)
-  {
-    output[count[ arr[i] / exp % radix ] - 1] = arr[i];
-    --count[ arr[i] / exp % radix ];
-  }
-
-  // Copy the output array to arr[], so that arr[] now
-  // contains sorted numbers according to current digit
-  memcpy(arr, output, size * sizeof(int));
-  free(output);
-}
+//
+// Class-specific Implementation
+//
 
 // Sort
-// API entry for sort.
+// API entry for sort.  Keys go through KeyTraits, so negative values sort
+// correctly and passes over a byte every key shares are skipped.
 // Entry: pointer to array
-//        start index
-//        end index
-void RadixSort::Sort(hedger::S_T *arr, int size, int radix)
+//        size of array
+//        stats to count digit passes into (nullptr == not counted)
+// Exit:  0 == success
+int RadixSort::Sort(hedger::S_T *arr, size_t size, CountStats *stats)
 {
   if (size && nullptr != arr) {
-
-    hedger::S_T max = GetMax(arr, size);
-
-    // Do counting sort for every digit. Note that instead
-    // of passing digit number, exp is passed. exp is radix^i
-    // where i is current digit number
-    for (long long exp = 1; max / exp > 0; exp *= radix)
-      CountSort(arr, size, (int) exp, radix);
+    if (size <= small_sort_max_) {
+      bool sorted = stats ? SortNetwork(arr, size,
+        StatsLess<CountStats, std::less<hedger::S_T> >(*stats, less_)) :
+        SortNetwork(arr, size);
+      if (sorted) {
+        if (stats)
+          stats->pass_tot = 0;
+        return 0;
+      }
+    }
+    int pass_tot = 0;
+    int result = KeyRadixSort<hedger::S_T>(arr, size, arena_,
+      stats ? &pass_tot : nullptr);
+    if (stats) {
+      // Each digit pass scatters every key once
+      stats->pass_tot = pass_tot;
+      stats->Move(size * pass_tot);
+    }
+    return result;
   }
+  return 0;
 }
 } // namespace hedger
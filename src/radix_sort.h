@@ -24,6 +24,8 @@
 #define RADIX_SORT_H_
 
 #include "algo.h"
+#include "key_sort.h"
+#include "roofline.h"
 
 namespace hedger
 {
@@ -33,11 +35,33 @@ class RadixSort : public Algo
   RadixSort();
   virtual ~RadixSort();
   virtual int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  int TestCounted(hedger::S_T *arr, size_t size, hedger::S_T range,
+    SortStats& stats);
   virtual const char *GetName() { return "Radix Sort"; }
+  // Counts the digit passes made and the keys each one moves
+  bool CanInstrument() { return true; }
+  size_t GetScratchSize(size_t size) {
+    return KeyRadixScratchSize<hedger::S_T>(size);
+  }
+  // The transform and transform-back passes, and each digit pass, read
+  // and write the keys once; the histograms stay in cache.  Without a
+  // count every key byte is assumed to take a pass; the instrumented call
+  // counts the passes made, less those over a byte every key shares.
+  double GetMemoryBytes(size_t size) {
+    return ModelBytes(size, sizeof(hedger::S_T));
+  }
+  double GetMemoryBytes(size_t size, const SortStats& stats) {
+    return ModelBytes(size, stats.pass_tot < 0 ?
+      (int) sizeof(hedger::S_T) : stats.pass_tot);
+  }
  protected:
-  hedger::S_T GetMax(hedger::S_T *arr, int n);
-  void CountSort(int arr[], int n, int exp, int radix);
-  virtual void Sort(hedger::S_T *arr, int start, int radix);
+  virtual int Sort(hedger::S_T *arr, size_t size, CountStats *stats);
+  double ModelBytes(size_t size, int pass_tot) {
+    size_t bytes = size * sizeof(hedger::S_T);
+    if (!RooflineBeyondCache(3 * bytes))
+      return 0.0;
+    return 2.0 * bytes * (2 + pass_tot);
+  }
 };
 }
 
@@ -0,0 +1,236 @@
+// roofline.cc
+//
+// Memory bandwidth roofline: STREAM-style measurement of sustained read,
+// write and copy bandwidth, and the cache model engines use to declare
+// the memory traffic of a sort.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "roofline.h"
+#include "cache_info.h"
+
+namespace hedger {
+
+// Each STREAM array is this many times the last-level cache...
+const size_t kStreamCacheMultiple = 4;
+// ...within these bounds
+const size_t kStreamBytesMin = 64 * 1024 * 1024;
+const size_t kStreamBytesMax = 256 * 1024 * 1024;
+// Repetitions of each kernel; the best is kept
+const int kStreamRepeat = 5;
+
+// StreamKernel
+enum StreamKernel {
+  kStreamRead,
+  kStreamWrite,
+  kStreamCopy,
+  kStreamKernelTot
+};
+
+// StreamTask
+// One thread's slice of a kernel
+struct StreamTask {
+  StreamKernel kernel;
+  uint64_t *src;
+  uint64_t *dst;
+  size_t size;                  // elements
+  std::atomic<int> *ready;      // threads waiting to start
+  std::atomic<bool> *go;        // set when the clock starts
+  uint64_t sum;                 // read result, kept so it is not elided
+};
+
+// StreamRun
+// Run the kernel on one slice.
+// Entry: task
+static void StreamRun(StreamTask& task)
+{
+  const uint64_t *src = task.src;
+  uint64_t *dst = task.dst;
+  size_t size = task.size;
+  switch (task.kernel) {
+    case kStreamRead: {
+      // Independent sums, so the adds do not serialize on one register
+      uint64_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+      size_t i = 0;
+      for (; i + 4 <= size; i += 4) {
+        sum0 += src[i];
+        sum1 += src[i + 1];
+        sum2 += src[i + 2];
+        sum3 += src[i + 3];
+      }
+      for (; i < size; ++i)
+        sum0 += src[i];
+      task.sum = sum0 + sum1 + sum2 + sum3;
+      break;
+    }
+    case kStreamWrite:
+      for (size_t i = 0; i < size; ++i)
+        dst[i] = i;
+      break;
+    case kStreamCopy:
+      for (size_t i = 0; i < size; ++i)
+        dst[i] = src[i];
+      break;
+    default:
+      break;
+  }
+}
+
+// StreamWorker
+// Thread body: report ready, wait for the start, run the slice.
+// Entry: pointer to StreamTask
+static void *StreamWorker(void *param)
+{
+  StreamTask *task = (StreamTask *) param;
+  task->ready->fetch_add(1, std::memory_order_release);
+  while (!task->go->load(std::memory_order_acquire))
+    sched_yield();
+  StreamRun(*task);
+  return nullptr;
+}
+
+// RunStreamKernel
+// Run one kernel over the whole arrays, the last slice on the calling
+// thread.  The clock starts once every thread is waiting; a slice whose
+// thread cannot be created runs on the calling thread instead.
+// Entry: kernel
+//        source and destination arrays
+//        elements in each
+//        threads
+// Exit:  seconds
+static double RunStreamKernel(
+  StreamKernel kernel,
+  uint64_t *src,
+  uint64_t *dst,
+  size_t size,
+  size_t thread_tot)
+{
+  std::atomic<int> ready(0);
+  std::atomic<bool> go(false);
+  std::vector<StreamTask> task_arr(thread_tot);
+  size_t slice = (size + thread_tot - 1) / thread_tot;
+  for (size_t i = 0; i < thread_tot; ++i) {
+    size_t start = std::min(size, i * slice);
+    task_arr[i].kernel = kernel;
+    task_arr[i].src = &src[start];
+    task_arr[i].dst = &dst[start];
+    task_arr[i].size = std::min(slice, size - start);
+    task_arr[i].ready = &ready;
+    task_arr[i].go = &go;
+    task_arr[i].sum = 0;
+  }
+  std::vector<pthread_t> thread_arr(thread_tot);
+  std::vector<bool> started_arr(thread_tot, false);
+  int started_tot = 0;
+  for (size_t i = 0; i + 1 < thread_tot; ++i) {
+    started_arr[i] = !pthread_create(&thread_arr[i], nullptr, StreamWorker,
+      &task_arr[i]);
+    if (started_arr[i])
+      ++started_tot;
+    // TODO: LOG ERROR when a thread cannot be created
+  }
+  while (ready.load(std::memory_order_acquire) < started_tot)
+    sched_yield();
+
+  auto start = std::chrono::high_resolution_clock::now();
+  go.store(true, std::memory_order_release);
+  for (size_t i = 0; i < thread_tot; ++i) {
+    if (!started_arr[i])
+      StreamRun(task_arr[i]);
+  }
+  for (size_t i = 0; i + 1 < thread_tot; ++i) {
+    if (started_arr[i])
+      pthread_join(thread_arr[i], nullptr);
+  }
+  auto stop = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(stop - start).count();
+}
+
+// MeasureStreamBandwidth
+// Entry: threads
+//        out: bandwidth
+// Exit:  true == measured
+bool MeasureStreamBandwidth(int thread_tot, StreamBandwidth& bandwidth)
+{
+  if (thread_tot < 1)
+    thread_tot = 1;
+  size_t bytes = CacheInfo::Get().GetL3() * kStreamCacheMultiple;
+  bytes = std::max(kStreamBytesMin, std::min(kStreamBytesMax, bytes));
+  size_t size = bytes / sizeof(uint64_t);
+  uint64_t *src = new (std::nothrow) uint64_t[size];
+  uint64_t *dst = new (std::nothrow) uint64_t[size];
+  bool result = nullptr != src && nullptr != dst;
+  if (result) {
+    // Each thread first-touches its own slices, as it will later read them.
+    RunStreamKernel(kStreamWrite, dst, src, size, thread_tot);
+    RunStreamKernel(kStreamWrite, src, dst, size, thread_tot);
+    double best[kStreamKernelTot] = { 0.0, 0.0, 0.0 };
+    for (int repeat = 0; repeat < kStreamRepeat; ++repeat) {
+      for (int kernel = 0; kernel < kStreamKernelTot; ++kernel) {
+        double seconds = RunStreamKernel((StreamKernel) kernel, src, dst,
+          size, thread_tot);
+        if (seconds > 0.0 && (!best[kernel] || seconds < best[kernel]))
+          best[kernel] = seconds;
+      }
+    }
+    for (int kernel = 0; kernel < kStreamKernelTot; ++kernel)
+      result = result && best[kernel] > 0.0;
+    if (result) {
+      bandwidth.read = size * sizeof(uint64_t) / best[kStreamRead] / 1e9;
+      bandwidth.write = size * sizeof(uint64_t) / best[kStreamWrite] / 1e9;
+      bandwidth.copy =
+        2.0 * size * sizeof(uint64_t) / best[kStreamCopy] / 1e9;
+    }
+  }
+  delete [] src;
+  delete [] dst;
+  return result;
+}
+
+// RooflineLevels
+// Entry: working set of the top level, in bytes
+// Exit:  levels
+int RooflineLevels(size_t bytes)
+{
+  size_t cache = CacheInfo::Get().GetL3();
+  int level_tot = 0;
+  for (; bytes > cache; bytes >>= 1)
+    ++level_tot;
+  return level_tot;
+}
+
+// RooflineBeyondCache
+// Entry: working set, in bytes
+// Exit:  true == it does not fit the last-level cache
+bool RooflineBeyondCache(size_t bytes)
+{
+  return bytes > CacheInfo::Get().GetL3();
+}
+}
@@ -0,0 +1,67 @@
+// roofline.h
+//
+// Memory bandwidth roofline: STREAM-style measurement of sustained read,
+// write and copy bandwidth, and the cache model engines use to declare
+// the memory traffic of a sort.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef ROOFLINE_H_
+#define ROOFLINE_H_
+
+#include <cstddef>
+
+namespace hedger
+{
+// An engine reaching this share of the copy bandwidth is memory-bound
+const double kRooflineBoundPct = 70.0;
+
+// StreamBandwidth
+// Best sustained rates, in GB/s (10^9 bytes), as STREAM counts them: copy
+// is bytes read plus bytes written, with no write-allocate traffic.
+struct StreamBandwidth {
+  double read;
+  double write;
+  double copy;
+};
+
+// MeasureStreamBandwidth
+// Time read (sum), write (fill) and copy kernels over arrays several times
+// the last-level cache, split across thread_tot threads, and keep the best
+// of a few repetitions of each.
+// Entry: threads
+//        out: bandwidth
+// Exit:  true == measured
+bool MeasureStreamBandwidth(int thread_tot, StreamBandwidth& bandwidth);
+
+// RooflineLevels
+// Levels of a halving recursion (merge or quick sort) whose working set is
+// too big for the last-level cache, so each of them streams through
+// memory.  Levels below those run from cache and cost no memory traffic.
+// Entry: working set of the top level, in bytes
+// Exit:  levels
+int RooflineLevels(size_t bytes);
+
+// RooflineBeyondCache
+// Entry: working set, in bytes
+// Exit:  true == it does not fit the last-level cache
+bool RooflineBeyondCache(size_t bytes);
+}
+
+#endif // ROOFLINE_H_
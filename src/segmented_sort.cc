@@ -0,0 +1,210 @@
+// segmented_sort.cc
+//
+// Sorts many small independent segments of one flat buffer in parallel.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include <cstddef>
+#include <thread>
+
+#include "segmented_sort.h"
+#include "sorting_network.h"
+#include "insertion_sort.h"
+#include "radix_sort.h"
+
+namespace hedger {
+
+// Elements per batch.  Large enough that claiming a batch is rare, small
+// enough that the last few batches still spread across threads.
+const size_t kBatchElementMin = 1 << 14;
+// Segments up to this size use insertion sort when choosing by size;
+// smaller ones take the sorting network.
+const size_t kSegmentInsertionMax = 64;
+
+// Constructor
+SegmentedSort::SegmentedSort() {
+  create_ = nullptr;
+  arena_ = nullptr;
+  thread_max_ = std::thread::hardware_concurrency();
+  if (thread_max_ < 1)
+    thread_max_ = 1;
+}
+
+// Destructor
+SegmentedSort::~SegmentedSort() {
+}
+
+// GetName
+// Exit: name of the engine applied to segments
+const char *SegmentedSort::GetName()
+{
+  if (nullptr == create_)
+    return "Size-Adaptive";
+  Algo *algo = create_();
+  snprintf(name_, sizeof(name_), "%s", algo->GetName());
+  delete algo;
+  return name_;
+}
+
+// GetScratchSize
+// Arena room for every worker's engines on segments of up to segment_max
+// keys.
+// Entry: largest segment
+// Exit:  bytes
+size_t SegmentedSort::GetScratchSize(size_t segment_max)
+{
+  Algo *algo = create_ ? create_() : new RadixSort();
+  size_t part_size = Arena::Round(algo->GetScratchSize(segment_max));
+  delete algo;
+  return part_size * thread_max_;
+}
+
+// Sort
+// Sort every segment in place.
+// Entry: pointer to flat buffer
+//        segment offsets (segment_tot + 1 entries, ascending)
+//        number of segments
+// Exit:  0 == success
+int SegmentedSort::Sort(
+  hedger::S_T *data,
+  const size_t *offsets,
+  size_t segment_tot)
+{
+  if (nullptr == data || nullptr == offsets || !segment_tot)
+    return 0;
+
+  // Cut the segments into batches of at least kBatchElementMin elements.
+  SegmentedSortContext ctx;
+  ctx.data = data;
+  ctx.offsets = offsets;
+  ctx.create = create_;
+  ctx.arena = arena_;
+  ctx.worker_next = 0;
+  size_t batch_start = 0;
+  for (size_t i = 0; i < segment_tot; ++i) {
+    if (offsets[i + 1] - offsets[batch_start] >= kBatchElementMin) {
+      ctx.batch_arr.push_back(batch_start);
+      batch_start = i + 1;
+    }
+  }
+  if (batch_start < segment_tot)
+    ctx.batch_arr.push_back(batch_start);
+  ctx.batch_arr.push_back(segment_tot);
+  ctx.batch_next = 0;
+
+  // No more threads than batches; the calling thread works too.
+  int thread_tot = thread_max_;
+  if ((size_t) thread_tot > ctx.batch_arr.size() - 1)
+    thread_tot = ctx.batch_arr.size() - 1;
+  if (arena_)
+    arena_->Split(thread_tot);
+  // A thread that fails to start is not joined; the others, and the
+  // calling thread, claim its batches.
+  std::vector<pthread_t> thread_arr(thread_tot);
+  std::vector<bool> started_arr(thread_tot, false);
+  for (int i = 1; i < thread_tot; ++i) {
+    started_arr[i] = !pthread_create(
+      &thread_arr[i],
+      NULL,
+      &SegmentedSort::Worker,
+      (void *) &ctx);
+    if (!started_arr[i]) {
+      // TODO: LOG ERROR
+    }
+  }
+  Worker((void *) &ctx);
+  for (int i = 1; i < thread_tot; ++i) {
+    void *result;
+    if (started_arr[i])
+      pthread_join(thread_arr[i], &result);
+  }
+  return 0;
+}
+
+//
+// Class-specific Implementation
+//
+
+// Worker
+// Claim and sort batches until none are left.  Each thread owns its
+// engine instances and arena part, so neither is ever shared.
+// Entry: pointer to SegmentedSortContext
+// Exit:  nullptr (ignored)
+void *SegmentedSort::Worker(void *params)
+{
+  SegmentedSortContext *ctx = (SegmentedSortContext *) params;
+  Algo *large_sort = nullptr;
+  Algo *insertion_sort = nullptr;
+  if (ctx->create) {
+    large_sort = ctx->create();
+  } else {
+    // Radix sort takes any key since the key transform; see key_sort.h
+    large_sort = new RadixSort();
+    insertion_sort = new InsertionSort();
+  }
+  if (ctx->arena) {
+    Arena *part =
+      ctx->arena->GetPart(__sync_fetch_and_add(&ctx->worker_next, 1));
+    large_sort->SetArena(part);
+  }
+
+  size_t batch_tot = ctx->batch_arr.size() - 1;
+  for (;;) {
+    size_t batch = __sync_fetch_and_add(&ctx->batch_next, 1);
+    if (batch >= batch_tot)
+      break;
+    SortSegments(ctx, large_sort, insertion_sort, batch);
+  }
+
+  delete large_sort;
+  delete insertion_sort;
+  return nullptr;
+}
+
+// SortSegments
+// Sort the segments of one batch.
+// Entry: sort context
+//        radix sort for large segments (or the fixed engine)
+//        insertion sort engine (nullptr with a fixed engine)
+//        batch index
+void SegmentedSort::SortSegments(
+  SegmentedSortContext *ctx,
+  Algo *large_sort,
+  Algo *insertion_sort,
+  size_t batch)
+{
+  const size_t *offsets = ctx->offsets;
+  size_t end = ctx->batch_arr[batch + 1];
+  for (size_t i = ctx->batch_arr[batch]; i < end; ++i) {
+    hedger::S_T *segment = &ctx->data[offsets[i]];
+    size_t size = offsets[i + 1] - offsets[i];
+    if (nullptr == insertion_sort)
+      large_sort->Test(segment, size);
+    else if (size <= kSortNetworkMax)
+      SortNetwork(segment, size);
+    else if (size <= kSegmentInsertionMax)
+      insertion_sort->Test(segment, size);
+    else
+      large_sort->Test(segment, size);
+  }
+}
+} // namespace hedger
@@ -0,0 +1,86 @@
+// segmented_sort.h
+//
+// Sorts many small independent segments of one flat buffer in parallel.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SEGMENTED_SORT_H_
+#define SEGMENTED_SORT_H_
+
+#include <vector>
+
+#include "algo.h"
+
+namespace hedger
+{
+struct SegmentedSortContext;
+
+// Creates an engine instance; each worker thread gets its own.
+typedef Algo *(*AlgoCreate)();
+
+// SegmentedSort
+// Segment i is data[offsets[i] .. offsets[i + 1]).  Consecutive segments
+// are grouped into batches of roughly equal element count, and worker
+// threads claim batches from a shared cursor until none remain.  Unless
+// a fixed engine is set, each segment gets an engine chosen by its size.
+class SegmentedSort
+{
+ public:
+  SegmentedSort();
+  ~SegmentedSort();
+  int Sort(hedger::S_T *data, const size_t *offsets, size_t segment_tot);
+  const char *GetName();
+  // Sort every segment with one engine (nullptr == choose by size)
+  void SetEngine(AlgoCreate create) { create_ = create; }
+  void SetThreadMax(int thread_max) {
+    thread_max_ = thread_max < 1 ? 1 : thread_max;
+  }
+  int GetThreadMax() { return thread_max_; }
+  // Scratch memory, split into one sub-arena per worker (nullptr == heap)
+  void SetArena(Arena *arena) { arena_ = arena; }
+  size_t GetScratchSize(size_t segment_max);
+  static void *Worker(void *params);
+ private:
+  static void SortSegments(
+    SegmentedSortContext *ctx,
+    Algo *large_sort,
+    Algo *insertion_sort,
+    size_t batch
+  );
+  // Configuration
+  AlgoCreate create_;
+  int thread_max_;
+  Arena *arena_;
+  char name_[64];
+};
+
+// SegmentedSortContext
+// Per-sort state shared by the worker threads
+struct SegmentedSortContext {
+  hedger::S_T *data;
+  const size_t *offsets;
+  std::vector<size_t> batch_arr;    // first segment of each batch
+  volatile size_t batch_next;       // next unclaimed batch
+  AlgoCreate create;
+  Arena *arena;                     // split per worker, or nullptr
+  volatile int worker_next;         // next unclaimed arena part
+};
+}
+
+#endif // SEGMENTED_SORT_H_
@@ -0,0 +1,364 @@
+// sort_kernels.cc
+//
+// Hot integer kernels (merge, partition, histogram) compiled for several
+// instruction sets, with the best one the CPU supports chosen at startup.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdint.h>
+#include <string.h>
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SORT_KERNELS_X86
+#endif
+
+#include "sort_kernels.h"
+
+namespace hedger {
+
+//
+// Baseline (scalar, branch-free)
+//
+
+// ScalarMerge
+// Entry: sorted run a and its size
+//        sorted run b and its size
+//        output (a_size + b_size slots)
+static inline void ScalarMerge(
+  const hedger::S_T *a,
+  size_t a_size,
+  const hedger::S_T *b,
+  size_t b_size,
+  hedger::S_T *out)
+{
+  size_t i = 0, j = 0;
+  while (i < a_size && j < b_size) {
+    hedger::S_T x = a[i];
+    hedger::S_T y = b[j];
+    bool take_b = y < x;
+    *out++ = take_b ? y : x;
+    i += !take_b;
+    j += take_b;
+  }
+  while (i < a_size)
+    *out++ = a[i++];
+  while (j < b_size)
+    *out++ = b[j++];
+}
+
+// ScalarPartition
+// Branch-free Lomuto: every key is swapped with the boundary, and the
+// boundary advances only past keys below the pivot.
+// Exit: k, with arr[0..k) < pivot <= arr[k..size)
+static inline size_t ScalarPartition(
+  hedger::S_T *arr,
+  size_t size,
+  hedger::S_T pivot)
+{
+  size_t boundary = 0;
+  for (size_t i = 0; i < size; ++i) {
+    hedger::S_T key = arr[i];
+    arr[i] = arr[boundary];
+    arr[boundary] = key;
+    boundary += key < pivot;
+  }
+  return boundary;
+}
+
+// ScalarHistogram
+static inline void ScalarHistogram(
+  const hedger::S_T *arr,
+  size_t size,
+  hedger::S_T low,
+  int *count)
+{
+  // Unsigned difference: exact for any span under 2^32
+  uint32_t base = (uint32_t) low;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    ++count[(uint32_t) arr[i] - base];
+    ++count[(uint32_t) arr[i + 1] - base];
+    ++count[(uint32_t) arr[i + 2] - base];
+    ++count[(uint32_t) arr[i + 3] - base];
+  }
+  for (; i < size; ++i)
+    ++count[(uint32_t) arr[i] - base];
+}
+
+#ifdef SORT_KERNELS_X86
+// Lane orders that move the keys below the pivot to the front of a vector
+// and the rest behind them, indexed by the comparison mask.
+static int partition_lut_8[256][8];           // AVX2: dword indices
+static uint8_t partition_lut_4[16][16];       // SSE: byte shuffle
+
+// PartitionLutInit
+// Fill the permutation tables before main() runs.
+static struct PartitionLutInit {
+  PartitionLutInit() {
+    for (int mask = 0; mask < 256; ++mask) {
+      int out = 0;
+      for (int lane = 0; lane < 8; ++lane)
+        if (mask & (1 << lane))
+          partition_lut_8[mask][out++] = lane;
+      for (int lane = 0; lane < 8; ++lane)
+        if (!(mask & (1 << lane)))
+          partition_lut_8[mask][out++] = lane;
+    }
+    for (int mask = 0; mask < 16; ++mask) {
+      int out = 0;
+      for (int pass = 0; pass < 2; ++pass) {
+        for (int lane = 0; lane < 4; ++lane) {
+          bool less = mask & (1 << lane);
+          if (less == (0 == pass)) {
+            for (int byte = 0; byte < 4; ++byte)
+              partition_lut_4[mask][out * 4 + byte] = lane * 4 + byte;
+            ++out;
+          }
+        }
+      }
+    }
+  }
+} partition_lut_init;
+
+//
+// SSE4.2: 4 lanes
+//
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+namespace sse42 {
+const size_t kLanes = 4;
+typedef __m128i Vec;
+static inline Vec Load(const hedger::S_T *p) {
+  return _mm_loadu_si128((const __m128i *) p);
+}
+static inline void Store(hedger::S_T *p, Vec v) {
+  _mm_storeu_si128((__m128i *) p, v);
+}
+static inline Vec Set1(hedger::S_T key) { return _mm_set1_epi32(key); }
+// Sort a bitonic vector: compare lanes 2 apart, then 1 apart.
+static inline Vec BitonicSort(Vec v) {
+  Vec t = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  v = _mm_blend_epi16(_mm_min_epi32(v, t), _mm_max_epi32(v, t), 0xf0);
+  t = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_blend_epi16(_mm_min_epi32(v, t), _mm_max_epi32(v, t), 0xcc);
+}
+static inline void BitonicMerge(Vec& lo, Vec& hi) {
+  Vec reversed = _mm_shuffle_epi32(hi, _MM_SHUFFLE(0, 1, 2, 3));
+  Vec min = _mm_min_epi32(lo, reversed);
+  Vec max = _mm_max_epi32(lo, reversed);
+  lo = BitonicSort(min);
+  hi = BitonicSort(max);
+}
+static inline size_t PartitionBlock(Vec v, Vec pivot_v, hedger::S_T *lw,
+  hedger::S_T *rw) {
+  int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(pivot_v, v)));
+  Vec split = _mm_shuffle_epi8(v,
+    _mm_loadu_si128((const __m128i *) partition_lut_4[mask]));
+  Store(lw, split);
+  Store(rw - kLanes, split);
+  return __builtin_popcount(mask);
+}
+#include "sort_kernels_impl.h"
+} // namespace sse42
+#pragma GCC pop_options
+
+//
+// AVX2: 8 lanes
+//
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace avx2 {
+const size_t kLanes = 8;
+typedef __m256i Vec;
+static inline Vec Load(const hedger::S_T *p) {
+  return _mm256_loadu_si256((const __m256i *) p);
+}
+static inline void Store(hedger::S_T *p, Vec v) {
+  _mm256_storeu_si256((__m256i *) p, v);
+}
+static inline Vec Set1(hedger::S_T key) { return _mm256_set1_epi32(key); }
+// Sort a bitonic vector: compare lanes 4, 2, then 1 apart.
+static inline Vec BitonicSort(Vec v) {
+  Vec t = _mm256_permute2x128_si256(v, v, 1);
+  v = _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t),
+    0xf0);
+  t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  v = _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t),
+    0xcc);
+  t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm256_blend_epi32(_mm256_min_epi32(v, t), _mm256_max_epi32(v, t),
+    0xaa);
+}
+static inline void BitonicMerge(Vec& lo, Vec& hi) {
+  Vec reversed = _mm256_permutevar8x32_epi32(hi,
+    _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  Vec min = _mm256_min_epi32(lo, reversed);
+  Vec max = _mm256_max_epi32(lo, reversed);
+  lo = BitonicSort(min);
+  hi = BitonicSort(max);
+}
+static inline size_t PartitionBlock(Vec v, Vec pivot_v, hedger::S_T *lw,
+  hedger::S_T *rw) {
+  int mask = _mm256_movemask_ps(
+    _mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot_v, v)));
+  Vec split = _mm256_permutevar8x32_epi32(v,
+    _mm256_loadu_si256((const __m256i *) partition_lut_8[mask]));
+  Store(lw, split);
+  Store(rw - kLanes, split);
+  return __builtin_popcount(mask);
+}
+#include "sort_kernels_impl.h"
+} // namespace avx2
+#pragma GCC pop_options
+
+//
+// AVX-512: 16 lanes
+//
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+// GCC 12 flags the deliberately undefined pass-through of unmasked
+// AVX-512 intrinsics as maybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace avx512 {
+const size_t kLanes = 16;
+typedef __m512i Vec;
+static inline Vec Load(const hedger::S_T *p) {
+  return _mm512_loadu_si512((const void *) p);
+}
+static inline void Store(hedger::S_T *p, Vec v) {
+  _mm512_storeu_si512((void *) p, v);
+}
+static inline Vec Set1(hedger::S_T key) { return _mm512_set1_epi32(key); }
+// Sort a bitonic vector: compare lanes 8, 4, 2, then 1 apart.
+static inline Vec BitonicSort(Vec v) {
+  Vec t = _mm512_shuffle_i32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2));
+  v = _mm512_mask_blend_epi32(0xff00, _mm512_min_epi32(v, t),
+    _mm512_max_epi32(v, t));
+  t = _mm512_shuffle_i32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  v = _mm512_mask_blend_epi32(0xf0f0, _mm512_min_epi32(v, t),
+    _mm512_max_epi32(v, t));
+  t = _mm512_shuffle_epi32(v, (_MM_PERM_ENUM) _MM_SHUFFLE(1, 0, 3, 2));
+  v = _mm512_mask_blend_epi32(0xcccc, _mm512_min_epi32(v, t),
+    _mm512_max_epi32(v, t));
+  t = _mm512_shuffle_epi32(v, (_MM_PERM_ENUM) _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm512_mask_blend_epi32(0xaaaa, _mm512_min_epi32(v, t),
+    _mm512_max_epi32(v, t));
+}
+static inline void BitonicMerge(Vec& lo, Vec& hi) {
+  Vec reversed = _mm512_permutexvar_epi32(_mm512_setr_epi32(15, 14, 13, 12,
+    11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), hi);
+  Vec min = _mm512_min_epi32(lo, reversed);
+  Vec max = _mm512_max_epi32(lo, reversed);
+  lo = BitonicSort(min);
+  hi = BitonicSort(max);
+}
+// Compress stores write exactly the selected keys, so no table is needed.
+static inline size_t PartitionBlock(Vec v, Vec pivot_v, hedger::S_T *lw,
+  hedger::S_T *rw) {
+  __mmask16 mask = _mm512_cmplt_epi32_mask(v, pivot_v);
+  size_t less_tot = __builtin_popcount(mask);
+  _mm512_mask_compressstoreu_epi32(lw, mask, v);
+  _mm512_mask_compressstoreu_epi32(rw - (kLanes - less_tot),
+    (__mmask16) ~mask, v);
+  return less_tot;
+}
+#include "sort_kernels_impl.h"
+} // namespace avx512
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif // SORT_KERNELS_X86
+
+//
+// Dispatch
+//
+
+static const SortKernels kKernelArr[kKernelLevelTot] = {
+  { kKernelBaseline, "baseline", ScalarMerge, ScalarPartition,
+    ScalarHistogram },
+#ifdef SORT_KERNELS_X86
+  { kKernelSse42, "sse4.2", sse42::Merge, sse42::Partition,
+    sse42::Histogram },
+  { kKernelAvx2, "avx2", avx2::Merge, avx2::Partition, avx2::Histogram },
+  { kKernelAvx512, "avx512", avx512::Merge, avx512::Partition,
+    avx512::Histogram },
+#endif
+};
+
+// Kernels in use; chosen on first use
+static const SortKernels *kernels = nullptr;
+
+// GetCpuKernelLevel
+// Exit: best level cpuid reports (and the OS saves the registers of)
+KernelLevel GetCpuKernelLevel()
+{
+#ifdef SORT_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return kKernelAvx512;
+  if (__builtin_cpu_supports("avx2"))
+    return kKernelAvx2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return kKernelSse42;
+#endif
+  return kKernelBaseline;
+}
+
+// GetSortKernels
+// Exit: kernels for the best level this CPU supports, unless overridden
+const SortKernels& GetSortKernels()
+{
+  if (nullptr == kernels)
+    kernels = &kKernelArr[GetCpuKernelLevel()];
+  return *kernels;
+}
+
+// SetSortKernelLevel
+// Entry: level to use
+// Exit:  false == the CPU lacks it (selection unchanged)
+bool SetSortKernelLevel(KernelLevel level)
+{
+  if (level < kKernelBaseline || level > GetCpuKernelLevel())
+    return false;
+  kernels = &kKernelArr[level];
+  return true;
+}
+
+// GetKernelLevelName
+const char *GetKernelLevelName(KernelLevel level)
+{
+  static const char *kNameArr[kKernelLevelTot] = {
+    "baseline", "sse4.2", "avx2", "avx512"
+  };
+  return level < kKernelLevelTot ? kNameArr[level] : "unknown";
+}
+
+// FindKernelLevel
+// Exit: level named name, or kKernelLevelTot if there is none
+KernelLevel FindKernelLevel(const char *name)
+{
+  for (int level = 0; level < kKernelLevelTot; ++level)
+    if (!strcmp(name, GetKernelLevelName((KernelLevel) level)))
+      return (KernelLevel) level;
+  return kKernelLevelTot;
+}
+} // namespace hedger
@@ -0,0 +1,112 @@
+// sort_kernels.h
+//
+// Hot integer kernels (merge, partition, histogram) compiled for several
+// instruction sets, with the best one the CPU supports chosen at startup.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORT_KERNELS_H_
+#define SORT_KERNELS_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "algo.h"
+
+namespace hedger
+{
+// Instruction set levels, lowest first
+enum KernelLevel {
+  kKernelBaseline,          // scalar, branch-free
+  kKernelSse42,
+  kKernelAvx2,
+  kKernelAvx512,
+  kKernelLevelTot
+};
+
+// SortKernels
+// One instruction set's kernels.  Every level gives identical results.
+struct SortKernels {
+  KernelLevel level;
+  const char *name;
+  // Merge sorted a[0..a_size) and b[0..b_size) into out (no overlap).
+  // The vector levels merge through in-register bitonic compare-exchange
+  // networks.
+  void (*merge)(
+    const hedger::S_T *a,
+    size_t a_size,
+    const hedger::S_T *b,
+    size_t b_size,
+    hedger::S_T *out
+  );
+  // Reorder arr in place so arr[0..k) < pivot <= arr[k..size); returns k
+  size_t (*partition)(hedger::S_T *arr, size_t size, hedger::S_T pivot);
+  // ++count[arr[i] - low] for every i (keys within 2^32 of low)
+  void (*histogram)(
+    const hedger::S_T *arr,
+    size_t size,
+    hedger::S_T low,
+    int *count
+  );
+};
+
+// Kernels chosen for this CPU (the first call detects it with cpuid)
+const SortKernels& GetSortKernels();
+// Force a level at or below what the CPU supports; false == unsupported
+bool SetSortKernelLevel(KernelLevel level);
+// Best level this CPU supports
+KernelLevel GetCpuKernelLevel();
+const char *GetKernelLevelName(KernelLevel level);
+// Exit: level named name, or kKernelLevelTot if there is none
+KernelLevel FindKernelLevel(const char *name);
+
+// KernelMerge, KernelPartition
+// Engines call these from their generic code.  Only uninstrumented int
+// sorts in natural order match the overloads that use the kernels; every
+// other instantiation gets the template and keeps its own loop.
+template <class Stats, class T, class Compare>
+inline bool KernelMerge(Stats& stats, const Compare& less, const T *a,
+  size_t a_size, const T *b, size_t b_size, T *out)
+{
+  return false;
+}
+inline bool KernelMerge(NoStats& stats, const std::less<hedger::S_T>& less,
+  const hedger::S_T *a, size_t a_size, const hedger::S_T *b, size_t b_size,
+  hedger::S_T *out)
+{
+  GetSortKernels().merge(a, a_size, b, b_size, out);
+  return true;
+}
+
+template <class Stats, class T, class Compare>
+inline bool KernelPartition(Stats& stats, const Compare& less, T *arr,
+  size_t size, const T& pivot, size_t *split)
+{
+  return false;
+}
+inline bool KernelPartition(NoStats& stats,
+  const std::less<hedger::S_T>& less, hedger::S_T *arr, size_t size,
+  const hedger::S_T& pivot, size_t *split)
+{
+  *split = GetSortKernels().partition(arr, size, pivot);
+  return true;
+}
+}
+
+#endif // SORT_KERNELS_H_
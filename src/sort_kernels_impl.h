@@ -0,0 +1,161 @@
+// sort_kernels_impl.h
+//
+// Vector kernel bodies shared by every instruction set level.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// No include guard: sort_kernels.cc includes this once per level, inside
+// that level's namespace and #pragma GCC target region, after defining
+//   kLanes                              keys per vector
+//   Vec                                 vector of kLanes keys
+//   Load(p), Store(p, v), Set1(key)
+//   BitonicMerge(lo, hi)                two sorted vectors to the lower and
+//                                       upper halves of their union, sorted
+//   PartitionBlock(v, pivot_v, lw, rw)  keys < pivot to lw[0..k), the rest
+//                                       to rw[-(kLanes - k)..0); returns k
+//                                       (may write kLanes slots either side)
+
+// Merge
+// Vector merge: hold the larger half of each merge in a carry vector and
+// feed it the next block from whichever run has the smaller head, so every
+// key written is no larger than any key still unread.
+// Entry: sorted run a and its size
+//        sorted run b and its size
+//        output (a_size + b_size slots)
+void Merge(
+  const hedger::S_T *a,
+  size_t a_size,
+  const hedger::S_T *b,
+  size_t b_size,
+  hedger::S_T *out)
+{
+  if (a_size < kLanes || b_size < kLanes) {
+    ScalarMerge(a, a_size, b, b_size, out);
+    return;
+  }
+  Vec lo = Load(a);
+  Vec hi = Load(b);
+  size_t a_next = kLanes;
+  size_t b_next = kLanes;
+  for (;;) {
+    BitonicMerge(lo, hi);
+    Store(out, lo);
+    out += kLanes;
+    bool take_a = b_next == b_size ||
+      (a_next < a_size && a[a_next] <= b[b_next]);
+    if (take_a && a_next + kLanes <= a_size) {
+      lo = Load(&a[a_next]);
+      a_next += kLanes;
+    } else if (!take_a && b_next + kLanes <= b_size) {
+      lo = Load(&b[b_next]);
+      b_next += kLanes;
+    } else {
+      break;
+    }
+  }
+
+  // The run with the smaller head has under a vector left: merge it with
+  // the carry, then merge that with the other run.
+  hedger::S_T carry[kLanes];
+  hedger::S_T tail[2 * kLanes];
+  Store(carry, hi);
+  const hedger::S_T *short_run = a;
+  size_t short_next = a_next, short_size = a_size;
+  const hedger::S_T *long_run = b;
+  size_t long_next = b_next, long_size = b_size;
+  if (a_next + kLanes <= a_size) {
+    short_run = b;
+    short_next = b_next;
+    short_size = b_size;
+    long_run = a;
+    long_next = a_next;
+    long_size = a_size;
+  }
+  size_t tail_size = kLanes + short_size - short_next;
+  ScalarMerge(carry, kLanes, &short_run[short_next], short_size - short_next,
+    tail);
+  ScalarMerge(tail, tail_size, &long_run[long_next], long_size - long_next,
+    out);
+}
+
+// Partition
+// In-place vector partition.  The first and last vectors are set aside, so
+// there are always kLanes free slots at each end; each step reads from the
+// end with less free space and writes its keys to both ends.
+// Entry: array
+//        size in elements
+//        pivot
+// Exit:  k, with arr[0..k) < pivot <= arr[k..size)
+size_t Partition(hedger::S_T *arr, size_t size, hedger::S_T pivot)
+{
+  if (size < 3 * kLanes)
+    return ScalarPartition(arr, size, pivot);
+  Vec pivot_v = Set1(pivot);
+  Vec first = Load(arr);
+  Vec last = Load(&arr[size - kLanes]);
+  hedger::S_T *lw = arr;                        // next low write
+  hedger::S_T *rw = arr + size;                 // one past next high write
+  hedger::S_T *lr = arr + kLanes;               // unread is [lr, rr)
+  hedger::S_T *rr = arr + size - kLanes;
+  while (rr - lr >= (ptrdiff_t) kLanes) {
+    Vec v;
+    if (lr - lw <= rw - rr) {
+      v = Load(lr);
+      lr += kLanes;
+    } else {
+      rr -= kLanes;
+      v = Load(rr);
+    }
+    size_t less_tot = PartitionBlock(v, pivot_v, lw, rw);
+    lw += less_tot;
+    rw -= kLanes - less_tot;
+  }
+
+  // Fewer than a vector unread, plus the two set aside
+  hedger::S_T rest[3 * kLanes];
+  size_t rest_tot = rr - lr;
+  for (size_t i = 0; i < rest_tot; ++i)
+    rest[i] = lr[i];
+  Store(&rest[rest_tot], first);
+  Store(&rest[rest_tot + kLanes], last);
+  rest_tot += 2 * kLanes;
+  for (size_t i = 0; i < rest_tot; ++i) {
+    if (rest[i] < pivot)
+      *lw++ = rest[i];
+    else
+      *--rw = rest[i];
+  }
+  return lw - arr;
+}
+
+// Histogram
+// Count keys four at a time; the target lets the compiler pick wider
+// address arithmetic and loads.
+// Entry: array
+//        size in elements
+//        lowest key
+//        counts (cleared by the caller)
+void Histogram(
+  const hedger::S_T *arr,
+  size_t size,
+  hedger::S_T low,
+  int *count)
+{
+  ScalarHistogram(arr, size, low, count);
+}
@@ -0,0 +1,429 @@
+// sort_service.cc
+//
+// Local sort service: the server behind the daemon mode.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "sort_service.h"
+
+namespace hedger {
+
+// Requests of at most this many keys are small enough to batch
+const uint64_t kServiceSmallMax = 4096;
+// Most small requests one worker takes at once
+const size_t kServiceBatchMax = 32;
+// How often the accept loop looks at the stop flag
+const int kServicePollMs = 200;
+
+// ServiceNowNs
+// Exit: monotonic time in ns
+static uint64_t ServiceNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ServiceReadFull
+// Entry: socket
+//        buffer
+//        bytes
+// Exit:  true == every byte read (false on error or end of stream)
+bool ServiceReadFull(int fd, void *buf, size_t size)
+{
+  char *p = (char *) buf;
+  while (size) {
+    ssize_t n = read(fd, p, size);
+    if (n < 0 && EINTR == errno)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// ServiceWriteFull
+// Entry: socket
+//        buffer
+//        bytes
+// Exit:  true == every byte written
+bool ServiceWriteFull(int fd, const void *buf, size_t size)
+{
+  const char *p = (const char *) buf;
+  while (size) {
+    ssize_t n = write(fd, p, size);
+    if (n < 0 && EINTR == errno)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+// ServiceWritevFull
+// Entry: socket
+//        buffers (advanced in place as they are written)
+//        buffer count
+// Exit:  true == every byte written
+bool ServiceWritevFull(int fd, struct iovec *iov, int iov_tot)
+{
+  while (iov_tot) {
+    ssize_t n = writev(fd, iov, std::min(iov_tot, IOV_MAX));
+    if (n < 0 && EINTR == errno)
+      continue;
+    if (n <= 0)
+      return false;
+    while (iov_tot && (size_t) n >= iov->iov_len) {
+      n -= iov->iov_len;
+      ++iov;
+      --iov_tot;
+    }
+    if (iov_tot) {
+      iov->iov_base = (char *) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+// Destructor
+// Runs once the reader and every job on the connection are done.
+ServiceConnection::~ServiceConnection()
+{
+  for (auto& entry : mapping_map)
+    munmap(entry.second.addr, entry.second.size);
+  close(fd);
+}
+
+// Constructor
+// Entry: engines requests may name (not owned)
+//        worker threads
+SortServer::SortServer(std::vector<Algo *>& algo_arr, int worker_tot) :
+  algo_arr_(algo_arr), request_tot_(0), batch_tot_(0)
+{
+  worker_tot_ = worker_tot < 1 ? 1 : worker_tot;
+  listen_fd_ = -1;
+  stopping_ = false;
+  reader_tot_ = 0;
+}
+
+// Destructor
+SortServer::~SortServer()
+{
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    unlink(path_.c_str());
+  }
+}
+
+// Listen
+// Bind the socket.  A stale socket file is replaced; a live one (something
+// accepts connections on it) is left alone.
+// Entry: socket path
+// Exit:  true == listening
+bool SortServer::Listen(const char *path)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    printf("Socket path %s is too long\n", path);
+    return false;
+  }
+  strcpy(addr.sun_path, path);
+
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe >= 0) {
+    bool live = !connect(probe, (struct sockaddr *) &addr, sizeof(addr));
+    close(probe);
+    if (live) {
+      printf("A server is already listening on %s\n", path);
+      return false;
+    }
+  }
+  unlink(path);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0 ||
+      bind(listen_fd_, (struct sockaddr *) &addr, sizeof(addr)) ||
+      listen(listen_fd_, SOMAXCONN)) {
+    // TODO: LOG ERROR
+    printf("Cannot listen on %s: %s\n", path, strerror(errno));
+    if (listen_fd_ >= 0)
+      close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  path_ = path;
+  return true;
+}
+
+// Run
+// Start the workers, accept connections until *stop is set, then close
+// every connection and let the workers drain the queue.
+// Entry: stop flag
+void SortServer::Run(volatile sig_atomic_t *stop)
+{
+  for (int i = 0; i < worker_tot_; ++i)
+    worker_arr_.push_back(std::thread(&SortServer::Worker, this));
+
+  while (!*stop) {
+    struct pollfd poll_fd = { listen_fd_, POLLIN, 0 };
+    if (poll(&poll_fd, 1, kServicePollMs) <= 0)
+      continue;
+    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+      continue;
+    std::shared_ptr<ServiceConnection> connection =
+      std::make_shared<ServiceConnection>(fd);
+    {
+      std::lock_guard<std::mutex> guard(connection_lock_);
+      live_fd_set_.insert(fd);
+      ++reader_tot_;
+    }
+    std::thread(&SortServer::Reader, this, connection).detach();
+  }
+
+  // Wake every reader out of its read() and wait for them to leave
+  {
+    std::unique_lock<std::mutex> guard(connection_lock_);
+    for (int fd : live_fd_set_)
+      shutdown(fd, SHUT_RDWR);
+    reader_exit_.wait(guard, [this] { return 0 == reader_tot_; });
+  }
+  {
+    std::lock_guard<std::mutex> guard(queue_lock_);
+    stopping_ = true;
+  }
+  queue_ready_.notify_all();
+  for (auto& worker : worker_arr_)
+    worker.join();
+  worker_arr_.clear();
+}
+
+// Respond
+// Entry: connection
+//        response header
+//        data to follow (nullptr == none)
+//        data bytes
+// Exit:  true == sent
+bool SortServer::Respond(
+  ServiceConnection *connection,
+  const ServiceResponse& response,
+  const void *data,
+  size_t size)
+{
+  struct iovec iov[2] = {
+    { (void *) &response, sizeof(response) },
+    { (void *) data, size }
+  };
+  std::lock_guard<std::mutex> guard(connection->write_lock);
+  return ServiceWritevFull(connection->fd, iov, data ? 2 : 1);
+}
+
+// MapShm
+// Entry: connection
+//        shared memory object name
+//        keys the request needs
+// Exit:  keys (nullptr == refused)
+S_T *SortServer::MapShm(
+  ServiceConnection *connection,
+  const char *name,
+  uint64_t count)
+{
+  size_t need = count * sizeof(S_T);
+  auto entry = connection->mapping_map.find(name);
+  if (entry != connection->mapping_map.end())
+    return entry->second.size >= need ? (S_T *) entry->second.addr : nullptr;
+
+  if ('/' != name[0] || !memchr(name, 0, kServiceShmNameMax))
+    return nullptr;
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+    return nullptr;
+  struct stat status;
+  void *addr = MAP_FAILED;
+  if (!fstat(fd, &status) && (size_t) status.st_size >= need &&
+      status.st_size > 0) {
+    addr = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      fd, 0);
+  }
+  close(fd);
+  if (MAP_FAILED == addr)
+    return nullptr;
+  ServiceConnection::Mapping mapping = { addr, (size_t) status.st_size };
+  connection->mapping_map[name] = mapping;
+  return (S_T *) addr;
+}
+
+// Reader
+// Receive requests on one connection and queue the sorts.
+// Entry: connection
+void SortServer::Reader(std::shared_ptr<ServiceConnection> connection)
+{
+  ServiceRequest request;
+  while (ServiceReadFull(connection->fd, &request, sizeof(request))) {
+    if (kServiceMagic != request.magic)
+      break;
+    ServiceResponse response = { kServiceMagic, 0, request.id, 0, 0 };
+    uint64_t start_ns = ServiceNowNs();
+    if (kServicePing == request.op) {
+      Respond(connection.get(), response, nullptr, 0);
+      continue;
+    }
+    if (kServiceList == request.op) {
+      std::string names;
+      for (auto engine : algo_arr_)
+        names += std::string(engine->GetName()) + "\n";
+      response.count = names.size();
+      Respond(connection.get(), response, names.data(), names.size());
+      continue;
+    }
+    if ((kServiceSort != request.op && kServiceSortShm != request.op) ||
+        request.count > kServiceCountMax)
+      break;
+
+    ServiceJob *job = new ServiceJob;
+    job->connection = connection;
+    job->id = request.id;
+    job->count = request.count;
+    job->engine = request.engine < algo_arr_.size() ?
+      algo_arr_[request.engine] : nullptr;
+    job->inline_keys = kServiceSort == request.op;
+    job->start_ns = start_ns;
+    if (job->inline_keys) {
+      job->buffer.resize(request.count);
+      job->keys = job->buffer.data();
+      if (!ServiceReadFull(connection->fd, job->keys,
+          request.count * sizeof(S_T))) {
+        delete job;
+        break;
+      }
+    } else {
+      request.shm_name[kServiceShmNameMax - 1] = 0;
+      job->keys = MapShm(connection.get(), request.shm_name, request.count);
+    }
+    if (nullptr == job->engine || (nullptr == job->keys && job->count)) {
+      response.status = -1;
+      Respond(connection.get(), response, nullptr, 0);
+      delete job;
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> guard(queue_lock_);
+      queue_.push_back(job);
+    }
+    queue_ready_.notify_one();
+  }
+
+  std::lock_guard<std::mutex> guard(connection_lock_);
+  live_fd_set_.erase(connection->fd);
+  --reader_tot_;
+  reader_exit_.notify_all();
+}
+
+// Worker
+// Take a batch from the queue, sort it, and answer each connection in the
+// batch with one write.
+void SortServer::Worker()
+{
+  std::vector<ServiceJob *> batch;
+  std::vector<ServiceResponse> response_arr;
+  std::vector<struct iovec> iov_arr;
+  for (;;) {
+    batch.clear();
+    {
+      std::unique_lock<std::mutex> guard(queue_lock_);
+      queue_ready_.wait(guard, [this] {
+        return stopping_ || !queue_.empty();
+      });
+      if (queue_.empty())
+        return;
+      batch.push_back(queue_.front());
+      queue_.pop_front();
+      if (batch[0]->count <= kServiceSmallMax) {
+        while (batch.size() < kServiceBatchMax && !queue_.empty() &&
+               queue_.front()->count <= kServiceSmallMax) {
+          batch.push_back(queue_.front());
+          queue_.pop_front();
+        }
+      }
+    }
+    ++batch_tot_;
+    request_tot_ += batch.size();
+
+    response_arr.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      ServiceJob *job = batch[i];
+      if (job->count > 1)
+        job->engine->Test(job->keys, job->count, job->count);
+      ServiceResponse& response = response_arr[i];
+      response.magic = kServiceMagic;
+      response.status = 0;
+      response.id = job->id;
+      response.count = job->inline_keys ? job->count : 0;
+      response.server_ns = ServiceNowNs() - job->start_ns;
+    }
+
+    // One writev per connection, in batch order
+    std::vector<bool> sent_arr(batch.size(), false);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (sent_arr[i])
+        continue;
+      ServiceConnection *connection = batch[i]->connection.get();
+      iov_arr.clear();
+      for (size_t j = i; j < batch.size(); ++j) {
+        if (batch[j]->connection.get() != connection)
+          continue;
+        sent_arr[j] = true;
+        struct iovec header = { &response_arr[j], sizeof(ServiceResponse) };
+        iov_arr.push_back(header);
+        if (response_arr[j].count) {
+          struct iovec data = { batch[j]->keys,
+            (size_t) response_arr[j].count * sizeof(S_T) };
+          iov_arr.push_back(data);
+        }
+      }
+      std::lock_guard<std::mutex> guard(connection->write_lock);
+      ServiceWritevFull(connection->fd, &iov_arr[0], (int) iov_arr.size());
+    }
+    for (auto job : batch)
+      delete job;
+  }
+}
+} // namespace hedger
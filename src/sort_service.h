@@ -0,0 +1,161 @@
+// sort_service.h
+//
+// Local sort service: wire protocol and the server behind the daemon mode.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORT_SERVICE_H_
+#define SORT_SERVICE_H_
+
+#include <stdint.h>
+#include <signal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "algo.h"
+
+namespace hedger
+{
+// Protocol
+// A client sends requests on a Unix stream socket and may have many in
+// flight; responses carry the request id and can come back in any order.
+// Every message is a fixed header in host byte order, followed for an
+// inline sort by count S_T keys each way.  A shared-memory sort names a
+// POSIX shared memory object holding count keys, which the server maps
+// once per connection and sorts in place, so no keys cross the socket.
+const uint32_t kServiceMagic = 0x56534253;    // "SBSV"
+const size_t kServiceShmNameMax = 64;
+// Largest request the server accepts, in keys
+const uint64_t kServiceCountMax = (uint64_t) 1 << 28;
+
+enum ServiceOp {
+  kServiceSort = 1,             // keys follow the header
+  kServiceSortShm,              // keys are in shm_name
+  kServiceList,                 // response: engine names, one per line
+  kServicePing                  // response: empty, straight from the reader
+};
+
+struct ServiceRequest {
+  uint32_t magic;
+  uint32_t op;
+  uint64_t id;
+  uint64_t count;               // keys
+  uint32_t engine;              // index into the server's engine list
+  uint32_t reserved;
+  char shm_name[kServiceShmNameMax];
+};
+
+struct ServiceResponse {
+  uint32_t magic;
+  int32_t status;               // 0 == sorted, -1 == refused
+  uint64_t id;
+  uint64_t count;               // keys (or name bytes) following
+  uint64_t server_ns;           // time from receipt to response
+};
+
+// Blocking I/O on a socket, retried across signals and short transfers
+// Exit: true == every byte moved
+bool ServiceReadFull(int fd, void *buf, size_t size);
+bool ServiceWriteFull(int fd, const void *buf, size_t size);
+bool ServiceWritevFull(int fd, struct iovec *iov, int iov_tot);
+
+// ServiceConnection
+// One client connection.  Its reader thread owns the receive side; any
+// worker may write responses, one at a time.  Shared-memory mappings are
+// cached per connection and unmapped when the last job using it is done.
+struct ServiceConnection {
+  ServiceConnection(int socket) : fd(socket) {}
+  ~ServiceConnection();
+  int fd;
+  std::mutex write_lock;
+  struct Mapping {
+    void *addr;
+    size_t size;
+  };
+  std::map<std::string, Mapping> mapping_map;
+};
+
+// ServiceJob
+// One queued sort
+struct ServiceJob {
+  std::shared_ptr<ServiceConnection> connection;
+  uint64_t id;
+  uint64_t count;
+  Algo *engine;
+  S_T *keys;                    // buffer or shared memory
+  std::vector<S_T> buffer;      // inline keys
+  bool inline_keys;
+  uint64_t start_ns;            // receipt time
+};
+
+// SortServer
+// Accepts connections on a Unix socket; each connection's reader queues
+// sorts for a pool of workers.  A worker takes one large request, or up
+// to kServiceBatchMax small ones at once, sorts them back to back and
+// writes each connection's responses with one writev().
+class SortServer
+{
+ public:
+  SortServer(std::vector<Algo *>& algo_arr, int worker_tot);
+  ~SortServer();
+  bool Listen(const char *path);
+  // Serve until *stop becomes nonzero (e.g. from a signal handler)
+  void Run(volatile sig_atomic_t *stop);
+  uint64_t GetRequestTot() { return request_tot_.load(); }
+  uint64_t GetBatchTot() { return batch_tot_.load(); }
+ private:
+  void Reader(std::shared_ptr<ServiceConnection> connection);
+  void Worker();
+  bool Respond(
+    ServiceConnection *connection,
+    const ServiceResponse& response,
+    const void *data,
+    size_t size
+  );
+  S_T *MapShm(ServiceConnection *connection, const char *name,
+    uint64_t count);
+  std::vector<Algo *>& algo_arr_;
+  int worker_tot_;
+  int listen_fd_;
+  std::string path_;
+  std::mutex queue_lock_;
+  std::condition_variable queue_ready_;
+  std::deque<ServiceJob *> queue_;
+  bool stopping_;
+  std::vector<std::thread> worker_arr_;
+  // Readers are detached; these let shutdown unblock and wait for them.
+  std::mutex connection_lock_;
+  std::condition_variable reader_exit_;
+  std::set<int> live_fd_set_;
+  int reader_tot_;
+  std::atomic<uint64_t> request_tot_;
+  std::atomic<uint64_t> batch_tot_;
+};
+}
+
+#endif // SORT_SERVICE_H_
@@ -0,0 +1,106 @@
+// sort_stats.h
+//
+// Compile-time instrumentation policies for the sorting engines.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORT_STATS_H_
+#define SORT_STATS_H_
+
+#include <cstddef>
+
+namespace hedger {
+
+// SortStats
+// What an instrumented sort counts.
+struct SortStats {
+  unsigned long long compare_tot;   // key comparisons
+  unsigned long long move_tot;      // element copies (a swap is not a move)
+  unsigned long long swap_tot;      // element exchanges
+  unsigned long long alloc_tot;     // scratch allocations
+  int depth_max;                    // deepest recursion
+  int pass_tot;                     // passes over the data an engine that
+                                    //   skips some made (-1 == not counted)
+  const char *detail;               // static note on the call, e.g. the
+                                    //   engine a dispatcher picked
+                                    //   (nullptr == none)
+};
+
+// An engine's hot path is a template on one of the policies below and
+// calls its hooks at every comparison, move, swap, allocation and
+// recursion.  NoStats hooks are empty inlines, so the timed build is the
+// plain algorithm; CountStats hooks count.
+
+// NoStats
+// Timing policy: every hook compiles to nothing.
+struct NoStats {
+  template <class T, class Compare>
+    inline bool Less(const T& a, const T& b, const Compare& less) {
+    return less(a, b);
+  }
+  inline void Move(size_t n = 1) {}
+  inline void Swap() {}
+  inline void Alloc() {}
+  inline void Enter() {}
+  inline void Leave() {}
+};
+
+// CountStats
+// Counting policy.
+struct CountStats : public SortStats {
+  CountStats() {
+    compare_tot = move_tot = swap_tot = alloc_tot = 0;
+    depth_max = depth = 0;
+    pass_tot = -1;
+    detail = nullptr;
+  }
+  template <class T, class Compare>
+    inline bool Less(const T& a, const T& b, const Compare& less) {
+    ++compare_tot;
+    return less(a, b);
+  }
+  inline void Move(size_t n = 1) { move_tot += n; }
+  inline void Swap() { ++swap_tot; }
+  inline void Alloc() { ++alloc_tot; }
+  inline void Enter() {
+    if (++depth > depth_max)
+      depth_max = depth;
+  }
+  inline void Leave() { --depth; }
+  int depth;
+};
+
+// StatsLess
+// A comparator that compares through a policy, for code that takes a plain
+// comparator (e.g. a sorting network) so its comparisons are counted too.
+// With NoStats it inlines to the wrapped comparator.
+template <class Stats, class Compare>
+struct StatsLess {
+  StatsLess(Stats& policy, const Compare& compare) :
+    stats(policy), less(compare) {}
+  template <class T>
+    inline bool operator()(const T& a, const T& b) const {
+    return stats.Less(a, b, less);
+  }
+  Stats& stats;
+  const Compare& less;
+};
+} // namespace hedger
+
+#endif // SORT_STATS_H_
@@ -0,0 +1,57 @@
+// sort_types.h
+//
+// Element types the comparison engines are compiled for.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORT_TYPES_H_
+#define SORT_TYPES_H_
+
+#include <stdint.h>
+
+namespace hedger
+{
+// KeyRecord
+// A small record sorted by key, standing in for rows carried with their
+// key (e.g. a timestamp and an offset).
+struct KeyRecord {
+  int64_t key;
+  int64_t payload;
+};
+
+// KeyRecordLess
+// Order records by key alone; the payload rides along.
+struct KeyRecordLess {
+  inline bool operator()(const KeyRecord& a, const KeyRecord& b) const {
+    return a.key < b.key;
+  }
+};
+
+// Explicitly instantiate a comparison engine for every supported type.
+// int32_t is hedger::S_T.
+#define SORT_TYPES_INSTANTIATE(Engine)                  \
+  template class Engine<int32_t>;                       \
+  template class Engine<int64_t>;                       \
+  template class Engine<uint64_t>;                      \
+  template class Engine<float>;                         \
+  template class Engine<double>;                        \
+  template class Engine<KeyRecord, KeyRecordLess>;
+}
+
+#endif // SORT_TYPES_H_
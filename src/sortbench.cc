@@ -21,6 +21,7 @@
 #include <math.h>
 #include <string.h>
 #include <memory.h>
+#include <stdlib.h>
 
 // C++ headers
 #include <iostream>
@@ -28,24 +29,42 @@
 #include <set>
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <algorithm>
 
 // Project-specific
 #include "sortbench_common.h"
+#include "sortbench.h"
 #include "algo.h"
 #include "merge_sort.h"
 #include "merge_sort_multicore.h"
+#include "merge_sort_cache.h"
 #include "quick_sort.h"
 #include "quick_sort_randomized.h"
+#include "quick_sort_3way.h"
+#include "quick_sort_incremental.h"
 #include "counting_sort.h"
+#include "counting_sort_parallel.h"
 #include "heap_sort.h"
+#include "heap_sort_variants.h"
 #include "insertion_sort.h"
 #include "radix_sort.h"
+#include "auto_sort.h"
+#include "std_sort.h"
+#include "sorting_network.h"
+#include "sort_kernels.h"
+#include "roofline.h"
 
 // This global flag determines whether we print out the array.
 // Used for cursory validation of new sorting algorithms.
 static bool verbose = false;
 static bool fast_only = false;  // only include fast algorithms
 static bool memory_efficient_only = false;  // only include compact algorithms
+static bool heap_scratch_too = false;  // also time with heap scratch memory
+// Sustained memory bandwidth measured at startup, by one thread and by all
+// of them (copy == 0 when not measured)
+static hedger::StreamBandwidth stream_one = { 0.0, 0.0, 0.0 };
+static hedger::StreamBandwidth stream_all = { 0.0, 0.0, 0.0 };
 // PrintLicense
 void PrintLicense()
 {
@@ -72,12 +91,38 @@ void PrintUsage()
   cout << "Copyright (C) 2018 Greg Hedger" << endl;
   PrintLicense();
   cout << "Usage:" << endl;
-  cout << "\tsortbench [-v] [-f] <array_size> <iteration_total>" << endl;
+  cout << "\tsortbench [-v] [-f] [-s] [-m] [-b] [-N] [-g] [-c <max>] [-t <threads>] [-T] [-L] [-U] [-K] [-y <type>] [-S <set>] [-a <columns>] [-M <spec>] [-D] [-H] [-k] [-R <trace>] [-Q <socket>] [-q <socket> [-E <engine>] [-Z]] [-X <isa>] [-A] [-n <max>] [-C|-P <profile>] <array_size> <iteration_total>" << endl;
   cout << "Flags:" << endl;
   cout << "\t-v - verbose: print full array before and after each sort" << endl;
   cout << "\t-f - fast: exclude O(n^2) alogrithms" << endl;
   cout << "\t-s - include already-sorted array for testing" << endl;
   cout << "\t-m - exclude memory-expensive algorithms like counting sort" << endl;
+  cout << "\t-b - batch: merge batches into a sorted array vs. full re-sort" << endl;
+  cout << "\t-N - small-N: sorting networks vs. engines on arrays of 2..32" << endl;
+  cout << "\t-g - segmented: sort array_size elements as many 10..1000 element segments" << endl;
+  cout << "\t-c <max> - concurrent: 1, 2, 4 .. max sorts at once through each engine instance" << endl;
+  cout << "\t-t <threads> - threads for each parallel engine (default: all cores)" << endl;
+  cout << "\t-T - scaling: run parallel engines at 1, 2, 4 .. threads; speedup, efficiency, serial fraction" << endl;
+  cout << "\t-L - locks: contend each lock primitive with 1, 2, 4 .. threads; array_size keys touched per hold" << endl;
+  cout << "\t-U - NUMA: topology, then multi-core merge sort on naive, first-touch and interleaved arrays" << endl;
+  cout << "\t-K - key types: radix and counting sort on int32/64, uint32/64, float and double keys" << endl;
+  cout << "\t-y <type> - element type: comparison engines on int32, int64, uint64, float, double or record keys" << endl;
+  cout << "\t-S <set> - strings: string engines on random, prefix or url strings, or the lines of a file" << endl;
+  cout << "\t-a <columns> - argsort: permutation sorts of a key column plus a gather of 1..8 payload columns vs. sorting rows" << endl;
+  cout << "\t-M <spec> - multi-column: ORDER BY columns of cardinality[:correlation],... (e.g. 16,1000:0.5,0)" << endl;
+  cout << "\t-D - duplicates: 2- and 3-way quick sort on few distinct keys; fused sort+unique/count vs. a separate pass" << endl;
+  cout << "\t-k - lazy: time to the first 1, 10 .. array_size keys in order from the incremental quick sort iterator vs. std::sort or std::partial_sort first" << endl;
+  cout << "\t-R <trace> - trace: time Merge Sort Multi-Core untraced and traced, summarize each thread's tasks, idle joins and merges, and write the last sort as Chrome trace JSON" << endl;
+  cout << "\t-H - cache hierarchy: binary vs. cache-tiled merge sort vs. funnelsort, with memory traffic per merge level" << endl;
+  cout << "\t-Q <socket> - sort service: serve sorts with every engine on a Unix socket until interrupted" << endl;
+  cout << "\t-q <socket> - load generator: latency percentiles and throughput of a -Q service vs. offered load" << endl;
+  cout << "\t-E <engine> - engine (name prefix) the -q requests use (default: the server's first)" << endl;
+  cout << "\t-Z - pass -q keys in shared memory instead of over the socket" << endl;
+  cout << "\t-X <isa> - kernel instruction set: baseline, sse4.2, avx2 or avx512 (default: best the CPU has)" << endl;
+  cout << "\t-A - also time engines with scratch taken from the heap on every call" << endl;
+  cout << "\t-n <max> - finish subarrays of up to max (<= 32) elements with a sorting network" << endl;
+  cout << "\t-C <profile> - calibrate AutoSort thresholds and write profile" << endl;
+  cout << "\t-P <profile> - load AutoSort thresholds from profile" << endl;
 }
 
 // printArray
@@ -126,7 +171,7 @@ hedger::S_T * AllocArray(size_t size)
 void FreeArray(hedger::S_T *array)
 {
   if (array) {
-    delete array;
+    delete[] array;
   }
 }
 
@@ -135,7 +180,7 @@ void FreeArray(hedger::S_T *array)
 // Entry: array
 //        size in elements
 //        value range (optional)
-void CreateRandomDataSet(hedger::S_T *array, size_t size, size_t range = 0)
+void CreateRandomDataSet(hedger::S_T *array, size_t size, size_t range)
 {
   size_t index = 0;
   hedger::S_T value = 0;
@@ -214,11 +259,19 @@ bool VerifyNonDescending(hedger::S_T *array, size_t size)
 // Entry: vector of times
 //        iteration total
 //        algorithm instance
-void ReportStatistics(
+//        pass/fail
+//        label to follow the name (nullptr == none)
+//        std::sort mean on the same data set in ms (0 == not yet known)
+//        array size in elements (0 == no bandwidth report)
+// Exit:  mean time in ms
+double ReportStatistics(
   std::vector<double>& v,
   int iteration_tot,
   hedger::Algo& algorithm,
-  bool passed)
+  bool passed,
+  const char *label = nullptr,
+  double baseline_mu = 0.0,
+  size_t array_size = 0)
 {
     // Calculate average (mu)
     double mu, sigma;
@@ -239,6 +292,10 @@ void ReportStatistics(
     // Print report
 
     std::cout << COUT_WHITE << algorithm.GetName();
+    if (algorithm.CanInstrument() && algorithm.GetStats().detail)
+      std::cout << " (" << algorithm.GetStats().detail << ")";
+    if (label)
+      std::cout << " " << label;
     if (passed)
       std::cout << COUT_GREEN << " (PASS)" << COUT_YELLOW << ":" << std::endl;
     else
@@ -247,9 +304,34 @@ void ReportStatistics(
     std::cout << CHAR_MU << ":" << mu << " ms" << "\t";
     std::cout << CHAR_SIGMA << ":" << sigma << " ms\t";
     std::cout << CHAR_UPPER_TAU << ":" << time_tot << " ms\t";
-    if (algorithm.GetMaxRecurseDepth() )
-      std::cout << "MRD: " << algorithm.GetMaxRecurseDepth();
+    // Speed relative to std::sort: above 1 is faster, below 1 slower
+    if (baseline_mu > 0.0 && mu > 0.0)
+      std::cout << "STD: " << baseline_mu / mu << "x\t";
+    // Achieved bandwidth against the copy peak of as many threads as the
+    // engine may use: near the peak, faster code would not help.
+    double memory_bytes = array_size ?
+      algorithm.GetMemoryBytes(array_size, algorithm.GetStats()) : 0.0;
+    const hedger::StreamBandwidth& peak =
+      algorithm.GetThreadMax() > 1 && stream_all.copy > 0.0 ? stream_all :
+      stream_one;
+    if (memory_bytes > 0.0 && peak.copy > 0.0 && mu > 0.0) {
+      double gbps = memory_bytes / (mu * 1e6);
+      double pct = 100.0 * gbps / peak.copy;
+      std::cout << "BW: " << gbps << " GB/s (" << pct << "% of peak, "
+                << (pct >= hedger::kRooflineBoundPct ? "memory" : "compute")
+                << "-bound)\t";
+    }
+    if (algorithm.CanInstrument()) {
+      // Counts come from one extra, untimed, instrumented run
+      const hedger::SortStats& stats = algorithm.GetStats();
+      std::cout << "CMP: " << stats.compare_tot << "\t";
+      std::cout << "MOV: " << stats.move_tot << "\t";
+      std::cout << "SWP: " << stats.swap_tot << "\t";
+      std::cout << "ALLOC: " << stats.alloc_tot << "\t";
+      std::cout << "MRD: " << stats.depth_max;
+    }
     std::cout <<  std::endl;
+    return mu;
 }
 
 // Test
@@ -271,7 +353,9 @@ int Test(hedger::Algo& o, hedger::S_T *arr, size_t size)
 //        pointer to array buffer
 //        size of array buffer in elements
 //        # of iterations for which to test
-void RunTest(std::vector<double>& time_arr,
+// Exit:  true == every timed run's output, and the counted rerun's, is in
+//        order
+bool RunTest(std::vector<double>& time_arr,
   hedger::Algo& algorithm,
   const hedger::S_T *master_array,
   hedger::S_T *array,
@@ -283,6 +367,7 @@ void RunTest(std::vector<double>& time_arr,
   using namespace std;
   using FpMilliseconds =
         chrono::duration<float, chrono::milliseconds::period>;
+  bool passed = true;
   auto iteration_count = iterations;
   while (iteration_count) {
     memcpy(array, master_array, array_size * sizeof(hedger::S_T));
@@ -297,11 +382,57 @@ void RunTest(std::vector<double>& time_arr,
     auto ms = FpMilliseconds(stop - start); // get elapsed time in ms
     double ms_float = ms.count(); // get as a float
     time_arr.push_back(ms_float); // save in our timing array
+    // Check the timed output itself: only the no-op policy reaches the
+    // vector kernels, so the counted rerun below does not cover them.
+    passed = passed && VerifyNonDescending(array, array_size);
     if (verbose) {
       cout << COUT_WHITE << algorithm.GetName() << " AFTER: " << endl;
       PrintArray(array, array_size);
     }
   }
+  // The timed runs use the engine's no-op policy; repeat once, untimed,
+  // with the counting policy for ReportStatistics.
+  if (algorithm.CanInstrument()) {
+    memcpy(array, master_array, array_size * sizeof(hedger::S_T));
+    algorithm.ResetStats();
+    algorithm.SetInstrumented(true);
+    Test(algorithm, array, array_size);
+    algorithm.SetInstrumented(false);
+    passed = passed && VerifyNonDescending(array, array_size);
+  }
+  return passed;
+}
+
+// RunHeapScratchTest
+// With -A, time an engine that uses scratch memory a second time with its
+// arena removed, so every call allocates from the heap, and report it
+// alongside.
+// Entry: reference to algorithm
+//        pointer to master data set
+//        pointer to array buffer
+//        size of array buffer in elements
+//        # of iterations for which to test
+//        std::sort mean on the same data set in ms
+void RunHeapScratchTest(
+  hedger::Algo& algorithm,
+  const hedger::S_T *master_array,
+  hedger::S_T *array,
+  const int array_size,
+  const int iterations,
+  double baseline_mu)
+{
+  hedger::Arena *arena = algorithm.GetArena();
+  if (!heap_scratch_too || nullptr == arena ||
+      !algorithm.GetScratchSize(array_size))
+    return;
+  std::vector<double> time_arr;
+  algorithm.SetArena(nullptr);
+  bool passed = RunTest(time_arr, algorithm, master_array, array,
+    array_size, iterations, false);
+  ReportStatistics(time_arr, iterations, algorithm, passed,
+    "[heap scratch]", baseline_mu,
+    array_size);
+  algorithm.SetArena(arena);
 }
 
 // main
@@ -332,6 +463,31 @@ int main(int argc, const char **argv)
 
   int arg_idx = 1;
   bool test_already_sorted = false;
+  bool incremental_bench = false;
+  const char *calibrate_path = nullptr;
+  const char *profile_path = nullptr;
+  bool small_sort_bench = false;
+  bool segmented_bench = false;
+  int concurrency_max = 0;
+  int thread_max = 0;
+  bool scaling_bench = false;
+  bool lock_bench = false;
+  bool numa_bench = false;
+  bool key_bench = false;
+  const char *type_name = nullptr;
+  const char *string_set = nullptr;
+  int argsort_columns = 0;
+  const char *column_spec = nullptr;
+  bool dup_bench = false;
+  bool cache_bench = false;
+  bool lazy_bench = false;
+  const char *trace_path = nullptr;
+  const char *service_path = nullptr;
+  const char *client_path = nullptr;
+  const char *engine_name = nullptr;
+  bool use_shm = false;
+  const char *kernel_name = nullptr;
+  size_t small_sort_max = 0;
   while ('-' == argv[arg_idx][0])
   {
     switch (argv[arg_idx][1]) {
@@ -347,6 +503,138 @@ int main(int argc, const char **argv)
        case 's':
         test_already_sorted = true;
         break;
+      case 'b':
+        incremental_bench = true;
+        break;
+      case 'N':
+        small_sort_bench = true;
+        break;
+      case 'g':
+        segmented_bench = true;
+        break;
+      case 'c':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        concurrency_max = atoi(argv[++arg_idx]);
+        if (concurrency_max < 1)
+          concurrency_max = 1;
+        break;
+      case 't':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        thread_max = atoi(argv[++arg_idx]);
+        if (thread_max < 1)
+          thread_max = 1;
+        break;
+      case 'T':
+        scaling_bench = true;
+        break;
+      case 'L':
+        lock_bench = true;
+        break;
+      case 'U':
+        numa_bench = true;
+        break;
+      case 'K':
+        key_bench = true;
+        break;
+      case 'y':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        type_name = argv[++arg_idx];
+        break;
+      case 'S':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        string_set = argv[++arg_idx];
+        break;
+      case 'a':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        argsort_columns = atoi(argv[++arg_idx]);
+        if (argsort_columns < 1)
+          argsort_columns = 1;
+        break;
+      case 'M':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        column_spec = argv[++arg_idx];
+        break;
+      case 'D':
+        dup_bench = true;
+        break;
+      case 'H':
+        cache_bench = true;
+        break;
+      case 'k':
+        lazy_bench = true;
+        break;
+      case 'R':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        trace_path = argv[++arg_idx];
+        break;
+      case 'Q':
+      case 'q':
+      case 'E':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        if ('Q' == argv[arg_idx][1])
+          service_path = argv[++arg_idx];
+        else if ('q' == argv[arg_idx][1])
+          client_path = argv[++arg_idx];
+        else
+          engine_name = argv[++arg_idx];
+        break;
+      case 'Z':
+        use_shm = true;
+        break;
+      case 'X':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        kernel_name = argv[++arg_idx];
+        break;
+      case 'A':
+        heap_scratch_too = true;
+        break;
+      case 'n':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        small_sort_max = strtoul(argv[++arg_idx], nullptr, 10);
+        if (small_sort_max > kSortNetworkMax)
+          small_sort_max = kSortNetworkMax;
+        break;
+      case 'C':
+      case 'P':
+        if (!argv[arg_idx + 1]) {
+          PrintUsage();
+          return -1;
+        }
+        if ('C' == argv[arg_idx][1])
+          calibrate_path = argv[++arg_idx];
+        else
+          profile_path = argv[++arg_idx];
+        break;
       default:
         PrintUsage();
         return -1;
@@ -355,18 +643,48 @@ int main(int argc, const char **argv)
   }
 
   int algo_total = 0;
+  // The std::sort reference runs first on every data set, so each engine
+  // after it can be reported relative to it.
+  StdSort *std_sort = new StdSort();
+  algo_arr.push_back(std_sort);
+  algo_arr.push_back(new StdStableSort());
+  algo_arr.push_back(new StdHeapSort());
+  algo_arr.push_back(new QSort());
+  algo_arr.push_back(new StdSortParallel());
   algo_arr.push_back(new QuickSort());
   algo_arr.push_back(new QuickSortRandomized());
+  algo_arr.push_back(new QuickSort3Way());
+  algo_arr.push_back(new QuickSortIncremental());
   if (!memory_efficient_only) {
     algo_arr.push_back(new CountingSort());
+    algo_arr.push_back(new CountingSortParallel());
     algo_arr.push_back(new RadixSort());
   }
   algo_arr.push_back(new MergeSort());
   algo_arr.push_back(new MergeSortMultiCore());
+  algo_arr.push_back(new MergeSortTiled());
+  algo_arr.push_back(new FunnelSort());
   algo_arr.push_back(new HeapSort());
+  algo_arr.push_back(new HeapSortIterative());
+  algo_arr.push_back(new HeapSortBottomUp());
+  algo_arr.push_back(new HeapSortDary(4));
+  algo_arr.push_back(new HeapSortDary(8));
   if (!fast_only) {
     algo_arr.push_back(new InsertionSort());
   }
+  AutoSort *auto_sort = new AutoSort();
+  if (profile_path && !auto_sort->LoadProfile(profile_path)) {
+    delete auto_sort;
+    for (auto i : algo_arr)
+      delete i;
+    return -1;
+  }
+  algo_arr.push_back(auto_sort);
+  for (auto i : algo_arr) {
+    i->SetSmallSortMax(small_sort_max);
+    if (thread_max)
+      i->SetThreadMax(thread_max);
+  }
 
   if (!argv[arg_idx] || !argv[arg_idx + 1]) {
     PrintUsage();
@@ -382,6 +700,108 @@ int main(int argc, const char **argv)
     return -1;
   }
 
+  // Kernels are chosen by cpuid unless -X asks for a lower level.
+  if (kernel_name &&
+      !SetSortKernelLevel(FindKernelLevel(kernel_name))) {
+    printf("Kernel level %s is unknown or unsupported by this CPU.\n",
+      kernel_name);
+    return -1;
+  }
+  std::cout << "Kernels: " << GetSortKernels().name << " (CPU supports "
+       << GetKernelLevelName(GetCpuKernelLevel()) << ")" << std::endl;
+
+  if (incremental_bench || calibrate_path || small_sort_bench ||
+      segmented_bench || concurrency_max || scaling_bench || lock_bench ||
+      numa_bench || key_bench || type_name || string_set ||
+      argsort_columns || column_spec || dup_bench || cache_bench ||
+      lazy_bench || trace_path || service_path || client_path) {
+    if (service_path)
+      result = RunServiceDaemon(service_path, algo_arr, thread_max ?
+        thread_max : std::max(1, (int) std::thread::hardware_concurrency()));
+    else if (client_path)
+      result = RunServiceClient(client_path, engine_name, array_size,
+        iteration_tot, use_shm);
+    else if (dup_bench)
+      result = RunDupBench(array_size, iteration_tot);
+    else if (cache_bench)
+      result = RunCacheBench(array_size, iteration_tot);
+    else if (lazy_bench)
+      result = RunLazyBench(array_size, iteration_tot);
+    else if (trace_path)
+      result = RunTraceBench(trace_path, array_size, iteration_tot,
+        thread_max ? thread_max :
+        std::max(1, (int) std::thread::hardware_concurrency()));
+    else if (column_spec)
+      result = RunMultiKeyBench(column_spec, array_size, iteration_tot);
+    else if (argsort_columns)
+      result = RunArgsortBench(array_size, iteration_tot, argsort_columns,
+        thread_max ? thread_max :
+        std::max(1, (int) std::thread::hardware_concurrency()));
+    else if (string_set)
+      result = RunStringBench(string_set, array_size, iteration_tot);
+    else if (type_name)
+      result = RunTypedBench(type_name, array_size, iteration_tot, fast_only);
+    else if (key_bench)
+      result = RunKeyBench(array_size, iteration_tot);
+    else if (numa_bench)
+      result = RunNumaBench(array_size, iteration_tot, thread_max);
+    else if (lock_bench)
+      result = RunLockBench(array_size, iteration_tot, thread_max ?
+        thread_max : std::max(4, (int) std::thread::hardware_concurrency()));
+    else if (scaling_bench)
+      result = RunScalingBench(array_size, iteration_tot, thread_max ?
+        thread_max : std::max(1, (int) std::thread::hardware_concurrency()));
+    else if (concurrency_max)
+      result = RunConcurrentBench(algo_arr, array_size, iteration_tot,
+        concurrency_max);
+    else if (segmented_bench)
+      result = RunSegmentedBench(array_size, iteration_tot, thread_max);
+    else if (small_sort_bench)
+      result = RunSmallSortBench(array_size, iteration_tot);
+    else if (calibrate_path)
+      result = RunCalibration(array_size, iteration_tot, calibrate_path);
+    else
+      result = RunIncrementalBench(array_size, iteration_tot);
+    for (auto i : algo_arr)
+      delete i;
+    return result;
+  }
+
+  // Scratch memory is reserved once, for the hungriest engine, so that no
+  // engine allocates inside its timed sorts.
+  Arena arena;
+  size_t scratch_size = 0;
+  for (auto i : algo_arr)
+    scratch_size = std::max(scratch_size, i->GetScratchSize(array_size));
+  if (arena.Reserve(scratch_size)) {
+    for (auto i : algo_arr)
+      i->SetArena(&arena);
+  } else {
+    printf("Failed to reserve %zu bytes of scratch; using the heap.\n",
+      scratch_size);
+  }
+
+  // The bandwidth roofline is only worth measuring when some engine's
+  // traffic at this size reaches memory.
+  bool beyond_cache = false;
+  for (auto i : algo_arr)
+    beyond_cache = beyond_cache || i->GetMemoryBytes(array_size) > 0.0;
+  if (beyond_cache) {
+    int stream_threads = thread_max ? thread_max :
+      std::max(1, (int) std::thread::hardware_concurrency());
+    if (MeasureStreamBandwidth(1, stream_one)) {
+      std::cout << "Memory bandwidth (1 thread): read " << stream_one.read
+                << " GB/s, write " << stream_one.write << " GB/s, copy "
+                << stream_one.copy << " GB/s" << std::endl;
+    }
+    if (stream_threads > 1 &&
+        MeasureStreamBandwidth(stream_threads, stream_all)) {
+      std::cout << "Memory bandwidth (" << stream_threads << " threads): read "
+                << stream_all.read << " GB/s, write " << stream_all.write
+                << " GB/s, copy " << stream_all.copy << " GB/s" << std::endl;
+    }
+  }
+
   // Timing variables for statistical analysis
   std::vector<double> time_arr; //[kAlgoTot];
   // Allocate our array
@@ -393,8 +813,9 @@ int main(int argc, const char **argv)
     std::cout << COUT_AQUA << "UNIQUE:";
     CreateUniqueDataSet(master_array, array_size);
     std::cout << COUT_NORMAL << std::endl;
+    double baseline_mu = 0.0;
     for (auto i : algo_arr) {
-      RunTest(
+      bool passed = RunTest(
         time_arr,
         *i,
         master_array,
@@ -403,13 +824,21 @@ int main(int argc, const char **argv)
         iteration_tot,
         true
       );
-      ReportStatistics(
+      double mu = ReportStatistics(
         time_arr,
         iteration_tot,
         *i,
-        VerifyNonDescending(array, array_size)
+        passed,
+        nullptr,
+        baseline_mu,
+        array_size
       );
-      i->ResetMaxRecurseDepth();
+      if (i == std_sort)
+        baseline_mu = mu;
+      i->ResetStats();
+      RunHeapScratchTest(*i, master_array, array, array_size, iteration_tot,
+        baseline_mu);
+      i->ResetStats();
       time_arr.clear();
     }
     if (test_already_sorted) {
@@ -417,8 +846,9 @@ int main(int argc, const char **argv)
       std::cout << COUT_AQUA << "ALREADY-SORTED:";
       CreateSortedDataSet(master_array, array_size);
       std::cout << COUT_NORMAL << std::endl;
+      baseline_mu = 0.0;
       for (auto i : algo_arr) {
-        RunTest(
+        bool passed = RunTest(
           time_arr,
           *i,
           master_array,
@@ -427,13 +857,21 @@ int main(int argc, const char **argv)
           iteration_tot,
           true
         );
-        ReportStatistics(
+        double mu = ReportStatistics(
           time_arr,
           iteration_tot,
           *i,
-          VerifyNonDescending(array, array_size)
+          passed,
+          nullptr,
+          baseline_mu,
+          array_size
         );
-        i->ResetMaxRecurseDepth();
+        if (i == std_sort)
+          baseline_mu = mu;
+        i->ResetStats();
+        RunHeapScratchTest(*i, master_array, array, array_size,
+          iteration_tot, baseline_mu);
+        i->ResetStats();
         time_arr.clear();
       }
     }
@@ -442,8 +880,9 @@ int main(int argc, const char **argv)
     // This runs the sorting tests against data sets containing duplicates.
     std::cout << COUT_AQUA << "NONUNIQUE:" << COUT_NORMAL << std::endl;
     CreateRandomDataSet(master_array, array_size, array_size / 2);
+    baseline_mu = 0.0;
     for (auto i : algo_arr) {
-      RunTest(
+      bool passed = RunTest(
         time_arr,
         *i,
         master_array,
@@ -452,13 +891,21 @@ int main(int argc, const char **argv)
         iteration_tot,
         false
       );
-      ReportStatistics(
+      double mu = ReportStatistics(
         time_arr,
         iteration_tot,
         *i,
-        VerifyNonDescending(array, array_size)
+        passed,
+        nullptr,
+        baseline_mu,
+        array_size
       );
-      i->ResetMaxRecurseDepth();
+      if (i == std_sort)
+        baseline_mu = mu;
+      i->ResetStats();
+      RunHeapScratchTest(*i, master_array, array, array_size, iteration_tot,
+        baseline_mu);
+      i->ResetStats();
       time_arr.clear();
     }
   } else {
@@ -469,8 +916,8 @@ int main(int argc, const char **argv)
 
   // Clean up
   if (nullptr != array) {
-    delete master_array;
-    delete array;
+    FreeArray(master_array);
+    FreeArray(array);
     array = nullptr;
   }
 
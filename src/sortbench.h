@@ -0,0 +1,102 @@
+// sortbench.h
+//
+// Harness utilities shared between the sortbench benchmark modes.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORTBENCH_H_
+#define SORTBENCH_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "algo.h"
+#include "sort_types.h"
+
+// Data set helpers (sortbench.cc)
+void PrintArray(const hedger::S_T *array, size_t n);
+hedger::S_T *AllocArray(size_t size);
+void FreeArray(hedger::S_T *array);
+void CreateRandomDataSet(hedger::S_T *array, size_t size, size_t range = 0);
+void CreateSortedDataSet(hedger::S_T *array, size_t size);
+void CreateUniqueDataSet(hedger::S_T *array, size_t size);
+bool VerifyNonDescending(hedger::S_T *array, size_t size);
+
+// Typed data set helpers (sortbench_keys.cc)
+uint64_t RandomBits();
+template <class T> T RandomKey();
+template <> float RandomKey<float>();
+template <> double RandomKey<double>();
+template <> hedger::KeyRecord RandomKey<hedger::KeyRecord>();
+
+// Benchmark modes (sortbench_<mode>.cc)
+int RunIncrementalBench(size_t array_size, int iteration_tot);
+int RunCalibration(size_t array_size, int iteration_tot, const char *path);
+int RunSmallSortBench(size_t group_tot, int iteration_tot);
+int RunSegmentedBench(size_t array_size, int iteration_tot, int thread_max);
+int RunConcurrentBench(
+  std::vector<hedger::Algo *>& algo_arr,
+  size_t array_size,
+  int iteration_tot,
+  int concurrency_max
+);
+int RunScalingBench(size_t array_size, int iteration_tot, int thread_max);
+int RunLockBench(size_t hold_size, int iteration_tot, int thread_max);
+int RunNumaBench(size_t array_size, int iteration_tot, int thread_max);
+int RunKeyBench(size_t array_size, int iteration_tot);
+int RunStringBench(const char *set_name, size_t array_size, int iteration_tot);
+int RunArgsortBench(
+  size_t array_size,
+  int iteration_tot,
+  int col_tot,
+  int thread_max
+);
+int RunMultiKeyBench(const char *spec_text, size_t array_size,
+  int iteration_tot);
+int RunDupBench(size_t array_size, int iteration_tot);
+int RunCacheBench(size_t array_size, int iteration_tot);
+int RunLazyBench(size_t array_size, int iteration_tot);
+int RunTraceBench(
+  const char *path,
+  size_t array_size,
+  int iteration_tot,
+  int thread_max
+);
+int RunServiceDaemon(
+  const char *path,
+  std::vector<hedger::Algo *>& algo_arr,
+  int worker_tot
+);
+int RunServiceClient(
+  const char *path,
+  const char *engine_name,
+  size_t array_size,
+  int iteration_tot,
+  bool use_shm
+);
+int RunTypedBench(
+  const char *type_name,
+  size_t array_size,
+  int iteration_tot,
+  bool fast_only
+);
+
+#endif // SORTBENCH_H_
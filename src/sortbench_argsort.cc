@@ -0,0 +1,287 @@
+// sortbench_argsort.cc
+//
+// Argsort benchmark: sort a key column into a permutation and gather the
+// payload columns through it, against sorting whole rows.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdint.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "arg_sort.h"
+
+// Most payload columns
+const int kArgColumnMax = 8;
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+// ArgRow
+// One row of the row-store layout: the key and col_tot payloads
+template <int N> struct ArgRow {
+  int64_t key;
+  int64_t payload[N];
+};
+
+// TimeRowSort
+// Sort the table as rows (std::sort or std::stable_sort on the key).
+// Payload c of row r is r * (c + 1), so a row that stayed whole checks.
+// Entry: key column
+//        rows
+//        repetitions
+//        true == std::stable_sort
+//        set false on a bad result
+// Exit:  mean ms
+template <int N> static double TimeRowSort(
+  const std::vector<int64_t>& keys,
+  int iteration_tot,
+  bool stable,
+  bool& passed)
+{
+  using namespace std;
+  size_t size = keys.size();
+  vector<ArgRow<N> > master(size);
+  for (size_t r = 0; r < size; ++r) {
+    master[r].key = keys[r];
+    for (int c = 0; c < N; ++c)
+      master[r].payload[c] = (int64_t) r * (c + 1);
+  }
+  auto less = [](const ArgRow<N>& a, const ArgRow<N>& b) {
+    return a.key < b.key;
+  };
+  double ms = 0.0;
+  vector<ArgRow<N> > rows;
+  for (int it = 0; it < iteration_tot; ++it) {
+    rows = master;
+    auto start = chrono::high_resolution_clock::now();
+    if (stable)
+      stable_sort(rows.begin(), rows.end(), less);
+    else
+      sort(rows.begin(), rows.end(), less);
+    auto stop = chrono::high_resolution_clock::now();
+    ms += FpMilliseconds(stop - start).count();
+  }
+  for (size_t r = 0; passed && r < size; ++r) {
+    if (r && rows[r].key < rows[r - 1].key)
+      passed = false;
+    int64_t row = rows[r].payload[0];
+    if (keys[row] != rows[r].key)
+      passed = false;
+    for (int c = 1; c < N; ++c)
+      if (rows[r].payload[c] != row * (c + 1))
+        passed = false;
+  }
+  return ms / iteration_tot;
+}
+
+// TimeRowSortColumns
+// Dispatch TimeRowSort on the payload column count
+static double TimeRowSortColumns(
+  const std::vector<int64_t>& keys,
+  int iteration_tot,
+  int col_tot,
+  bool stable,
+  bool& passed)
+{
+  switch (col_tot) {
+    case 1: return TimeRowSort<1>(keys, iteration_tot, stable, passed);
+    case 2: return TimeRowSort<2>(keys, iteration_tot, stable, passed);
+    case 3: return TimeRowSort<3>(keys, iteration_tot, stable, passed);
+    case 4: return TimeRowSort<4>(keys, iteration_tot, stable, passed);
+    case 5: return TimeRowSort<5>(keys, iteration_tot, stable, passed);
+    case 6: return TimeRowSort<6>(keys, iteration_tot, stable, passed);
+    case 7: return TimeRowSort<7>(keys, iteration_tot, stable, passed);
+    default: return TimeRowSort<8>(keys, iteration_tot, stable, passed);
+  }
+}
+
+// ArgPath
+// One argsort engine at one permutation width
+template <class Index> struct ArgPath {
+  const char *name;
+  int (*sort)(const int64_t *, size_t, Index *, hedger::Arena *);
+  bool stable;
+};
+
+// TimeArgPath
+// Time an argsort and the gather of the key and every payload column
+// through its permutation.
+// Entry: path
+//        column-store table: key column first, then the payloads
+//        repetitions
+//        gather threads
+//        arena for the sort's scratch
+//        set false on a bad result
+//        argsort mean ms out
+//        gather mean ms out
+template <class Index> static void TimeArgPath(
+  const ArgPath<Index>& path,
+  std::vector<std::vector<int64_t> >& col_arr,
+  int iteration_tot,
+  int thread_max,
+  hedger::Arena *arena,
+  bool& passed,
+  double& sort_ms,
+  double& gather_ms)
+{
+  using namespace std;
+  size_t size = col_arr[0].size();
+  int col_tot = (int) col_arr.size();
+  vector<Index> perm(size);
+  vector<vector<int64_t> > out_arr(col_tot, vector<int64_t>(size));
+  vector<const int64_t *> src_cols(col_tot);
+  vector<int64_t *> dst_cols(col_tot);
+  for (int c = 0; c < col_tot; ++c) {
+    src_cols[c] = &col_arr[c][0];
+    dst_cols[c] = &out_arr[c][0];
+  }
+
+  sort_ms = gather_ms = 0.0;
+  for (int it = 0; it < iteration_tot; ++it) {
+    auto start = chrono::high_resolution_clock::now();
+    if (path.sort(&col_arr[0][0], size, &perm[0], arena))
+      passed = false;
+    auto mid = chrono::high_resolution_clock::now();
+    hedger::ParallelGather(&perm[0], size, &src_cols[0], &dst_cols[0],
+      col_tot, thread_max);
+    auto stop = chrono::high_resolution_clock::now();
+    sort_ms += FpMilliseconds(mid - start).count();
+    gather_ms += FpMilliseconds(stop - mid).count();
+  }
+  sort_ms /= iteration_tot;
+  gather_ms /= iteration_tot;
+
+  // Keys in order (rows of equal keys in row order when stable), and each
+  // payload gathered from the row its key came from
+  for (size_t i = 0; passed && i < size; ++i) {
+    if (i && out_arr[0][i] < out_arr[0][i - 1])
+      passed = false;
+    if (i && path.stable && out_arr[0][i] == out_arr[0][i - 1] &&
+        perm[i] < perm[i - 1])
+      passed = false;
+    for (int c = 1; c < col_tot; ++c)
+      if (out_arr[c][i] != (int64_t) perm[i] * c)
+        passed = false;
+  }
+}
+
+// ReportArgRow
+static void ReportArgRow(
+  const char *name,
+  bool passed,
+  double sort_ms,
+  double gather_ms,
+  double baseline_ms)
+{
+  using namespace std;
+  double total_ms = sort_ms + gather_ms;
+  cout << COUT_WHITE << name
+       << (passed ? COUT_GREEN " (PASS)" : COUT_RED " (FAIL)")
+       << COUT_NORMAL << "\t" << sort_ms << "\t" << gather_ms << "\t"
+       << total_ms << "\t"
+       << (total_ms > 0.0 ? baseline_ms / total_ms : 0.0) << "x" << endl;
+}
+
+// RunArgsortBench
+// Entry: rows
+//        repetitions
+//        payload columns (1..8)
+//        gather threads
+// Exit:  0 == success
+int RunArgsortBench(
+  size_t array_size,
+  int iteration_tot,
+  int col_tot,
+  int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+
+  col_tot = max(1, min(col_tot, kArgColumnMax));
+  // Keys repeat about twice each, so stability is visible
+  int64_t range = (int64_t) array_size / 2 + 1;
+  vector<vector<int64_t> > col_arr(col_tot + 1,
+    vector<int64_t>(array_size));
+  for (size_t r = 0; r < array_size; ++r) {
+    col_arr[0][r] = (int64_t) (RandomBits() % range) - range / 2;
+    for (int c = 1; c <= col_tot; ++c)
+      col_arr[c][r] = (int64_t) r * c;
+  }
+
+  cout << COUT_AQUA << "Argsort: " << COUT_NORMAL << array_size
+       << " rows, int64 key + " << col_tot << " int64 payload columns, "
+       << thread_max << " gather threads" << endl;
+  cout << "path\tsort ms\tgather ms\ttotal ms\tvs row sort" << endl;
+
+  int result = 0;
+  bool passed = true;
+  double baseline_ms = TimeRowSortColumns(col_arr[0], iteration_tot,
+    col_tot, false, passed);
+  ReportArgRow("Row std::sort", passed, baseline_ms, 0.0, baseline_ms);
+  result |= passed ? 0 : -1;
+  passed = true;
+  double ms = TimeRowSortColumns(col_arr[0], iteration_tot, col_tot, true,
+    passed);
+  ReportArgRow("Row std::stable_sort", passed, ms, 0.0, baseline_ms);
+  result |= passed ? 0 : -1;
+
+  Arena arena;
+  if (!arena.Reserve(ArgSortScratchSize<int64_t, uint64_t>(array_size)))
+    printf("Failed to reserve argsort scratch; using the heap.\n");
+
+  const ArgPath<uint32_t> path32_arr[] = {
+    { "Radix argsort u32 (stable)", ArgRadixSort<int64_t, uint32_t>, true },
+    { "Merge argsort u32 (stable)", ArgMergeSort<int64_t, uint32_t>, true },
+    { "Quick argsort u32", ArgQuickSort<int64_t, uint32_t>, false },
+  };
+  const ArgPath<uint64_t> path64_arr[] = {
+    { "Radix argsort u64 (stable)", ArgRadixSort<int64_t, uint64_t>, true },
+    { "Merge argsort u64 (stable)", ArgMergeSort<int64_t, uint64_t>, true },
+    { "Quick argsort u64", ArgQuickSort<int64_t, uint64_t>, false },
+  };
+  double sort_ms, gather_ms;
+  if (array_size <= UINT32_MAX) {
+    for (auto& path : path32_arr) {
+      passed = true;
+      TimeArgPath(path, col_arr, iteration_tot, thread_max, &arena, passed,
+        sort_ms, gather_ms);
+      ReportArgRow(path.name, passed, sort_ms, gather_ms, baseline_ms);
+      result |= passed ? 0 : -1;
+    }
+  }
+  for (auto& path : path64_arr) {
+    passed = true;
+    TimeArgPath(path, col_arr, iteration_tot, thread_max, &arena, passed,
+      sort_ms, gather_ms);
+    ReportArgRow(path.name, passed, sort_ms, gather_ms, baseline_ms);
+    result |= passed ? 0 : -1;
+  }
+  return result;
+}
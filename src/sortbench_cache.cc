@@ -0,0 +1,190 @@
+// sortbench_cache.cc
+//
+// Cache hierarchy benchmark: the binary merge sort against the cache-aware
+// tiled merge sort and the cache-oblivious funnelsort, with the memory
+// traffic of each merge level.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "cache_info.h"
+#include "merge_sort.h"
+#include "merge_sort_cache.h"
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+const double kCacheMegabyte = 1024.0 * 1024.0;
+
+// ReportTraffic
+// Print an engine's traffic, level by level, and the passes that had to
+// stream the whole array because its runs outgrew L2.
+// Entry: engine name
+//        traffic of one instrumented call
+//        L2 bytes
+static void ReportTraffic(const char *name, const hedger::MergeTraffic&
+  traffic, size_t l2)
+{
+  using namespace std;
+  unsigned long long stream_tot = 0, local_tot = 0;
+  int memory_pass_tot = 0;
+  cout << COUT_WHITE << name << COUT_NORMAL << endl;
+  cout << "\tlevel\trun keys\tstream MB\tlocal MB" << endl;
+  for (int level = 0; level < traffic.GetLevelTot(); ++level) {
+    const hedger::MergeLevel& entry = traffic.GetLevel(level);
+    cout << "\t" << level << "\t" << entry.run_max << "\t\t"
+         << entry.stream_bytes / kCacheMegabyte << "\t\t"
+         << entry.local_bytes / kCacheMegabyte << endl;
+    stream_tot += entry.stream_bytes;
+    local_tot += entry.local_bytes;
+    if (entry.run_max * sizeof(hedger::S_T) * 2 > l2)
+      ++memory_pass_tot;
+  }
+  cout << "\ttotal\t\t\t" << stream_tot / kCacheMegabyte << "\t\t"
+       << local_tot / kCacheMegabyte << "\t(" << memory_pass_tot
+       << " levels beyond L2)" << endl;
+}
+
+// ReportBinaryTraffic
+// MergeSort has no counters of its own; model it instead.  Every binary
+// level merges the whole array into the scratch and copies it back, so it
+// reads and writes the array twice.
+// Entry: array size in elements
+//        L2 bytes
+static void ReportBinaryTraffic(size_t array_size, size_t l2)
+{
+  using namespace std;
+  unsigned long long level_bytes = 4ULL * array_size * sizeof(hedger::S_T);
+  int level_tot = 0, memory_pass_tot = 0;
+  for (size_t run = 2; run / 2 < array_size; run <<= 1) {
+    ++level_tot;
+    if (min(run, array_size) * sizeof(hedger::S_T) * 2 > l2)
+      ++memory_pass_tot;
+  }
+  cout << COUT_WHITE << "Merge Sort (model)" << COUT_NORMAL << endl;
+  cout << "\t" << level_tot << " binary levels of "
+       << level_bytes / kCacheMegabyte << " MB each\t"
+       << level_tot * level_bytes / kCacheMegabyte << " MB\t("
+       << memory_pass_tot << " levels beyond L2)" << endl;
+}
+
+// RunCacheBench
+// Report the detected caches, time the merge sorts on random keys against
+// std::sort, then make one instrumented call of each cache-conscious
+// engine and report its traffic.
+// Entry: array size in elements
+//        repetitions
+// Exit:  0 == success
+int RunCacheBench(size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  CacheInfo& cache = CacheInfo::Get();
+  MergeSort merge_sort;
+  MergeSortTiled tiled;
+  FunnelSort funnel;
+  cout << COUT_AQUA << "Caches (" << cache.GetSource() << "): "
+       << COUT_NORMAL << "L1 " << cache.GetL1() / 1024 << " KB, L2 "
+       << cache.GetL2() / 1024 << " KB, L3 " << cache.GetL3() / 1024
+       << " KB, line " << cache.GetLineSize() << " B" << endl;
+  cout << tiled.GetName() << ": tiles of " << tiled.GetTileSize()
+       << " keys, fan-in " << tiled.GetFanIn() << endl;
+
+  vector<Algo *> engine_arr = { &merge_sort, &tiled, &funnel };
+  Arena arena;
+  size_t scratch_size = 0;
+  for (auto engine : engine_arr)
+    scratch_size = max(scratch_size, engine->GetScratchSize(array_size));
+  if (arena.Reserve(scratch_size))
+    for (auto engine : engine_arr)
+      engine->SetArena(&arena);
+
+  vector<S_T> master(array_size), sorted, arr(array_size);
+  CreateRandomDataSet(&master[0], array_size);
+  sorted = master;
+
+  // std::sort first, as the baseline
+  double baseline_ms = 0.0;
+  for (int it = 0; it < iteration_tot; ++it) {
+    arr = master;
+    auto start = chrono::high_resolution_clock::now();
+    sort(arr.begin(), arr.end());
+    auto stop = chrono::high_resolution_clock::now();
+    baseline_ms += FpMilliseconds(stop - start).count();
+  }
+  baseline_ms /= iteration_tot;
+  sorted = arr;
+  cout << COUT_WHITE << "std::sort" << COUT_NORMAL << "\t" << CHAR_MU
+       << ":" << baseline_ms << " ms" << endl;
+
+  int result = 0;
+  for (auto engine : engine_arr) {
+    double ms = 0.0;
+    bool passed = true;
+    for (int it = 0; it < iteration_tot; ++it) {
+      memcpy(&arr[0], &master[0], array_size * sizeof(S_T));
+      auto start = chrono::high_resolution_clock::now();
+      int error = engine->Test(&arr[0], array_size);
+      auto stop = chrono::high_resolution_clock::now();
+      ms += FpMilliseconds(stop - start).count();
+      passed = passed && !error && arr == sorted;
+    }
+    ms /= iteration_tot;
+    cout << COUT_WHITE << engine->GetName();
+    if (passed) {
+      cout << COUT_GREEN << " (PASS)";
+    } else {
+      cout << COUT_RED << " (FAIL)";
+      result = -1;
+    }
+    cout << COUT_NORMAL << "\t" << CHAR_MU << ":" << ms << " ms\t"
+         << (ms > 0.0 ? baseline_ms / ms : 0.0) << "x" << endl;
+  }
+
+  // Traffic of one call each
+  cout << COUT_AQUA << "MEMORY TRAFFIC PER LEVEL:" << COUT_NORMAL << endl;
+  ReportBinaryTraffic(array_size, cache.GetL2());
+  memcpy(&arr[0], &master[0], array_size * sizeof(S_T));
+  tiled.ResetTraffic();
+  tiled.SetInstrumented(true);
+  tiled.Test(&arr[0], array_size);
+  tiled.SetInstrumented(false);
+  ReportTraffic(tiled.GetName(), tiled.GetTraffic(), cache.GetL2());
+  memcpy(&arr[0], &master[0], array_size * sizeof(S_T));
+  funnel.ResetTraffic();
+  funnel.SetInstrumented(true);
+  funnel.Test(&arr[0], array_size);
+  funnel.SetInstrumented(false);
+  ReportTraffic(funnel.GetName(), funnel.GetTraffic(), cache.GetL2());
+  return result;
+}
@@ -0,0 +1,327 @@
+// sortbench_calibrate.cc
+//
+// Calibration mode: measures engine crossover points on this machine and
+// writes them as an AutoSort profile.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "auto_sort.h"
+#include "counting_sort.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "merge_sort_multicore.h"
+#include "quick_sort.h"
+#include "radix_sort.h"
+
+// Each measurement sorts at least this many elements in total so that
+// tiny arrays are timed over many repetitions.
+static const size_t kCalibrateElementMin = 1 << 16;
+// Largest counting sort table calibration will try.
+static const size_t kCalibrateRangeMax = 1 << 26;
+
+// CreateNearlySortedDataSet
+// Ascending data with a few adjacent pairs swapped, giving roughly half
+// the AutoSort nearly-sorted descent threshold.
+// Entry: array
+//        size in elements
+//        target descent rate
+static void CreateNearlySortedDataSet(
+  hedger::S_T *array,
+  size_t size,
+  double descent_rate)
+{
+  CreateSortedDataSet(array, size);
+  size_t swap_tot = (size_t) (descent_rate * 0.5 * size);
+  for (size_t i = 0; i < swap_tot && size > 1; ++i) {
+    size_t pos = rand() % (size - 1);
+    hedger::S_T swap = array[pos];
+    array[pos] = array[pos + 1];
+    array[pos + 1] = swap;
+  }
+}
+
+// CreateDisplacedDataSet
+// Ascending data with a fraction of keys swapped with keys anywhere in
+// the array, which raises the sampled inversion rate as well as the
+// descent rate.
+// Entry: array
+//        size in elements
+//        fraction of keys swapped
+static void CreateDisplacedDataSet(
+  hedger::S_T *array,
+  size_t size,
+  double swap_rate)
+{
+  CreateSortedDataSet(array, size);
+  size_t swap_tot = (size_t) (swap_rate * 0.5 * size);
+  for (size_t i = 0; i < swap_tot && size > 1; ++i) {
+    size_t a = rand() % size;
+    size_t b = rand() % size;
+    hedger::S_T swap = array[a];
+    array[a] = array[b];
+    array[b] = swap;
+  }
+}
+
+// CreateRunsDataSet
+// Random data cut into ascending runs of a given length.
+// Entry: array
+//        size in elements
+//        run length
+static void CreateRunsDataSet(
+  hedger::S_T *array,
+  size_t size,
+  size_t run_length)
+{
+  CreateRandomDataSet(array, size, size);
+  for (size_t start = 0; start < size; start += run_length)
+    std::sort(array + start, array + std::min(size, start + run_length));
+}
+
+// TimeSort
+// Time one engine on a data set, repeating on fresh copies as needed.
+// Entry: algorithm
+//        master data set
+//        work array
+//        size in elements
+//        minimum repetitions
+// Exit:  mean ns per sort
+static double TimeSort(
+  hedger::Algo& algorithm,
+  const hedger::S_T *master_array,
+  hedger::S_T *array,
+  size_t size,
+  int iteration_tot)
+{
+  using namespace std;
+  using FpNanoseconds =
+        chrono::duration<double, chrono::nanoseconds::period>;
+  hedger::S_T range = 0;
+  for (size_t i = 0; i < size; ++i)
+    if (master_array[i] > range)
+      range = master_array[i];
+
+  size_t reps = kCalibrateElementMin / size;
+  if (reps < (size_t) iteration_tot)
+    reps = iteration_tot;
+  double ns = 0.0;
+  for (size_t i = 0; i < reps; ++i) {
+    memcpy(array, master_array, size * sizeof(hedger::S_T));
+    auto start = chrono::high_resolution_clock::now();
+    algorithm.Test(array, size, range);
+    auto stop = chrono::high_resolution_clock::now();
+    ns += FpNanoseconds(stop - start).count();
+  }
+  algorithm.ResetStats();
+  return ns / reps;
+}
+
+// RunCalibration
+// Find the crossover points AutoSort dispatches on and save them.
+// Entry: largest array size to try
+//        minimum repetitions per measurement
+//        path of profile to write
+// Exit:  0 == success
+int RunCalibration(size_t array_size, int iteration_tot, const char *path)
+{
+  using namespace std;
+  using namespace hedger;
+
+  S_T *master_array = AllocArray(array_size);
+  S_T *array = AllocArray(array_size);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+
+  InsertionSort insertion_sort;
+  CountingSort counting_sort;
+  RadixSort radix_sort;
+  QuickSort quick_sort;
+  MergeSort merge_sort;
+  MergeSortMultiCore merge_sort_multicore;
+  AutoSortProfile profile;
+
+  cout << COUT_AQUA << "CALIBRATE:" << COUT_NORMAL << endl;
+
+  // Small random arrays: insertion sort against the comparison sorts.
+  profile.insertion_max = 0;
+  for (size_t n = 4; n <= 1024 && n <= array_size; n <<= 1) {
+    CreateRandomDataSet(master_array, n, n);
+    double insertion = TimeSort(insertion_sort, master_array, array, n,
+      iteration_tot);
+    double quick = TimeSort(quick_sort, master_array, array, n,
+      iteration_tot);
+    double merge = TimeSort(merge_sort, master_array, array, n,
+      iteration_tot);
+    if (insertion < quick && insertion < merge)
+      profile.insertion_max = n;
+  }
+  cout << "insertion_max " << profile.insertion_max << endl;
+
+  // Nearly-sorted arrays: insertion sort against merge sort.
+  profile.presorted_insertion_max = profile.insertion_max;
+  for (size_t n = 64; n <= array_size; n <<= 1) {
+    CreateNearlySortedDataSet(master_array, n,
+      profile.presorted_descent_max);
+    double insertion = TimeSort(insertion_sort, master_array, array, n,
+      iteration_tot);
+    double merge = TimeSort(merge_sort, master_array, array, n,
+      iteration_tot);
+    if (insertion >= merge)
+      break;
+    profile.presorted_insertion_max = n;
+  }
+  cout << "presorted_insertion_max " << profile.presorted_insertion_max
+       << endl;
+
+  // Displaced arrays at the nearly-sorted limit: the highest sampled
+  // inversion rate at which insertion sort still beats merge sort.
+  size_t n = profile.presorted_insertion_max;
+  if (n > profile.insertion_max && n >= 64) {
+    profile.presorted_inversion_max = 0.0;
+    for (double swap_rate = 1.0 / 4096; swap_rate <= 0.5; swap_rate *= 2.0) {
+      CreateDisplacedDataSet(master_array, n, swap_rate);
+      AutoSortSample sample;
+      AutoSort::Sample(master_array, n, &sample);
+      double insertion = TimeSort(insertion_sort, master_array, array, n,
+        iteration_tot);
+      double merge = TimeSort(merge_sort, master_array, array, n,
+        iteration_tot);
+      if (insertion >= merge)
+        break;
+      profile.presorted_inversion_max = std::max(
+        profile.presorted_inversion_max, sample.inversion_rate);
+    }
+  }
+  cout << "presorted_inversion_max " << profile.presorted_inversion_max
+       << endl;
+
+  // Full-size arrays of widening range: counting sort against the rest.
+  profile.counting_range_factor = 0.0;
+  for (double factor = 0.25; factor * array_size <= kCalibrateRangeMax;
+       factor *= 2.0) {
+    CreateRandomDataSet(master_array, array_size,
+      (size_t) (factor * array_size) + 1);
+    double counting = TimeSort(counting_sort, master_array, array,
+      array_size, iteration_tot);
+    double radix = TimeSort(radix_sort, master_array, array, array_size,
+      iteration_tot);
+    double quick = TimeSort(quick_sort, master_array, array, array_size,
+      iteration_tot);
+    if (counting >= radix || counting >= quick)
+      break;
+    profile.counting_range_factor = factor;
+  }
+  cout << "counting_range_factor " << profile.counting_range_factor << endl;
+
+  // Growing unique arrays: radix and multi-core merge against quick sort.
+  // Each threshold is the smallest size from which the engine keeps
+  // winning.
+  profile.radix_min = 0;
+  profile.multicore_min = 0;
+  for (size_t n = 16; n <= array_size; n <<= 1) {
+    CreateUniqueDataSet(master_array, n);
+    double radix = TimeSort(radix_sort, master_array, array, n,
+      iteration_tot);
+    double quick = TimeSort(quick_sort, master_array, array, n,
+      iteration_tot);
+    double multicore = TimeSort(merge_sort_multicore, master_array, array, n,
+      iteration_tot);
+    if (radix < quick) {
+      if (!profile.radix_min)
+        profile.radix_min = n;
+    } else {
+      profile.radix_min = 0;
+    }
+    if (multicore < quick && multicore < radix) {
+      if (!profile.multicore_min)
+        profile.multicore_min = n;
+    } else {
+      profile.multicore_min = 0;
+    }
+  }
+  if (!profile.radix_min)
+    profile.radix_min = array_size + 1;
+  cout << "radix_min " << profile.radix_min << endl;
+  cout << "multicore_min " << profile.multicore_min << endl;
+
+  // Quick sort against merge sort, between the insertion and radix
+  // crossovers where the choice between them is made.
+  n = std::min(array_size, std::max(std::max((size_t) 64,
+    2 * profile.insertion_max), profile.radix_min / 2));
+
+  // Widening duplicate rates: the last at which quick sort still wins.
+  // A range of (1 - rate) * n keys gives at least that duplicate rate.
+  profile.duplicate_max = 1.0;
+  double duplicate_rate_arr[] = { 0.0625, 0.125, 0.25, 0.5, 0.75, 0.9375 };
+  double prior_rate = 0.0;
+  for (double rate : duplicate_rate_arr) {
+    size_t range = std::max((size_t) 1, (size_t) ((1.0 - rate) * n));
+    CreateRandomDataSet(master_array, n, range);
+    double quick = TimeSort(quick_sort, master_array, array, n,
+      iteration_tot);
+    double merge = TimeSort(merge_sort, master_array, array, n,
+      iteration_tot);
+    if (merge < quick) {
+      profile.duplicate_max = prior_rate;
+      break;
+    }
+    prior_rate = rate;
+  }
+  cout << "duplicate_max " << profile.duplicate_max << endl;
+
+  // Lengthening sorted runs: the shortest from which merge sort wins.
+  profile.run_length_min = 0;
+  for (size_t run_length = 4; run_length <= n; run_length <<= 1) {
+    CreateRunsDataSet(master_array, n, run_length);
+    double quick = TimeSort(quick_sort, master_array, array, n,
+      iteration_tot);
+    double merge = TimeSort(merge_sort, master_array, array, n,
+      iteration_tot);
+    if (merge < quick) {
+      profile.run_length_min = run_length;
+      break;
+    }
+  }
+  cout << "run_length_min " << profile.run_length_min << endl;
+
+  FreeArray(master_array);
+  FreeArray(array);
+
+  if (!profile.Save(path))
+    return -1;
+  cout << "Profile written to " << path << endl;
+  return 0;
+}
@@ -0,0 +1,183 @@
+// sortbench_concurrent.cc
+//
+// Concurrent-instance benchmark mode: N threads share one engine instance,
+// each sorting its own array, to show aggregate throughput and per-sort
+// latency as memory bandwidth saturates.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <memory.h>
+#include <pthread.h>
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+
+typedef std::chrono::high_resolution_clock::time_point ConcurrentTime;
+
+// ConcurrentSorter
+// Body of one concurrent sort thread: repeatedly restore and sort its own
+// array with the shared engine, recording when each sort starts and stops.
+// Every thread refills before any sorts and every sort ends before any
+// refill, so the copies never share the memory bus with a timed sort.
+// Entry: shared engine
+//        master data set
+//        this thread's work array
+//        size in elements
+//        repetitions
+//        barrier of every sorting thread
+//        start time output, one per repetition
+//        stop time output, one per repetition
+static void ConcurrentSorter(
+  hedger::Algo *algorithm,
+  const hedger::S_T *master_array,
+  hedger::S_T *array,
+  size_t array_size,
+  int iteration_tot,
+  pthread_barrier_t *barrier,
+  ConcurrentTime *start_arr,
+  ConcurrentTime *stop_arr)
+{
+  using namespace std;
+  for (int it = 0; it < iteration_tot; ++it) {
+    memcpy(array, master_array, array_size * sizeof(hedger::S_T));
+    pthread_barrier_wait(barrier);
+    start_arr[it] = chrono::high_resolution_clock::now();
+    algorithm->Test(array, array_size, array_size);
+    stop_arr[it] = chrono::high_resolution_clock::now();
+    pthread_barrier_wait(barrier);
+  }
+}
+
+// RunConcurrentBench
+// For each engine, run 1, 2, 4 ... concurrent sorts on separate copies of
+// one data set through the same instance.
+// Entry: engines
+//        size of each array in elements
+//        sorts per thread
+//        largest concurrency to try
+// Exit:  0 == success
+int RunConcurrentBench(
+  std::vector<hedger::Algo *>& algo_arr,
+  size_t array_size,
+  int iteration_tot,
+  int concurrency_max)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpSeconds = chrono::duration<double>;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+
+  S_T *master_array = AllocArray(array_size);
+  S_T *array = AllocArray(array_size * concurrency_max);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+  CreateUniqueDataSet(master_array, array_size);
+
+  cout << COUT_AQUA << "CONCURRENT:" << COUT_NORMAL << endl;
+  cout << array_size << " elements per sort, " << iteration_tot
+       << " sorts per thread" << endl;
+
+  int result = 0;
+  vector<ConcurrentTime> start_arr(iteration_tot * concurrency_max);
+  vector<ConcurrentTime> stop_arr(iteration_tot * concurrency_max);
+  for (auto algorithm : algo_arr) {
+    cout << COUT_WHITE << algorithm->GetName() << COUT_YELLOW << ":"
+         << COUT_NORMAL << endl;
+    cout << "N\tMelem/s\tscaling\tlat " << CHAR_MU << " ms\tlat max ms"
+         << endl;
+    double base_throughput = 0.0;
+    for (int n = 1; n <= concurrency_max; n <<= 1) {
+      pthread_barrier_t barrier;
+      if (pthread_barrier_init(&barrier, NULL, n)) {
+        printf("Failed to create barrier.\n");
+        result = -1;
+        break;
+      }
+      vector<thread> thread_arr;
+      for (int t = 0; t < n; ++t) {
+        thread_arr.push_back(thread(ConcurrentSorter, algorithm,
+          master_array, &array[t * array_size], array_size, iteration_tot,
+          &barrier, &start_arr[t * iteration_tot],
+          &stop_arr[t * iteration_tot]));
+      }
+      for (auto& t : thread_arr)
+        t.join();
+      pthread_barrier_destroy(&barrier);
+
+      // Each thread's array holds its last sort; checked only now, so
+      // the read pass is not timed.
+      bool passed = true;
+      for (int t = 0; t < n; ++t)
+        passed = passed &&
+          VerifyNonDescending(&array[t * array_size], array_size);
+      // Throughput over the sorting phases alone: each repetition runs
+      // from the first sort's start to the last sort's stop.
+      double seconds = 0.0;
+      double latency_tot = 0.0;
+      double latency_max = 0.0;
+      for (int it = 0; it < iteration_tot; ++it) {
+        ConcurrentTime first = start_arr[it];
+        ConcurrentTime last = stop_arr[it];
+        for (int t = 0; t < n; ++t) {
+          int i = t * iteration_tot + it;
+          first = min(first, start_arr[i]);
+          last = max(last, stop_arr[i]);
+          double latency =
+            FpMilliseconds(stop_arr[i] - start_arr[i]).count();
+          latency_tot += latency;
+          latency_max = max(latency_max, latency);
+        }
+        seconds += FpSeconds(last - first).count();
+      }
+      double throughput =
+        (double) array_size * iteration_tot * n / seconds / 1e6;
+      if (1 == n)
+        base_throughput = throughput;
+
+      cout << n << "\t" << throughput << "\t"
+           << throughput / base_throughput << "x\t"
+           << latency_tot / (n * iteration_tot) << "\t" << latency_max;
+      if (!passed) {
+        cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+        result = -1;
+      }
+      cout << endl;
+    }
+    algorithm->ResetStats();
+  }
+
+  FreeArray(master_array);
+  FreeArray(array);
+  return result;
+}
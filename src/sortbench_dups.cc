@@ -0,0 +1,228 @@
+// sortbench_dups.cc
+//
+// Duplicate-heavy benchmark: two- and three-way quick sort over few
+// distinct keys, and fused sort+unique and sort+count against a sort
+// followed by a separate pass.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "quick_sort.h"
+#include "quick_sort_3way.h"
+
+// The two-way quick sort goes quadratic on long runs of equal keys; it is
+// only timed when each key repeats at most this often on average.
+const size_t kTwoWayRepeatMax = 64;
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+// DupResult
+// What one timed operation produced
+struct DupResult {
+  std::vector<hedger::S_T> key_arr;
+  std::vector<size_t> count_arr;
+};
+
+// RunLengths
+// Separate pass: collapse a sorted array to its distinct keys and counts
+// Entry: sorted array
+//        size
+//        result to fill
+static void RunLengths(const hedger::S_T *arr, size_t size, DupResult& result)
+{
+  result.key_arr.clear();
+  result.count_arr.clear();
+  for (size_t i = 0; i < size; ++i) {
+    if (i && arr[i] == arr[i - 1]) {
+      ++result.count_arr.back();
+    } else {
+      result.key_arr.push_back(arr[i]);
+      result.count_arr.push_back(1);
+    }
+  }
+}
+
+// DupOp
+// Operations timed per data set
+enum DupOp {
+  kDupSortStd,              // std::sort
+  kDupSortTwoWay,           // Quick Sort (Lomuto)
+  kDupSortThreeWay,         // Quick Sort 3-Way
+  kDupUniqueStd,            // std::sort, then std::unique
+  kDupUniqueThreeWay,       // Quick Sort 3-Way, then std::unique
+  kDupUniqueFused,          // Quick Sort 3-Way SortUnique
+  kDupCountStd,             // std::sort, then a run-length pass
+  kDupCountFused,           // Quick Sort 3-Way SortCount
+  kDupOpTot
+};
+
+const char *kDupOpName[kDupOpTot] = {
+  "std::sort",
+  "Quick Sort",
+  "Quick Sort 3-Way",
+  "std::sort + std::unique",
+  "Quick Sort 3-Way + std::unique",
+  "Quick Sort 3-Way SortUnique (fused)",
+  "std::sort + run-length pass",
+  "Quick Sort 3-Way SortCount (fused)",
+};
+
+// RunDupOp
+// Entry: operation
+//        working array, holding a copy of the data set
+//        size
+//        count buffer (size long)
+//        result to fill (distinct keys and counts, or the sorted array)
+static void RunDupOp(
+  DupOp op,
+  hedger::S_T *arr,
+  size_t size,
+  size_t *count_buf,
+  DupResult& result)
+{
+  hedger::QuickSort two_way;
+  hedger::QuickSort3Way three_way;
+  size_t distinct_tot = size;
+  switch (op) {
+    case kDupSortStd:
+      std::sort(arr, arr + size);
+      break;
+    case kDupSortTwoWay:
+      two_way.Test(arr, size);
+      break;
+    case kDupSortThreeWay:
+      three_way.Test(arr, size);
+      break;
+    case kDupUniqueStd:
+      std::sort(arr, arr + size);
+      distinct_tot = std::unique(arr, arr + size) - arr;
+      break;
+    case kDupUniqueThreeWay:
+      three_way.Test(arr, size);
+      distinct_tot = std::unique(arr, arr + size) - arr;
+      break;
+    case kDupUniqueFused:
+      distinct_tot = three_way.SortUnique(arr, size);
+      break;
+    case kDupCountStd:
+      std::sort(arr, arr + size);
+      RunLengths(arr, size, result);
+      return;
+    case kDupCountFused:
+      distinct_tot = three_way.SortCount(arr, size, count_buf);
+      result.key_arr.assign(arr, arr + distinct_tot);
+      result.count_arr.assign(count_buf, count_buf + distinct_tot);
+      return;
+    default:
+      break;
+  }
+  result.key_arr.assign(arr, arr + distinct_tot);
+  result.count_arr.clear();
+}
+
+// RunDupBench
+// Time each operation on array_size keys drawn from 2, 16, 256, 4096,
+// array_size / 64, array_size / 2 and array_size distinct values.
+// Entry: array size in elements
+//        repetitions
+// Exit:  0 == success
+int RunDupBench(size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  vector<size_t> distinct_arr = {
+    2, 16, 256, 4096, array_size / 64, array_size / 2, array_size
+  };
+  sort(distinct_arr.begin(), distinct_arr.end());
+  distinct_arr.erase(unique(distinct_arr.begin(), distinct_arr.end()),
+    distinct_arr.end());
+
+  vector<S_T> master(array_size), arr(array_size);
+  vector<size_t> count_buf(array_size);
+  int result = 0;
+  for (auto distinct_tot : distinct_arr) {
+    if (!distinct_tot || distinct_tot > array_size)
+      continue;
+    for (size_t i = 0; i < array_size; ++i)
+      master[i] = (S_T) (RandomBits() % distinct_tot);
+    cout << COUT_AQUA << "DISTINCT " << distinct_tot << ":" << COUT_NORMAL
+         << endl;
+
+    // References: the sorted array, and its distinct keys with counts
+    DupResult sorted, counted, got;
+    sorted.key_arr = master;
+    sort(sorted.key_arr.begin(), sorted.key_arr.end());
+    RunLengths(&sorted.key_arr[0], array_size, counted);
+
+    double baseline_ms = 0.0;
+    for (int op = 0; op < kDupOpTot; ++op) {
+      if (kDupSortTwoWay == op && distinct_tot * kTwoWayRepeatMax <
+          array_size) {
+        cout << COUT_WHITE << kDupOpName[op] << COUT_NORMAL
+             << "\tskipped (quadratic on runs of equal keys)" << endl;
+        continue;
+      }
+      double ms = 0.0;
+      for (int it = 0; it < iteration_tot; ++it) {
+        memcpy(&arr[0], &master[0], array_size * sizeof(S_T));
+        auto start = chrono::high_resolution_clock::now();
+        RunDupOp((DupOp) op, &arr[0], array_size, &count_buf[0], got);
+        auto stop = chrono::high_resolution_clock::now();
+        ms += FpMilliseconds(stop - start).count();
+      }
+      ms /= iteration_tot;
+
+      // Each group is reported against its std:: baseline
+      if (kDupSortStd == op || kDupUniqueStd == op || kDupCountStd == op)
+        baseline_ms = ms;
+      bool passed;
+      if (op <= kDupSortThreeWay)
+        passed = got.key_arr == sorted.key_arr;
+      else if (op <= kDupUniqueFused)
+        passed = got.key_arr == counted.key_arr;
+      else
+        passed = got.key_arr == counted.key_arr &&
+          got.count_arr == counted.count_arr;
+      cout << COUT_WHITE << kDupOpName[op];
+      if (passed) {
+        cout << COUT_GREEN << " (PASS)";
+      } else {
+        cout << COUT_RED << " (FAIL)";
+        result = -1;
+      }
+      cout << COUT_NORMAL << "\t" << CHAR_MU << ":" << ms << " ms\t"
+           << (ms > 0.0 ? baseline_ms / ms : 0.0) << "x" << endl;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,125 @@
+// sortbench_incremental.cc
+//
+// Benchmark mode comparing batch merges into a sorted array against a full
+// re-sort of the combined data.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "incremental_sort.h"
+#include "merge_sort.h"
+
+// RunIncrementalBench
+// Start from a sorted array of array_size keys and feed it iteration_tot
+// batches of each size, timing the merge.  The same batches are also
+// appended and fully re-sorted for reference.  Costs are amortized per
+// inserted key.
+// Entry: size of the initial sorted array in elements
+//        number of batches per batch size
+// Exit:  0 == success
+int RunIncrementalBench(size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpNanoseconds =
+        chrono::duration<double, chrono::nanoseconds::period>;
+
+  size_t batch_max = array_size;
+  size_t capacity = array_size + batch_max * iteration_tot;
+  S_T *base = AllocArray(array_size);
+  S_T *batches = AllocArray(batch_max * iteration_tot);
+  S_T *resort = AllocArray(capacity);
+  if (!base || !batches || !resort) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(base);
+    FreeArray(batches);
+    FreeArray(resort);
+    return -1;
+  }
+
+  CreateUniqueDataSet(base, array_size);
+  MergeSort merge_sort;
+  merge_sort.Test(base, array_size);
+
+  IncrementalSort incremental;
+  cout << COUT_AQUA << "INCREMENTAL:" << COUT_NORMAL << endl;
+  cout << "base: " << array_size << " keys, " << iteration_tot
+       << " batches per size" << endl;
+  cout << "batch\tmerge ns/key\tre-sort ns/key\tspeedup" << endl;
+
+  int result = 0;
+  for (size_t batch_size = 1; batch_size <= batch_max; batch_size <<= 2) {
+    size_t key_tot = batch_size * iteration_tot;
+    CreateRandomDataSet(batches, key_tot, array_size);
+
+    // Incremental: merge each batch into the growing array.
+    incremental.Assign(base, array_size);
+    incremental.Reserve(capacity);
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < iteration_tot; ++i)
+      incremental.Insert(&batches[i * batch_size], batch_size);
+    auto stop = chrono::high_resolution_clock::now();
+    double merge_ns = FpNanoseconds(stop - start).count();
+    bool passed = VerifyNonDescending(
+      (S_T *) incremental.GetData(), incremental.GetSize());
+
+    // Reference: append each batch and re-sort everything.
+    size_t size = array_size;
+    memcpy(resort, base, array_size * sizeof(S_T));
+    double resort_ns = 0.0;
+    for (int i = 0; i < iteration_tot; ++i) {
+      memcpy(&resort[size], &batches[i * batch_size],
+        batch_size * sizeof(S_T));
+      size += batch_size;
+      start = chrono::high_resolution_clock::now();
+      merge_sort.Test(resort, size);
+      stop = chrono::high_resolution_clock::now();
+      resort_ns += FpNanoseconds(stop - start).count();
+    }
+    passed = passed && VerifyNonDescending(resort, size) &&
+      !memcmp(resort, incremental.GetData(), size * sizeof(S_T));
+    merge_sort.ResetStats();
+
+    double merge_per_key = merge_ns / key_tot;
+    double resort_per_key = resort_ns / key_tot;
+    cout << batch_size << "\t" << merge_per_key << "\t"
+         << resort_per_key << "\t" << resort_per_key / merge_per_key << "x";
+    if (!passed) {
+      cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+      result = -1;
+    }
+    cout << endl;
+  }
+
+  FreeArray(base);
+  FreeArray(batches);
+  FreeArray(resort);
+  return result;
+}
@@ -0,0 +1,209 @@
+// sortbench_keys.cc
+//
+// Key-type benchmark: radix and counting sort on 32- and 64-bit signed,
+// unsigned and floating keys through the key transform.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "key_sort.h"
+
+// Count table budget for the counting sort, as in Counting Sort Parallel
+const size_t kKeyCountingBudget = 256 << 20;
+
+// RandomBits
+// Exit: 64 random bits from rand()
+uint64_t RandomBits()
+{
+  return ((uint64_t) rand() << 42) ^ ((uint64_t) rand() << 21) ^
+    (uint64_t) rand();
+}
+
+// RandomKey
+// Full-range random value of T.  Floating values mix signs and spread
+// over 64 binary orders of magnitude (never NaN); records get a random
+// key and payload.
+template <class T> T RandomKey()
+{
+  return (T) RandomBits();
+}
+template <> float RandomKey<float>()
+{
+  uint64_t bits = RandomBits();
+  return (float) ldexp((double) (int32_t) (bits >> 32), (int) (bits & 63) - 32);
+}
+template <> double RandomKey<double>()
+{
+  uint64_t bits = RandomBits();
+  return ldexp((double) (int32_t) (bits >> 32), (int) (bits & 63) - 32);
+}
+template <> hedger::KeyRecord RandomKey<hedger::KeyRecord>()
+{
+  hedger::KeyRecord record;
+  record.key = (int64_t) RandomBits();
+  record.payload = (int64_t) RandomBits();
+  return record;
+}
+template int32_t RandomKey<int32_t>();
+template uint32_t RandomKey<uint32_t>();
+template int64_t RandomKey<int64_t>();
+template uint64_t RandomKey<uint64_t>();
+
+// CreateNarrowKeys
+// Values whose transformed keys span only size consecutive keys around
+// zero, so counting sort applies to every type (floating keys land among
+// the denormals on both sides of zero).
+// Entry: vector to fill
+//        size in elements
+template <class T> static void CreateNarrowKeys(std::vector<T>& arr,
+  size_t size)
+{
+  typedef typename hedger::KeyTraits<T>::Key Key;
+  Key zero = hedger::KeyTraits<T>::ToKey((T) 0);
+  Key low = zero >= size / 2 ? zero - size / 2 : zero;
+  arr.resize(size);
+  for (size_t i = 0; i < size; ++i)
+    arr[i] = hedger::KeyTraits<T>::FromKey((Key) (low + RandomBits() % size));
+}
+
+// VerifyKeys
+// Exit: true == non-descending by T's own operator<
+template <class T> static bool VerifyKeys(const std::vector<T>& arr)
+{
+  for (size_t i = 1; i < arr.size(); ++i)
+    if (arr[i] < arr[i - 1])
+      return false;
+  return true;
+}
+
+// TimeKeys
+// Time one sort over copies of master and print μ ms and Melem/s.
+// Entry: master data
+//        repetitions
+//        arena for scratch
+//        true == counting sort, false == radix sort
+// Exit:  0 == success, -1 == failed or refused
+template <class T> static int TimeKeys(
+  const std::vector<T>& master,
+  int iteration_tot,
+  hedger::Arena *arena,
+  bool counting)
+{
+  using namespace std;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+  vector<T> arr;
+  double ms = 0.0;
+  bool passed = true;
+  for (int it = 0; it < iteration_tot; ++it) {
+    arr = master;
+    auto start = chrono::high_resolution_clock::now();
+    int result = counting ?
+      hedger::KeyCountingSort<T>(&arr[0], arr.size(), arena,
+        kKeyCountingBudget) :
+      hedger::KeyRadixSort<T>(&arr[0], arr.size(), arena);
+    auto stop = chrono::high_resolution_clock::now();
+    if (result) {
+      cout << "refused\t\t";
+      return -1;
+    }
+    ms += FpMilliseconds(stop - start).count();
+    passed = passed && VerifyKeys(arr);
+  }
+  ms /= iteration_tot;
+  cout << ms << "\t" << (ms > 0.0 ? master.size() / ms / 1000.0 : 0.0)
+       << "\t";
+  if (!passed)
+    cout << COUT_RED << "(FAIL) " << COUT_NORMAL;
+  return passed ? 0 : -1;
+}
+
+// BenchKeyType
+// Radix sort on full-range keys and counting sort on narrow keys of T.
+// Exit: 0 == success
+template <class T> static int BenchKeyType(
+  const char *name,
+  size_t array_size,
+  int iteration_tot,
+  hedger::Arena *arena)
+{
+  using namespace std;
+  vector<T> master(array_size);
+  for (size_t i = 0; i < array_size; ++i)
+    master[i] = RandomKey<T>();
+  vector<T> narrow;
+  CreateNarrowKeys(narrow, array_size);
+
+  cout << name << "\t";
+  int result = TimeKeys(master, iteration_tot, arena, false);
+  result |= TimeKeys(narrow, iteration_tot, arena, true);
+  cout << endl;
+  return result;
+}
+
+// RunKeyBench
+// Sort each key type with the transformed-key radix and counting sorts.
+// Entry: array size in elements
+//        repetitions
+// Exit:  0 == success
+int RunKeyBench(size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+  if (array_size < 2)
+    array_size = 2;
+
+  // One arena for the widest key's radix passes or the narrow count table
+  Arena arena;
+  size_t scratch_size = max(KeyRadixScratchSize<uint64_t>(array_size),
+    Arena::Round((array_size + 1) * sizeof(size_t)));
+  Arena *scratch = arena.Reserve(scratch_size) ? &arena : nullptr;
+
+  cout << COUT_AQUA << "Key types:" << COUT_NORMAL << endl;
+  cout << array_size << " elements; radix on full-range keys, counting on "
+       << array_size << " consecutive keys around zero" << endl;
+  cout << "type\tradix " << CHAR_MU << " ms\tMelem/s\tcount " << CHAR_MU
+       << " ms\tMelem/s" << endl;
+  int result = 0;
+  result |= BenchKeyType<int32_t>("int32", array_size, iteration_tot, scratch);
+  result |= BenchKeyType<uint32_t>("uint32", array_size, iteration_tot,
+    scratch);
+  result |= BenchKeyType<int64_t>("int64", array_size, iteration_tot, scratch);
+  result |= BenchKeyType<uint64_t>("uint64", array_size, iteration_tot,
+    scratch);
+  result |= BenchKeyType<float>("float", array_size, iteration_tot, scratch);
+  result |= BenchKeyType<double>("double", array_size, iteration_tot,
+    scratch);
+  return result;
+}
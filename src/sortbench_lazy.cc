@@ -0,0 +1,167 @@
+// sortbench_lazy.cc
+//
+// Lazy sort benchmark: time to read the first k keys in order from the
+// incremental quick sort iterator against sorting everything first.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "quick_sort_incremental.h"
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+// Keys a paging consumer reads at a time
+const size_t kLazyPageSize = 64;
+
+// LazyOp
+// Ways of getting the first k keys in order
+enum LazyOp {
+  kLazySortRead,            // std::sort everything, then read k
+  kLazyPartialSort,         // std::partial_sort of k
+  kLazyIterator,            // Quick Sort Incremental, read a page at a time
+  kLazyOpTot
+};
+
+const char *kLazyOpName[kLazyOpTot] = {
+  "std::sort + read",
+  "std::partial_sort",
+  "Quick Sort Incremental",
+};
+
+// RunLazyOp
+// Entry: operation
+//        working array, holding a copy of the data set
+//        size
+//        keys to read
+//        output, room for k keys
+//        out: ms until the first key was read
+static void RunLazyOp(
+  LazyOp op,
+  hedger::S_T *arr,
+  size_t size,
+  size_t k,
+  hedger::S_T *out,
+  double& first_ms)
+{
+  using namespace std;
+  hedger::QuickSortIncremental engine;
+  auto start = chrono::high_resolution_clock::now();
+  switch (op) {
+    case kLazySortRead:
+      sort(arr, arr + size);
+      first_ms = FpMilliseconds(chrono::high_resolution_clock::now() -
+        start).count();
+      memcpy(out, arr, k * sizeof(hedger::S_T));
+      break;
+    case kLazyPartialSort:
+      partial_sort(arr, arr + k, arr + size);
+      first_ms = FpMilliseconds(chrono::high_resolution_clock::now() -
+        start).count();
+      memcpy(out, arr, k * sizeof(hedger::S_T));
+      break;
+    case kLazyIterator: {
+      hedger::QuickSortIncremental::Iterator it = engine.Begin(arr, size);
+      out[0] = *it.Next();
+      first_ms = FpMilliseconds(chrono::high_resolution_clock::now() -
+        start).count();
+      // The consumer does not know k up front: it pages until it has enough.
+      for (size_t read = 1; read < k; )
+        read += it.Read(&out[read], min(kLazyPageSize, k - read));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// RunLazyBench
+// On array_size random keys, time reading the first 1, 10, 100, 1000,
+// array_size / 100, array_size / 10 and array_size keys in order, as the
+// time to the first key and to the k-th, for each operation.
+// Entry: array size in elements
+//        repetitions
+// Exit:  0 == success
+int RunLazyBench(size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  vector<size_t> k_arr = {
+    1, 10, 100, 1000, array_size / 100, array_size / 10, array_size
+  };
+  sort(k_arr.begin(), k_arr.end());
+  k_arr.erase(unique(k_arr.begin(), k_arr.end()), k_arr.end());
+
+  vector<S_T> master(array_size), sorted, arr(array_size), out(array_size);
+  CreateRandomDataSet(&master[0], array_size);
+  sorted = master;
+  sort(sorted.begin(), sorted.end());
+
+  int result = 0;
+  for (auto k : k_arr) {
+    if (!k || k > array_size)
+      continue;
+    cout << COUT_AQUA << "FIRST " << k << " OF " << array_size << ":"
+         << COUT_NORMAL << endl;
+    double baseline_ms = 0.0;
+    for (int op = 0; op < kLazyOpTot; ++op) {
+      double ms = 0.0, first_ms = 0.0;
+      bool passed = true;
+      for (int it = 0; it < iteration_tot; ++it) {
+        memcpy(&arr[0], &master[0], array_size * sizeof(S_T));
+        double first = 0.0;
+        auto start = chrono::high_resolution_clock::now();
+        RunLazyOp((LazyOp) op, &arr[0], array_size, k, &out[0], first);
+        auto stop = chrono::high_resolution_clock::now();
+        ms += FpMilliseconds(stop - start).count();
+        first_ms += first;
+        passed = passed && equal(out.begin(), out.begin() + k,
+          sorted.begin());
+      }
+      ms /= iteration_tot;
+      first_ms /= iteration_tot;
+      if (kLazySortRead == op)
+        baseline_ms = ms;
+      cout << COUT_WHITE << kLazyOpName[op];
+      if (passed) {
+        cout << COUT_GREEN << " (PASS)";
+      } else {
+        cout << COUT_RED << " (FAIL)";
+        result = -1;
+      }
+      cout << COUT_NORMAL << "\tfirst key: " << first_ms << " ms\t" << k
+           << " keys: " << ms << " ms\t"
+           << (ms > 0.0 ? baseline_ms / ms : 0.0) << "x" << endl;
+    }
+  }
+  return result;
+}
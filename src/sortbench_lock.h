@@ -24,40 +24,186 @@
 #define _SORTBENCH_LOCK_H_
 
 #include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include <atomic>
 
 namespace hedger {
 
+// Spins before a waiter gives up its time slice
+const int kLockSpinMax = 1024;
+// Longest TTAS backoff, in pause instructions
+const int kLockBackoffMax = 1024;
+
+// CpuRelax
+// Tell the core we are spinning (saves power, frees the sibling
+// hyperthread and avoids a memory-order pipeline flush on exit).
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
 // Lock
-// Simple lock class for acquisition and release of lock
+// Simple test-and-set lock for acquisition and release of lock
 class Lock {
  public:
   Lock() { lock_ = 0; }
   ~Lock() {}
   // Acquire
   inline void Acquire() {
-    while (__sync_lock_test_and_set(&lock_, 1));
-#if 0
-    while (lock_) {
-      // Occupado, sister; Force a context switch and wait our turn
-      // (TODO: Is this even necessary?)
-      sched_yield();
-    }
-    // Low-level lock on Intel processors
-    __sync_lock_test_and_set(&lock_, 1);
-#endif
+    while (__sync_lock_test_and_set(&lock_, 1))
+      CpuRelax();
   }
   // Release
+  // __sync_lock_release is a store with release semantics, so writes made
+  // while holding the lock are visible before the lock appears free.
   inline void Release() {
-    // Low-level release on Intel chips
-    #if 1
-    lock_ = 0;
-    #else
     __sync_lock_release(&lock_);
-    #endif
   }
  private:
   volatile int lock_;
 };
-} // namespace anagram
-#endif // #ifndef _SORTBENCH_LOCK_H_
 
+// TtasLock
+// Test-and-test-and-set lock with exponential backoff.  Waiters spin on a
+// plain load, which stays in their own cache, and only try the exchange
+// once the lock looks free; a failed exchange backs off for twice as long.
+class TtasLock {
+ public:
+  TtasLock() : lock_(0) {}
+  inline void Acquire() {
+    int backoff = 1;
+    for (;;) {
+      int spin = 0;
+      while (lock_.load(std::memory_order_relaxed)) {
+        if (++spin < kLockSpinMax) {
+          CpuRelax();
+        } else {
+          sched_yield();
+          spin = 0;
+        }
+      }
+      if (!lock_.exchange(1, std::memory_order_acquire))
+        return;
+      for (int i = 0; i < backoff; ++i)
+        CpuRelax();
+      if (backoff < kLockBackoffMax)
+        backoff <<= 1;
+    }
+  }
+  inline void Release() { lock_.store(0, std::memory_order_release); }
+ private:
+  std::atomic<int> lock_;
+};
+
+// TicketLock
+// FIFO spin lock: each waiter takes a ticket and spins until it is served,
+// so the lock is granted strictly in arrival order.
+class TicketLock {
+ public:
+  TicketLock() : next_(0), serving_(0) {}
+  inline void Acquire() {
+    unsigned int ticket = next_.fetch_add(1, std::memory_order_relaxed);
+    int spin = 0;
+    while (serving_.load(std::memory_order_acquire) != ticket) {
+      if (++spin < kLockSpinMax) {
+        CpuRelax();
+      } else {
+        sched_yield();
+        spin = 0;
+      }
+    }
+  }
+  inline void Release() {
+    // Only the holder writes serving_, so a plain increment is safe
+    serving_.store(serving_.load(std::memory_order_relaxed) + 1,
+      std::memory_order_release);
+  }
+ private:
+  std::atomic<unsigned int> next_;
+  std::atomic<unsigned int> serving_;
+};
+
+// FutexLock
+// Blocking lock.  State 0 is free, 1 is held, 2 is held with sleepers.
+// An uncontended acquire or release is a single atomic; waiters sleep in
+// the kernel instead of spinning, and release only makes a syscall when
+// someone may be asleep.  Without futexes waiters yield instead.
+class FutexLock {
+ public:
+  FutexLock() : state_(0) {}
+  inline void Acquire() {
+    int state = 0;
+    if (state_.compare_exchange_strong(state, 1, std::memory_order_acquire))
+      return;
+    if (2 != state)
+      state = state_.exchange(2, std::memory_order_acquire);
+    while (state) {
+      Wait(2);
+      state = state_.exchange(2, std::memory_order_acquire);
+    }
+  }
+  inline void Release() {
+    if (1 != state_.fetch_sub(1, std::memory_order_release)) {
+      state_.store(0, std::memory_order_release);
+      Wake();
+    }
+  }
+ private:
+  void Wait(int state) {
+#ifdef __linux__
+    syscall(SYS_futex, (int *) &state_, FUTEX_WAIT_PRIVATE, state,
+      nullptr, nullptr, 0);
+#else
+    sched_yield();
+#endif
+  }
+  void Wake() {
+#ifdef __linux__
+    syscall(SYS_futex, (int *) &state_, FUTEX_WAKE_PRIVATE, 1,
+      nullptr, nullptr, 0);
+#endif
+  }
+  std::atomic<int> state_;
+};
+
+// AtomicCounter
+// Shared counter with the memory ordering spelled out per use.  Add() is
+// relaxed, for statistics nobody synchronizes on; TryAdd() and Sub() are
+// acquire/release, for budgets (e.g. threads) whose holders must see each
+// other's work.
+class AtomicCounter {
+ public:
+  AtomicCounter(long value = 0) : value_(value) {}
+  // Returns the previous value
+  inline long Add(long n) {
+    return value_.fetch_add(n, std::memory_order_relaxed);
+  }
+  // Add n only if the total stays at or below max
+  inline bool TryAdd(long n, long max) {
+    long value = value_.load(std::memory_order_relaxed);
+    do {
+      if (value + n > max)
+        return false;
+    } while (!value_.compare_exchange_weak(value, value + n,
+      std::memory_order_acq_rel, std::memory_order_relaxed));
+    return true;
+  }
+  inline void Sub(long n) { value_.fetch_sub(n, std::memory_order_release); }
+  inline long Load() const { return value_.load(std::memory_order_acquire); }
+  inline void Store(long value) {
+    value_.store(value, std::memory_order_release);
+  }
+ private:
+  std::atomic<long> value_;
+};
+} // namespace hedger
+#endif // #ifndef _SORTBENCH_LOCK_H_
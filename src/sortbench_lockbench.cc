@@ -0,0 +1,201 @@
+// sortbench_lockbench.cc
+//
+// Lock contention microbenchmark: acquire/release throughput and fairness
+// of each sortbench_lock.h primitive under 1 to N contending threads.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "sortbench_lock.h"
+
+// Length of one measurement window
+static const int kLockWindowMs = 100;
+// Most keys touched while holding the lock
+static const size_t kLockHoldMax = 1024;
+
+// MutexLock
+// std::mutex under the Acquire/Release names, as a baseline.
+class MutexLock {
+ public:
+  inline void Acquire() { mutex_.lock(); }
+  inline void Release() { mutex_.unlock(); }
+ private:
+  std::mutex mutex_;
+};
+
+// AtomicCounterLock
+// Not a lock: each "hold" is one relaxed fetch-and-add on a shared
+// counter, the floor every lock is paying for.
+class AtomicCounterLock {
+ public:
+  inline void Acquire() { counter_.Add(1); }
+  inline void Release() {}
+ private:
+  hedger::AtomicCounter counter_;
+};
+
+// LockBenchShared
+// State shared by the contending threads of one window
+template <class L> struct LockBenchShared {
+  L lock;
+  std::atomic<bool> go;
+  std::atomic<bool> stop;
+  hedger::S_T *hold_arr;        // keys rotated under the lock
+  size_t hold_size;
+  long guarded_tot;             // incremented only under the lock
+};
+
+// Contender
+// Acquire, touch the shared keys, release, until told to stop.
+// Entry: shared state
+//        acquisitions output
+template <class L> static void Contender(
+  LockBenchShared<L> *shared,
+  long *acquire_tot)
+{
+  long acquired = 0;
+  while (!shared->go.load(std::memory_order_acquire))
+    hedger::CpuRelax();
+  while (!shared->stop.load(std::memory_order_relaxed)) {
+    shared->lock.Acquire();
+    ++shared->guarded_tot;
+    for (size_t i = 0; i < shared->hold_size; ++i)
+      ++shared->hold_arr[i];
+    shared->lock.Release();
+    ++acquired;
+  }
+  *acquire_tot = acquired;
+}
+
+// RunLockWindow
+// Run thread_tot contenders for one window and report throughput and
+// fairness.  Fairness is Jain's index (1.0 == every thread got the same
+// share, 1/N == one thread got everything) and the min/max share ratio.
+// Entry: lock type name
+//        false if L does not exclude (guarded counter is not checked)
+//        contending threads
+//        keys touched per hold
+//        windows to run
+// Exit:  true == guarded counter consistent (the lock excluded)
+template <class L> static bool RunLockWindow(
+  const char *name,
+  bool excludes,
+  int thread_tot,
+  size_t hold_size,
+  int iteration_tot)
+{
+  using namespace std;
+  using FpSeconds = chrono::duration<double>;
+  bool passed = true;
+  double ops = 0.0;
+  double jain = 0.0;
+  double min_max = 0.0;
+  hedger::S_T hold_arr[kLockHoldMax] = { 0 };
+  for (int it = 0; it < iteration_tot; ++it) {
+    LockBenchShared<L> shared;
+    shared.go = false;
+    shared.stop = false;
+    shared.hold_arr = hold_arr;
+    shared.hold_size = hold_size;
+    shared.guarded_tot = 0;
+    vector<long> acquire_arr(thread_tot);
+    vector<thread> thread_arr;
+    for (int t = 0; t < thread_tot; ++t)
+      thread_arr.push_back(thread(Contender<L>, &shared, &acquire_arr[t]));
+    auto start = chrono::high_resolution_clock::now();
+    shared.go.store(true, memory_order_release);
+    this_thread::sleep_for(chrono::milliseconds(kLockWindowMs));
+    shared.stop.store(true, memory_order_relaxed);
+    for (auto& t : thread_arr)
+      t.join();
+    auto stop = chrono::high_resolution_clock::now();
+
+    double sum = 0.0, sum_sq = 0.0;
+    long low = acquire_arr[0], high = acquire_arr[0];
+    for (long n : acquire_arr) {
+      sum += n;
+      sum_sq += (double) n * n;
+      low = min(low, n);
+      high = max(high, n);
+    }
+    ops += sum / FpSeconds(stop - start).count();
+    jain += sum_sq ? sum * sum / (thread_tot * sum_sq) : 0.0;
+    min_max += high ? (double) low / high : 0.0;
+    if (excludes && (long) sum != shared.guarded_tot)
+      passed = false;
+  }
+  cout << name << "\t" << thread_tot << "\t"
+       << ops / iteration_tot / 1e6 << "\t" << jain / iteration_tot << "\t"
+       << min_max / iteration_tot;
+  if (!passed)
+    cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+  cout << endl;
+  return passed;
+}
+
+// RunLockBench
+// Contend each primitive with 1, 2, 4 ... thread_max threads.
+// Entry: keys touched per hold (capped at 1024)
+//        windows per configuration
+//        largest thread count
+// Exit:  0 == success
+int RunLockBench(size_t hold_size, int iteration_tot, int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+  hold_size = min(hold_size, kLockHoldMax);
+
+  cout << COUT_AQUA << "LOCKS:" << COUT_NORMAL << endl;
+  cout << hold_size << " keys touched per hold, " << iteration_tot
+       << " x " << kLockWindowMs << " ms windows" << endl;
+  cout << "lock\tthreads\tMops/s\tJain\tmin/max" << endl;
+
+  bool passed = true;
+  for (int p = 1; ; p = min(p << 1, thread_max)) {
+    passed &= RunLockWindow<Lock>("tas", true, p, hold_size,
+      iteration_tot);
+    passed &= RunLockWindow<TtasLock>("ttas", true, p, hold_size,
+      iteration_tot);
+    passed &= RunLockWindow<TicketLock>("ticket", true, p, hold_size,
+      iteration_tot);
+    passed &= RunLockWindow<FutexLock>("futex", true, p, hold_size,
+      iteration_tot);
+    passed &= RunLockWindow<MutexLock>("mutex", true, p, hold_size,
+      iteration_tot);
+    passed &= RunLockWindow<AtomicCounterLock>("atomic", false, p,
+      hold_size, iteration_tot);
+    if (p == thread_max)
+      break;
+  }
+  return passed ? 0 : -1;
+}
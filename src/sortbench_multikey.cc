@@ -0,0 +1,245 @@
+// sortbench_multikey.cc
+//
+// Multi-column sort benchmark: ORDER BY over generated integer columns,
+// packed radix against a comparator over the tuple.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "multi_key_sort.h"
+
+// Most key columns
+const int kMultiKeyColumnMax = 16;
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+// ColumnSpec
+// Generator settings for one column
+struct ColumnSpec {
+  uint64_t cardinality;         // distinct values (0 == full 64-bit range)
+  double correlation;           // chance a value follows the column before
+};
+
+// ParseColumnSpec
+// Entry: comma-separated cardinality[:correlation] per column, most
+//        significant first, e.g. "16,1000:0.5,0"
+//        spec vector to fill
+// Exit:  true == success
+static bool ParseColumnSpec(const char *text, std::vector<ColumnSpec>& spec)
+{
+  const char *p = text;
+  while (*p) {
+    char *end;
+    ColumnSpec column = { strtoull(p, &end, 10), 0.0 };
+    if (end == p)
+      return false;
+    p = end;
+    if (':' == *p) {
+      column.correlation = strtod(p + 1, &end);
+      if (end == p + 1 || column.correlation < 0.0 ||
+          column.correlation > 1.0)
+        return false;
+      p = end;
+    }
+    spec.push_back(column);
+    if (',' == *p)
+      ++p;
+    else if (*p)
+      return false;
+  }
+  return !spec.empty() && (int) spec.size() <= kMultiKeyColumnMax;
+}
+
+// CreateColumns
+// Column c draws uniformly from cardinality values centred on zero, except
+// that with probability correlation a row's value is derived from its
+// value in column c - 1 (so equal earlier keys tend to repeat later ones).
+// Entry: spec
+//        rows
+//        columns to fill
+static void CreateColumns(
+  const std::vector<ColumnSpec>& spec,
+  size_t size,
+  std::vector<std::vector<int64_t> >& col_arr)
+{
+  col_arr.assign(spec.size(), std::vector<int64_t>(size));
+  for (size_t c = 0; c < spec.size(); ++c) {
+    uint64_t cardinality = spec[c].cardinality;
+    int64_t centre = (int64_t) (cardinality / 2);
+    for (size_t r = 0; r < size; ++r) {
+      uint64_t bits = RandomBits();
+      if (c && (double) rand() / RAND_MAX < spec[c].correlation)
+        bits = (uint64_t) col_arr[c - 1][r] * 0x9e3779b97f4a7c15ull;
+      if (cardinality)
+        col_arr[c][r] = (int64_t) (bits % cardinality) - centre;
+      else
+        col_arr[c][r] = (int64_t) bits;
+    }
+  }
+}
+
+// TupleLess
+// Lexicographic order of two rows over every column
+struct TupleLess {
+  const std::vector<std::vector<int64_t> > *col_arr;
+  bool operator()(uint32_t a, uint32_t b) const {
+    for (auto& col : *col_arr) {
+      if (col[a] != col[b])
+        return col[a] < col[b];
+    }
+    return false;
+  }
+};
+
+// VerifyOrder
+// Exit: true == rows in lexicographic order (and, if stable, equal rows in
+//       row order)
+static bool VerifyOrder(
+  const std::vector<uint32_t>& perm,
+  const TupleLess& less,
+  bool stable)
+{
+  for (size_t i = 1; i < perm.size(); ++i) {
+    if (less(perm[i], perm[i - 1]))
+      return false;
+    if (stable && !less(perm[i - 1], perm[i]) && perm[i] < perm[i - 1])
+      return false;
+  }
+  return true;
+}
+
+// ReportMultiKeyRow
+static void ReportMultiKeyRow(
+  const char *name,
+  bool passed,
+  double ms,
+  size_t size,
+  double baseline_ms)
+{
+  using namespace std;
+  cout << COUT_WHITE << name
+       << (passed ? COUT_GREEN " (PASS)" : COUT_RED " (FAIL)")
+       << COUT_NORMAL << "\t" << ms << "\t"
+       << (ms > 0.0 ? size / ms / 1000.0 : 0.0) << "\t"
+       << (ms > 0.0 ? baseline_ms / ms : 0.0) << "x" << endl;
+}
+
+// RunMultiKeyBench
+// Entry: column spec (see ParseColumnSpec)
+//        rows
+//        repetitions
+// Exit:  0 == success
+int RunMultiKeyBench(const char *spec_text, size_t array_size,
+  int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  vector<ColumnSpec> spec;
+  if (!ParseColumnSpec(spec_text, spec)) {
+    printf("Bad column spec %s: up to %d comma-separated "
+      "cardinality[:correlation] (0 == 64-bit)\n", spec_text,
+      kMultiKeyColumnMax);
+    return -1;
+  }
+  if (array_size > UINT32_MAX) {
+    printf("At most %u rows\n", UINT32_MAX);
+    return -1;
+  }
+  vector<vector<int64_t> > col_arr;
+  CreateColumns(spec, array_size, col_arr);
+  vector<const int64_t *> col_ptr_arr;
+  for (auto& col : col_arr)
+    col_ptr_arr.push_back(&col[0]);
+
+  cout << COUT_AQUA << "ORDER BY " << spec.size() << " columns: "
+       << COUT_NORMAL << array_size << " rows";
+  for (size_t c = 0; c < spec.size(); ++c)
+    cout << (c ? ", " : " (") << "card " << spec[c].cardinality
+         << " corr " << spec[c].correlation;
+  cout << ")" << endl;
+
+  TupleLess less = { &col_arr };
+  vector<uint32_t> identity(array_size), perm;
+  for (size_t i = 0; i < array_size; ++i)
+    identity[i] = (uint32_t) i;
+
+  cout << "path\t" << CHAR_MU << " ms\tMrow/s\tvs std::sort" << endl;
+  int result = 0;
+  double baseline_ms = 0.0;
+  for (int stable = 0; stable < 2; ++stable) {
+    double ms = 0.0;
+    for (int it = 0; it < iteration_tot; ++it) {
+      perm = identity;
+      auto start = chrono::high_resolution_clock::now();
+      if (stable)
+        stable_sort(perm.begin(), perm.end(), less);
+      else
+        sort(perm.begin(), perm.end(), less);
+      auto stop = chrono::high_resolution_clock::now();
+      ms += FpMilliseconds(stop - start).count();
+    }
+    ms /= iteration_tot;
+    if (!stable)
+      baseline_ms = ms;
+    bool passed = VerifyOrder(perm, less, stable);
+    ReportMultiKeyRow(stable ? "std::stable_sort (tuple)" :
+      "std::sort (tuple)", passed, ms, array_size, baseline_ms);
+    result |= passed ? 0 : -1;
+  }
+
+  Arena arena;
+  if (!arena.Reserve(MultiKeyScratchSize<uint32_t>(array_size)))
+    printf("Failed to reserve multi-key scratch; using the heap.\n");
+  MultiKeyPlan plan;
+  double ms = 0.0;
+  bool passed = true;
+  perm.resize(array_size);
+  for (int it = 0; it < iteration_tot; ++it) {
+    auto start = chrono::high_resolution_clock::now();
+    if (MultiKeySort(&col_ptr_arr[0], (int) col_ptr_arr.size(), array_size,
+        &perm[0], &arena, &plan))
+      passed = false;
+    auto stop = chrono::high_resolution_clock::now();
+    ms += FpMilliseconds(stop - start).count();
+  }
+  ms /= iteration_tot;
+  passed = passed && VerifyOrder(perm, less, true);
+  ReportMultiKeyRow("Multi-Key Radix (stable)", passed, ms, array_size,
+    baseline_ms);
+  result |= passed ? 0 : -1;
+  cout << "Packed key: " << plan.bit_tot << " bits in " << plan.word_tot
+       << " word(s), " << plan.pass_tot << " byte passes" << endl;
+  return result;
+}
@@ -0,0 +1,185 @@
+// sortbench_numa.cc
+//
+// NUMA benchmark mode: report the topology, then time the multi-core
+// merge sort on arrays placed naively, by per-node first touch and
+// interleaved, with and without NUMA-aware threads.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "merge_sort_multicore.h"
+#include "numa_util.h"
+
+// How the work array's pages are placed
+enum NumaPlacement {
+  kPlacementNaive,          // touched by the main thread (one node)
+  kPlacementFirstTouch,     // chunk k touched by a thread on node k
+  kPlacementInterleave,     // pages round-robin over the nodes
+  kPlacementTot
+};
+
+static const char *kPlacementNameArr[kPlacementTot] = {
+  "naive", "first-touch", "interleave"
+};
+
+// PrintTopology
+// List each node's CPUs and memory.
+static void PrintTopology()
+{
+  using namespace std;
+  hedger::NumaTopology& topology = hedger::NumaTopology::Get();
+  cout << topology.GetNodeTot() << " node(s)" << endl;
+  for (int node = 0; node < topology.GetNodeTot(); ++node) {
+    const vector<int>& cpu_arr = topology.GetCpuArr(node);
+    cout << "node " << topology.GetNodeId(node) << ": "
+         << cpu_arr.size() << " cpus";
+    if (!cpu_arr.empty())
+      cout << " (" << cpu_arr.front() << ".." << cpu_arr.back() << ")";
+    if (topology.GetMemTotal(node))
+      cout << ", " << topology.GetMemTotal(node) / 1024 << " MB";
+    cout << endl;
+  }
+  if (topology.GetNodeTot() < 2)
+    cout << "(single node: placement and pinning have no effect)" << endl;
+}
+
+// PrintPlacement
+// Sampled pages per node and the share placed on the node a NUMA-aware
+// thread would process them from.
+// Entry: array
+//        size in elements
+static void PrintPlacement(const hedger::S_T *array, size_t size)
+{
+  using namespace std;
+  vector<size_t> count_arr;
+  size_t local_tot, sample_tot;
+  hedger::NumaCountPages(array, size * sizeof(hedger::S_T), count_arr,
+    &local_tot, &sample_tot);
+  for (size_t node = 0; node < count_arr.size(); ++node) {
+    cout << (node ? "/" : "")
+         << (sample_tot ? 100.0 * count_arr[node] / sample_tot : 0.0);
+  }
+  cout << "\t" << (sample_tot ? 100.0 * local_tot / sample_tot : 0.0);
+}
+
+// RunNumaBench
+// For each placement of the work array, time MergeSortMultiCore with
+// unpinned threads (NUMA-naive) and with threads pinned to the node of
+// their chunk and matching scratch placement (NUMA-aware).
+// Entry: array size in elements
+//        repetitions
+//        threads (0 == all cores)
+// Exit:  0 == success
+int RunNumaBench(size_t array_size, int iteration_tot, int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+
+  cout << COUT_AQUA << "NUMA:" << COUT_NORMAL << endl;
+  PrintTopology();
+
+  S_T *master_array = AllocArray(array_size);
+  if (!master_array) {
+    printf("Failed to allocate data set array.\n");
+    return -1;
+  }
+  CreateRandomDataSet(master_array, array_size, array_size);
+
+  // One engine per mode, each with its own arena: the aware engine's
+  // scratch is bound to the nodes once, here, and stays bound, so the
+  // naive engine must not share it.
+  MergeSortMultiCore merge_sort_arr[2];
+  Arena arena_arr[2];
+  for (int aware = 0; aware < 2; ++aware) {
+    MergeSortMultiCore& merge_sort = merge_sort_arr[aware];
+    if (thread_max)
+      merge_sort.SetThreadMax(thread_max);
+    merge_sort.SetNumaAware(aware);
+    if (arena_arr[aware].Reserve(merge_sort.GetScratchSize(array_size)))
+      merge_sort.SetArena(&arena_arr[aware]);
+  }
+  cout << array_size << " elements, " << merge_sort_arr[0].GetThreadMax()
+       << " threads" << endl;
+  cout << "array\tthreads\t" << CHAR_MU << " ms\t% per node\t% local"
+       << endl;
+
+  int result = 0;
+  size_t bytes = array_size * sizeof(S_T);
+  for (int placement = 0; placement < kPlacementTot; ++placement) {
+    S_T *array;
+    if (kPlacementNaive == placement) {
+      array = AllocArray(array_size);
+    } else {
+      array = (S_T *) NumaAllocPages(bytes);
+      if (array && kPlacementFirstTouch == placement)
+        NumaFirstTouch(array, bytes);
+      else if (array)
+        NumaInterleave(array, bytes);
+    }
+    if (!array) {
+      printf("Failed to allocate data set array.\n");
+      result = -1;
+      break;
+    }
+
+    for (int aware = 0; aware < 2; ++aware) {
+      MergeSortMultiCore& merge_sort = merge_sort_arr[aware];
+      double ms = 0.0;
+      bool passed = true;
+      for (int it = 0; it < iteration_tot; ++it) {
+        memcpy(array, master_array, bytes);
+        auto start = chrono::high_resolution_clock::now();
+        merge_sort.Test(array, array_size);
+        auto stop = chrono::high_resolution_clock::now();
+        ms += FpMilliseconds(stop - start).count();
+        passed = passed && VerifyNonDescending(array, array_size);
+      }
+      cout << kPlacementNameArr[placement] << "\t"
+           << (aware ? "aware" : "naive") << "\t" << ms / iteration_tot
+           << "\t";
+      PrintPlacement(array, array_size);
+      if (!passed) {
+        cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+        result = -1;
+      }
+      cout << endl;
+    }
+
+    if (kPlacementNaive == placement)
+      FreeArray(array);
+    else
+      NumaFreePages(array, bytes);
+  }
+
+  FreeArray(master_array);
+  return result;
+}
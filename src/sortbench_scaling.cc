@@ -0,0 +1,207 @@
+// sortbench_scaling.cc
+//
+// Thread-scaling sweep: run each parallel engine at 1, 2, 4 ... N threads
+// and report speedup, parallel efficiency and the Karp-Flatt serial
+// fraction.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "merge_sort_multicore.h"
+#include "counting_sort_parallel.h"
+#include "segmented_sort.h"
+
+// Segment sizes for the SegmentedSort run, as in the -g mode.
+static const size_t kSegmentSizeMin = 10;
+static const size_t kSegmentSizeMax = 1000;
+
+// ScalingEngine
+// One parallel engine under test, behind a common timing interface.
+class ScalingEngine
+{
+ public:
+  virtual ~ScalingEngine() {}
+  virtual const char *GetName() = 0;
+  virtual void SetThreadMax(int thread_max) = 0;
+  virtual void Sort(hedger::S_T *array, size_t size) = 0;
+  virtual bool Verify(hedger::S_T *array, size_t size) {
+    return VerifyNonDescending(array, size);
+  }
+};
+
+// ScalingAlgo
+// Adapts a parallel Algo.
+class ScalingAlgo : public ScalingEngine
+{
+ public:
+  ScalingAlgo(hedger::Algo *algo) { algo_ = algo; }
+  ~ScalingAlgo() { delete algo_; }
+  const char *GetName() { return algo_->GetName(); }
+  void SetThreadMax(int thread_max) { algo_->SetThreadMax(thread_max); }
+  void Sort(hedger::S_T *array, size_t size) {
+    algo_->Test(array, size, size);
+  }
+ private:
+  hedger::Algo *algo_;
+};
+
+// ScalingSegmented
+// Adapts SegmentedSort over random 10..1000 element segments.
+class ScalingSegmented : public ScalingEngine
+{
+ public:
+  ScalingSegmented(size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+      offsets_.push_back(offset);
+      offset += kSegmentSizeMin +
+        rand() % (kSegmentSizeMax - kSegmentSizeMin + 1);
+    }
+    offsets_.push_back(size);
+  }
+  const char *GetName() { return "Segmented Sort"; }
+  void SetThreadMax(int thread_max) {
+    segmented_sort_.SetThreadMax(thread_max);
+  }
+  void Sort(hedger::S_T *array, size_t size) {
+    segmented_sort_.Sort(array, &offsets_[0], offsets_.size() - 1);
+  }
+  bool Verify(hedger::S_T *array, size_t size) {
+    for (size_t i = 0; i + 1 < offsets_.size(); ++i) {
+      if (!VerifyNonDescending(&array[offsets_[i]],
+        offsets_[i + 1] - offsets_[i]))
+        return false;
+    }
+    return true;
+  }
+ private:
+  hedger::SegmentedSort segmented_sort_;
+  std::vector<size_t> offsets_;
+};
+
+// RunScalingBench
+// Time each parallel engine at 1, 2, 4 ... thread_max threads (and at
+// thread_max itself).  With T(p) the mean time on p threads:
+//   speedup     S = T(1) / T(p)
+//   efficiency  E = S / p
+//   Karp-Flatt  e = (1/S - 1/p) / (1 - 1/p)
+// e is the serial fraction Amdahl's law would need to explain S.  A flat
+// e means a true serial fraction; an e that grows with p means overhead
+// (thread creation, contention, bandwidth) that grows with p.
+// Entry: array size in elements
+//        repetitions per thread count
+//        largest thread count
+// Exit:  0 == success
+int RunScalingBench(size_t array_size, int iteration_tot, int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+
+  S_T *master_array = AllocArray(array_size);
+  S_T *array = AllocArray(array_size);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+  CreateRandomDataSet(master_array, array_size, array_size);
+
+  vector<int> thread_arr;
+  for (int p = 1; p < thread_max; p <<= 1)
+    thread_arr.push_back(p);
+  thread_arr.push_back(thread_max);
+
+  vector<ScalingEngine *> engine_arr;
+  engine_arr.push_back(new ScalingAlgo(new MergeSortMultiCore()));
+  engine_arr.push_back(new ScalingAlgo(new CountingSortParallel()));
+  engine_arr.push_back(new ScalingSegmented(array_size));
+
+  cout << COUT_AQUA << "SCALING:" << COUT_NORMAL << endl;
+  cout << array_size << " elements, " << iteration_tot
+       << " iterations, 1.." << thread_max << " threads" << endl;
+
+  int result = 0;
+  for (auto engine : engine_arr) {
+    cout << COUT_WHITE << engine->GetName() << COUT_YELLOW << ":"
+         << COUT_NORMAL << endl;
+    cout << "P\t" << CHAR_MU << " ms\tspeedup\teffic.\tserial" << endl;
+    double base_ms = 0.0;
+    double serial_tot = 0.0;
+    int serial_n = 0;
+    for (int p : thread_arr) {
+      engine->SetThreadMax(p);
+      double ms = 0.0;
+      bool passed = true;
+      for (int it = 0; it < iteration_tot; ++it) {
+        memcpy(array, master_array, array_size * sizeof(S_T));
+        auto start = chrono::high_resolution_clock::now();
+        engine->Sort(array, array_size);
+        auto stop = chrono::high_resolution_clock::now();
+        ms += FpMilliseconds(stop - start).count();
+        passed = passed && engine->Verify(array, array_size);
+      }
+      ms /= iteration_tot;
+      if (1 == p)
+        base_ms = ms;
+      double speedup = base_ms / ms;
+      cout << p << "\t" << ms << "\t" << speedup << "x\t"
+           << speedup / p << "\t";
+      if (p > 1) {
+        double serial = (1.0 / speedup - 1.0 / p) / (1.0 - 1.0 / p);
+        serial_tot += serial;
+        ++serial_n;
+        cout << serial;
+      } else {
+        cout << "-";
+      }
+      if (!passed) {
+        cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+        result = -1;
+      }
+      cout << endl;
+    }
+    if (serial_n) {
+      double serial = serial_tot / serial_n;
+      cout << "Karp-Flatt serial fraction " << CHAR_MU << ": " << serial;
+      if (serial > 0.0)
+        cout << "\tAmdahl limit: " << 1.0 / serial << "x";
+      cout << endl;
+    }
+    delete engine;
+  }
+
+  FreeArray(master_array);
+  FreeArray(array);
+  return result;
+}
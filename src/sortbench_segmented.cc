@@ -0,0 +1,135 @@
+// sortbench_segmented.cc
+//
+// Segmented sort benchmark mode: throughput on millions of small
+// independent arrays.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "segmented_sort.h"
+#include "heap_sort_variants.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "quick_sort.h"
+#include "radix_sort.h"
+
+// Segment sizes are drawn uniformly from this range.
+static const size_t kSegmentSizeMin = 10;
+static const size_t kSegmentSizeMax = 1000;
+
+// Fixed engines to compare against the size-adaptive choice (nullptr).
+static hedger::AlgoCreate kSegmentEngineArr[] = {
+  nullptr,
+  []() -> hedger::Algo * { return new hedger::InsertionSort(); },
+  []() -> hedger::Algo * { return new hedger::QuickSort(); },
+  []() -> hedger::Algo * { return new hedger::MergeSort(); },
+  []() -> hedger::Algo * { return new hedger::HeapSortIterative(); },
+  []() -> hedger::Algo * { return new hedger::RadixSort(); },
+};
+
+// RunSegmentedBench
+// Split array_size elements into random segments of 10 to 1000 and sort
+// them all with each engine, reporting segments and elements per second.
+// Entry: total elements
+//        repetitions
+//        worker threads (0 == all cores)
+// Exit:  0 == success
+int RunSegmentedBench(size_t array_size, int iteration_tot, int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpSeconds = chrono::duration<double>;
+
+  S_T *master_array = AllocArray(array_size);
+  S_T *array = AllocArray(array_size);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+  CreateRandomDataSet(master_array, array_size, array_size);
+
+  vector<size_t> offsets;
+  size_t offset = 0;
+  while (offset < array_size) {
+    offsets.push_back(offset);
+    offset += kSegmentSizeMin +
+      rand() % (kSegmentSizeMax - kSegmentSizeMin + 1);
+  }
+  offsets.push_back(array_size);
+  size_t segment_tot = offsets.size() - 1;
+
+  SegmentedSort segmented_sort;
+  if (thread_max)
+    segmented_sort.SetThreadMax(thread_max);
+  cout << COUT_AQUA << "SEGMENTED:" << COUT_NORMAL << endl;
+  cout << segment_tot << " segments of " << kSegmentSizeMin << ".."
+       << kSegmentSizeMax << ", " << array_size << " elements, "
+       << segmented_sort.GetThreadMax() << " threads" << endl;
+
+  int result = 0;
+  Arena arena;
+  for (auto create : kSegmentEngineArr) {
+    segmented_sort.SetEngine(create);
+    segmented_sort.SetArena(
+      arena.Reserve(segmented_sort.GetScratchSize(kSegmentSizeMax)) ?
+        &arena : nullptr);
+    double seconds = 0.0;
+    for (int it = 0; it < iteration_tot; ++it) {
+      memcpy(array, master_array, array_size * sizeof(S_T));
+      auto start = chrono::high_resolution_clock::now();
+      segmented_sort.Sort(array, &offsets[0], segment_tot);
+      auto stop = chrono::high_resolution_clock::now();
+      seconds += FpSeconds(stop - start).count();
+    }
+    bool passed = true;
+    for (size_t i = 0; i < segment_tot && passed; ++i)
+      passed = VerifyNonDescending(&array[offsets[i]],
+        offsets[i + 1] - offsets[i]);
+    if (!passed)
+      result = -1;
+
+    cout << COUT_WHITE << segmented_sort.GetName();
+    if (passed)
+      cout << COUT_GREEN << " (PASS)" << COUT_YELLOW << ":" << endl;
+    else
+      cout << COUT_RED << " (FAIL)" << COUT_YELLOW << ":" << endl;
+    cout << "IT: " << iteration_tot << "\t";
+    cout << CHAR_MU << ":" << seconds * 1000.0 / iteration_tot << " ms\t";
+    cout << "seg/s: " << segment_tot * iteration_tot / seconds << "\t";
+    cout << "elem/s: " << array_size * iteration_tot / seconds << endl;
+  }
+
+  FreeArray(master_array);
+  FreeArray(array);
+  return result;
+}
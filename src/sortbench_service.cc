@@ -0,0 +1,518 @@
+// sortbench_service.cc
+//
+// Sort service modes: the daemon, and a load generator that reports
+// latency percentiles and throughput against offered load.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+// C++ headers
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "sort_service.h"
+
+// Connections the load generator opens
+const int kClientConnectionTot = 4;
+// Requests each connection may have in flight under offered load
+const int kClientSlotTot = 64;
+// ... and when probing capacity (closed loop)
+const int kClientProbeSlotTot = 4;
+// Offered load steps, as fractions of the probed capacity
+const double kClientLoadArr[] = { 0.25, 0.5, 0.75, 0.9, 1.0, 1.25 };
+// Ping ids are outside the slot range
+const uint64_t kClientPingId = ~(uint64_t) 0;
+
+typedef std::chrono::steady_clock ServiceClock;
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+static volatile sig_atomic_t service_stop = 0;
+
+// ServiceSignal
+// SIGINT/SIGTERM: stop the daemon
+static void ServiceSignal(int signal_number)
+{
+  service_stop = 1;
+}
+
+// RunServiceDaemon
+// Serve sorts on a Unix socket with every registered engine until
+// interrupted.
+// Entry: socket path
+//        engines
+//        worker threads
+// Exit:  0 == success
+int RunServiceDaemon(
+  const char *path,
+  std::vector<hedger::Algo *>& algo_arr,
+  int worker_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = ServiceSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  SortServer server(algo_arr, worker_tot);
+  if (!server.Listen(path))
+    return -1;
+  cout << COUT_AQUA << "SORT SERVICE:" << COUT_NORMAL << " listening on "
+       << path << " with " << worker_tot << " workers" << endl;
+  for (size_t i = 0; i < algo_arr.size(); ++i)
+    cout << i << "\t" << algo_arr[i]->GetName() << endl;
+  cout << "(interrupt to stop)" << endl;
+  server.Run(&service_stop);
+
+  uint64_t request_tot = server.GetRequestTot();
+  uint64_t batch_tot = server.GetBatchTot();
+  cout << request_tot << " sorts in " << batch_tot << " batches ("
+       << (batch_tot ? (double) request_tot / batch_tot : 0.0)
+       << " per batch)" << endl;
+  return 0;
+}
+
+// ClientConnection
+// One load generator connection: a sender paces requests and a receiver
+// matches responses to their slots.
+struct ClientConnection {
+  int fd;
+  std::mutex lock;
+  std::condition_variable slot_free;
+  std::vector<int> free_arr;
+  std::vector<ServiceClock::time_point> sched_arr;  // per slot
+  std::vector<hedger::S_T *> shm_arr;               // per slot
+  std::vector<std::string> shm_name_arr;
+  size_t shm_size;
+  std::vector<double> latency_arr;                  // ms
+  double server_ms;
+  std::atomic<uint64_t> sent_tot;
+  uint64_t received_tot;
+  std::atomic<bool> failed;
+};
+
+// ConnectService
+// Exit: connected socket (-1 == failure)
+static int ConnectService(const char *path)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path))
+    return -1;
+  strcpy(addr.sun_path, path);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && connect(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+// FindEngine
+// Ask the server for its engines and pick one by name prefix.
+// Entry: socket
+//        name prefix (nullptr == the first engine)
+//        name of the match out
+// Exit:  engine index (-1 == none)
+static int FindEngine(int fd, const char *prefix, std::string& name)
+{
+  hedger::ServiceRequest request;
+  memset(&request, 0, sizeof(request));
+  request.magic = hedger::kServiceMagic;
+  request.op = hedger::kServiceList;
+  hedger::ServiceResponse response;
+  if (!hedger::ServiceWriteFull(fd, &request, sizeof(request)) ||
+      !hedger::ServiceReadFull(fd, &response, sizeof(response)))
+    return -1;
+  std::string names(response.count, '\0');
+  if (response.count &&
+      !hedger::ServiceReadFull(fd, &names[0], response.count))
+    return -1;
+  int index = 0;
+  size_t start = 0, end;
+  while (std::string::npos != (end = names.find('\n', start))) {
+    name = names.substr(start, end - start);
+    if (!prefix || !name.compare(0, strlen(prefix), prefix))
+      return index;
+    ++index;
+    start = end + 1;
+  }
+  return -1;
+}
+
+// ClientFail
+// Mark a connection failed and unblock both of its threads
+static void ClientFail(ClientConnection *connection)
+{
+  connection->failed = true;
+  shutdown(connection->fd, SHUT_RDWR);
+  std::lock_guard<std::mutex> guard(connection->lock);
+  connection->slot_free.notify_all();
+}
+
+// ClientSender
+// Send requests for duration, paced as a Poisson process of rate requests
+// per second (rate 0 == closed loop: send whenever a slot is free), then
+// a ping to mark the end.  Latency runs from the scheduled send time, so a
+// backed-up sender still charges the queueing to the service.
+// Entry: connection
+//        master data set
+//        keys per request
+//        engine index
+//        rate (requests/s, 0 == closed loop)
+//        end of the step
+//        random seed
+static void ClientSender(
+  ClientConnection *connection,
+  const hedger::S_T *master_array,
+  size_t array_size,
+  int engine,
+  double rate,
+  ServiceClock::time_point end,
+  unsigned int seed)
+{
+  using namespace hedger;
+  std::mt19937_64 rng(seed);
+  std::exponential_distribution<double> gap(rate > 0.0 ? rate : 1.0);
+  ServiceRequest request;
+  memset(&request, 0, sizeof(request));
+  request.magic = kServiceMagic;
+  request.count = array_size;
+  request.engine = engine;
+  bool use_shm = !connection->shm_arr.empty();
+  request.op = use_shm ? kServiceSortShm : kServiceSort;
+
+  ServiceClock::time_point next = ServiceClock::now();
+  for (;;) {
+    if (rate > 0.0) {
+      next += std::chrono::duration_cast<ServiceClock::duration>(
+        std::chrono::duration<double>(gap(rng)));
+      if (next >= end)
+        break;
+      std::this_thread::sleep_until(next);
+    } else if (ServiceClock::now() >= end) {
+      break;
+    }
+    int slot;
+    {
+      std::unique_lock<std::mutex> guard(connection->lock);
+      connection->slot_free.wait(guard, [connection] {
+        return !connection->free_arr.empty() || connection->failed;
+      });
+      if (connection->failed)
+        break;
+      slot = connection->free_arr.back();
+      connection->free_arr.pop_back();
+      connection->sched_arr[slot] = rate > 0.0 ? next : ServiceClock::now();
+    }
+    request.id = slot;
+    bool sent;
+    if (use_shm) {
+      memcpy(connection->shm_arr[slot], master_array,
+        array_size * sizeof(S_T));
+      strncpy(request.shm_name, connection->shm_name_arr[slot].c_str(),
+        kServiceShmNameMax - 1);
+      sent = ServiceWriteFull(connection->fd, &request, sizeof(request));
+    } else {
+      struct iovec iov[2] = {
+        { &request, sizeof(request) },
+        { (void *) master_array, array_size * sizeof(S_T) }
+      };
+      sent = ServiceWritevFull(connection->fd, iov, 2);
+    }
+    if (!sent) {
+      ClientFail(connection);
+      break;
+    }
+    ++connection->sent_tot;
+  }
+
+  memset(&request, 0, sizeof(request));
+  request.magic = kServiceMagic;
+  request.op = kServicePing;
+  request.id = kClientPingId;
+  if (!ServiceWriteFull(connection->fd, &request, sizeof(request)))
+    ClientFail(connection);
+}
+
+// ClientReceiver
+// Read responses until the ping is back and every request is answered.
+// Entry: connection
+//        keys per request
+static void ClientReceiver(ClientConnection *connection, size_t array_size)
+{
+  using namespace hedger;
+  std::vector<S_T> buffer(array_size);
+  bool ping_seen = false;
+  while (!(ping_seen && connection->received_tot == connection->sent_tot)) {
+    ServiceResponse response;
+    if (!ServiceReadFull(connection->fd, &response, sizeof(response)) ||
+        kServiceMagic != response.magic) {
+      ClientFail(connection);
+      return;
+    }
+    if (kClientPingId == response.id) {
+      ping_seen = true;
+      continue;
+    }
+    if (response.id >= connection->sched_arr.size() ||
+        response.count > array_size) {
+      ClientFail(connection);
+      return;
+    }
+    int slot = (int) response.id;
+    S_T *keys = connection->shm_arr.empty() ?
+      &buffer[0] : connection->shm_arr[slot];
+    if (response.count &&
+        !ServiceReadFull(connection->fd, keys, response.count * sizeof(S_T))) {
+      ClientFail(connection);
+      return;
+    }
+    auto now = ServiceClock::now();
+    if (response.status || !VerifyNonDescending(keys, array_size)) {
+      ClientFail(connection);
+      return;
+    }
+    std::lock_guard<std::mutex> guard(connection->lock);
+    connection->latency_arr.push_back(
+      FpMilliseconds(now - connection->sched_arr[slot]).count());
+    connection->server_ms += response.server_ns / 1e6;
+    connection->free_arr.push_back(slot);
+    ++connection->received_tot;
+    connection->slot_free.notify_one();
+  }
+}
+
+// Percentile
+// Exit: the p quantile (0..1) of sorted values
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.empty())
+    return 0.0;
+  size_t rank = (size_t) (p * sorted.size());
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// RunLoadStep
+// Drive every connection for one step and report it.
+// Entry: connections
+//        master data set
+//        keys per request
+//        engine index
+//        offered requests/s over all connections (0 == closed loop)
+//        step length
+//        step label
+// Exit:  achieved requests/s (negative == failure)
+static double RunLoadStep(
+  std::vector<ClientConnection *>& connection_arr,
+  const hedger::S_T *master_array,
+  size_t array_size,
+  int engine,
+  double rate,
+  double seconds,
+  const char *label)
+{
+  using namespace std;
+  int slot_tot = rate > 0.0 ? kClientSlotTot : kClientProbeSlotTot;
+  for (auto connection : connection_arr) {
+    connection->free_arr.clear();
+    for (int slot = slot_tot - 1; slot >= 0; --slot)
+      connection->free_arr.push_back(slot);
+    connection->latency_arr.clear();
+    connection->server_ms = 0.0;
+    connection->sent_tot = 0;
+    connection->received_tot = 0;
+  }
+
+  auto start = ServiceClock::now();
+  auto end = start + chrono::duration_cast<ServiceClock::duration>(
+    chrono::duration<double>(seconds));
+  vector<thread> thread_arr;
+  for (size_t c = 0; c < connection_arr.size(); ++c) {
+    thread_arr.push_back(thread(ClientSender, connection_arr[c],
+      master_array, array_size, engine, rate / connection_arr.size(), end,
+      (unsigned int) rand()));
+    thread_arr.push_back(thread(ClientReceiver, connection_arr[c],
+      array_size));
+  }
+  for (auto& t : thread_arr)
+    t.join();
+  double elapsed = chrono::duration<double>(ServiceClock::now() - start)
+    .count();
+
+  vector<double> latency_arr;
+  double server_ms = 0.0;
+  bool failed = false;
+  for (auto connection : connection_arr) {
+    latency_arr.insert(latency_arr.end(), connection->latency_arr.begin(),
+      connection->latency_arr.end());
+    server_ms += connection->server_ms;
+    failed = failed || connection->failed;
+  }
+  sort(latency_arr.begin(), latency_arr.end());
+  double achieved = latency_arr.size() / elapsed;
+  cout << label << "\t" << achieved << "\t"
+       << achieved * array_size / 1e6 << "\t"
+       << Percentile(latency_arr, 0.5) << "\t"
+       << Percentile(latency_arr, 0.99) << "\t"
+       << Percentile(latency_arr, 0.999) << "\t"
+       << (latency_arr.empty() ? 0.0 : server_ms / latency_arr.size());
+  if (failed)
+    cout << COUT_RED << " (FAIL)" << COUT_NORMAL;
+  cout << endl;
+  return failed ? -1.0 : achieved;
+}
+
+// RunServiceClient
+// Load generator: probe the service's capacity with a closed loop, then
+// offer Poisson load at fractions of it, reporting latency percentiles
+// (from scheduled send to response) and throughput at each step.
+// Entry: socket path
+//        engine name prefix (nullptr == the server's first engine)
+//        keys per request
+//        length of each step, in 100 ms windows
+//        true == pass keys in shared memory instead of the socket
+// Exit:  0 == success
+int RunServiceClient(
+  const char *path,
+  const char *engine_name,
+  size_t array_size,
+  int iteration_tot,
+  bool use_shm)
+{
+  using namespace std;
+  using namespace hedger;
+
+  signal(SIGPIPE, SIG_IGN);
+  vector<ClientConnection *> connection_arr;
+  int result = 0;
+  for (int c = 0; c < kClientConnectionTot; ++c) {
+    ClientConnection *connection = new ClientConnection;
+    connection->fd = ConnectService(path);
+    connection->sched_arr.resize(kClientSlotTot);
+    connection->shm_size = array_size * sizeof(S_T);
+    connection->failed = false;
+    connection_arr.push_back(connection);
+    if (connection->fd < 0) {
+      printf("Cannot connect to %s\n", path);
+      result = -1;
+    }
+  }
+
+  // Each slot of each connection gets its own shared memory object
+  for (int c = 0; !result && use_shm && c < kClientConnectionTot; ++c) {
+    ClientConnection *connection = connection_arr[c];
+    for (int slot = 0; slot < kClientSlotTot; ++slot) {
+      string name = "/sortbench-" + to_string(getpid()) + "-" +
+        to_string(c) + "-" + to_string(slot);
+      int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      void *addr = MAP_FAILED;
+      if (fd >= 0) {
+        if (!ftruncate(fd, max(connection->shm_size, (size_t) 1)))
+          addr = mmap(nullptr, max(connection->shm_size, (size_t) 1),
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+      }
+      if (MAP_FAILED == addr) {
+        if (fd >= 0)
+          shm_unlink(name.c_str());
+        printf("Cannot create shared memory %s\n", name.c_str());
+        result = -1;
+        break;
+      }
+      connection->shm_arr.push_back((S_T *) addr);
+      connection->shm_name_arr.push_back(name);
+    }
+  }
+
+  string name;
+  int engine = -1;
+  if (!result) {
+    engine = FindEngine(connection_arr[0]->fd, engine_name, name);
+    if (engine < 0) {
+      printf("No engine named %s on the server\n",
+        engine_name ? engine_name : "(any)");
+      result = -1;
+    }
+  }
+
+  if (!result) {
+    S_T *master_array = AllocArray(array_size);
+    CreateUniqueDataSet(master_array, array_size);
+    double seconds = iteration_tot * 0.1;
+    cout << COUT_AQUA << "SORT SERVICE LOAD:" << COUT_NORMAL << " " << name
+       << ", " << array_size << " keys per request, "
+       << (use_shm ? "shared memory" : "inline") << ", "
+       << kClientConnectionTot << " connections, " << seconds
+       << " s per step" << endl;
+    cout << "offered/s\treq/s\tMelem/s\tp50 ms\tp99 ms\tp999 ms\tserver "
+         << CHAR_MU << " ms" << endl;
+    double capacity = RunLoadStep(connection_arr, master_array, array_size,
+      engine, 0.0, seconds, "closed");
+    if (capacity <= 0.0)
+      result = -1;
+    for (size_t i = 0; !result &&
+         i < sizeof(kClientLoadArr) / sizeof(kClientLoadArr[0]); ++i) {
+      double rate = capacity * kClientLoadArr[i];
+      string label = to_string((long) rate);
+      if (RunLoadStep(connection_arr, master_array, array_size, engine, rate,
+          seconds, label.c_str()) < 0.0)
+        result = -1;
+    }
+    FreeArray(master_array);
+  }
+
+  for (auto connection : connection_arr) {
+    for (size_t slot = 0; slot < connection->shm_arr.size(); ++slot) {
+      munmap(connection->shm_arr[slot], max(connection->shm_size,
+        (size_t) 1));
+      shm_unlink(connection->shm_name_arr[slot].c_str());
+    }
+    if (connection->fd >= 0)
+      close(connection->fd);
+    delete connection;
+  }
+  return result;
+}
@@ -0,0 +1,143 @@
+// sortbench_small.cc
+//
+// Small-N benchmark mode: sorting networks against the general engines on
+// many independent arrays of 2 to 32 elements.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "sorting_network.h"
+#include "insertion_sort.h"
+#include "merge_sort.h"
+#include "quick_sort.h"
+
+// Engines compared, in column order; the network is column 0.
+static const int kSmallEngineTot = 4;
+
+// TimeSmallSort
+// Sort every group of n in the work array with one engine.
+// Entry: engine index (0 == network)
+//        engines
+//        master data
+//        work array
+//        elements per group
+//        group total
+//        repetitions
+// Exit:  mean ns per group, negative on verification failure
+static double TimeSmallSort(
+  int engine,
+  hedger::Algo **algo_arr,
+  const hedger::S_T *master_array,
+  hedger::S_T *array,
+  size_t n,
+  size_t group_tot,
+  int iteration_tot)
+{
+  using namespace std;
+  using FpNanoseconds =
+        chrono::duration<double, chrono::nanoseconds::period>;
+  double ns = 0.0;
+  for (int it = 0; it < iteration_tot; ++it) {
+    memcpy(array, master_array, n * group_tot * sizeof(hedger::S_T));
+    auto start = chrono::high_resolution_clock::now();
+    if (!engine) {
+      for (size_t g = 0; g < group_tot; ++g)
+        hedger::SortNetwork(&array[g * n], n);
+    } else {
+      for (size_t g = 0; g < group_tot; ++g)
+        algo_arr[engine]->Test(&array[g * n], n);
+    }
+    auto stop = chrono::high_resolution_clock::now();
+    ns += FpNanoseconds(stop - start).count();
+  }
+  if (engine)
+    algo_arr[engine]->ResetStats();
+  for (size_t g = 0; g < group_tot; ++g)
+    if (!VerifyNonDescending(&array[g * n], n))
+      return -1.0;
+  return ns / ((double) iteration_tot * group_tot);
+}
+
+// RunSmallSortBench
+// For each size from 2 to kSortNetworkMax, sort group_tot random arrays
+// with the network and with the branchy engines.
+// Entry: number of arrays per size
+//        repetitions
+// Exit:  0 == success
+int RunSmallSortBench(size_t group_tot, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+
+  size_t element_tot = group_tot * kSortNetworkMax;
+  S_T *master_array = AllocArray(element_tot);
+  S_T *array = AllocArray(element_tot);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+
+  InsertionSort insertion_sort;
+  QuickSort quick_sort;
+  MergeSort merge_sort;
+  Algo *algo_arr[kSmallEngineTot] = {
+    nullptr, &insertion_sort, &quick_sort, &merge_sort
+  };
+
+  cout << COUT_AQUA << "SMALL-N:" << COUT_NORMAL << endl;
+  cout << group_tot << " arrays per size, ns per array" << endl;
+  cout << "N\tNetwork";
+  for (int e = 1; e < kSmallEngineTot; ++e)
+    cout << "\t" << algo_arr[e]->GetName();
+  cout << endl;
+
+  int result = 0;
+  for (size_t n = 2; n <= kSortNetworkMax; ++n) {
+    CreateRandomDataSet(master_array, n * group_tot, n);
+    cout << n;
+    for (int e = 0; e < kSmallEngineTot; ++e) {
+      double ns = TimeSmallSort(e, algo_arr, master_array, array, n,
+        group_tot, iteration_tot);
+      if (ns < 0.0) {
+        cout << "\t" << COUT_RED << "FAIL" << COUT_NORMAL;
+        result = -1;
+      } else {
+        cout << "\t" << ns;
+      }
+    }
+    cout << endl;
+  }
+
+  FreeArray(master_array);
+  FreeArray(array);
+  return result;
+}
@@ -0,0 +1,215 @@
+// sortbench_strings.cc
+//
+// String sorting benchmark: the string engines on generated or loaded
+// variable-length keys.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "string_sort.h"
+
+// Shared prefixes in the prefix-heavy set
+const int kStringPrefixTot = 16;
+// Path words in the URL-like set
+const int kUrlWordTot = 64;
+
+// StringSet
+// Strings packed back to back, NUL-terminated, in one buffer
+struct StringSet {
+  std::vector<char> pool;
+  std::vector<size_t> offset_arr;
+  void Add(const std::string& s) {
+    offset_arr.push_back(pool.size());
+    pool.insert(pool.end(), s.begin(), s.end());
+    pool.push_back('\0');
+  }
+};
+
+// RandomWord
+// Exit: min_len..max_len random lower-case letters
+static std::string RandomWord(int min_len, int max_len)
+{
+  int len = min_len + rand() % (max_len - min_len + 1);
+  std::string word;
+  for (int i = 0; i < len; ++i)
+    word += (char) ('a' + rand() % 26);
+  return word;
+}
+
+// CreateStringSet
+// Entry: set name (random, prefix, url) or path of a newline-delimited file
+//        maximum strings
+//        set to fill
+// Exit:  true == success
+static bool CreateStringSet(
+  const char *set_name,
+  size_t string_max,
+  StringSet& set)
+{
+  if (!strcmp(set_name, "random")) {
+    for (size_t i = 0; i < string_max; ++i)
+      set.Add(RandomWord(1, 24));
+  } else if (!strcmp(set_name, "prefix")) {
+    // Prefixes 16..46 bytes long cut from one base, so they also share
+    // prefixes with each other
+    std::string base = RandomWord(48, 48);
+    for (size_t i = 0; i < string_max; ++i)
+      set.Add(base.substr(0, 16 + 2 * (rand() % kStringPrefixTot)) +
+        RandomWord(1, 8));
+  } else if (!strcmp(set_name, "url")) {
+    static const char *kTldArr[] = { ".com", ".org", ".net", ".io" };
+    std::vector<std::string> host_arr(string_max / 64 + 1);
+    for (auto& host : host_arr)
+      host = RandomWord(4, 12) + kTldArr[rand() % 4];
+    std::vector<std::string> word_arr(kUrlWordTot);
+    for (auto& word : word_arr)
+      word = RandomWord(3, 10);
+    for (size_t i = 0; i < string_max; ++i) {
+      std::string url = rand() % 2 ? "https://www." : "https://";
+      url += host_arr[rand() % host_arr.size()];
+      int segment_tot = 1 + rand() % 4;
+      for (int j = 0; j < segment_tot; ++j)
+        url += "/" + word_arr[rand() % kUrlWordTot];
+      if (rand() % 4 == 0)
+        url += "?id=" + std::to_string(rand() % 100000);
+      set.Add(url);
+    }
+  } else {
+    FILE *file = fopen(set_name, "r");
+    if (!file) {
+      printf("Cannot open %s (random, prefix, url or a file)\n", set_name);
+      return false;
+    }
+    std::string line;
+    int c;
+    while (set.offset_arr.size() < string_max && EOF != (c = fgetc(file))) {
+      if ('\n' == c) {
+        if (!line.empty() && '\r' == line.back())
+          line.pop_back();
+        set.Add(line);
+        line.clear();
+      } else {
+        line += (char) c;
+      }
+    }
+    if (!line.empty() && set.offset_arr.size() < string_max)
+      set.Add(line);
+    fclose(file);
+    if (set.offset_arr.empty()) {
+      printf("%s has no lines\n", set_name);
+      return false;
+    }
+  }
+  return true;
+}
+
+// RunStringBench
+// Time each string engine on array_size strings of the named set,
+// relative to std::sort with strcmp.
+// Entry: set name (random, prefix, url) or path of a newline-delimited file
+//        maximum strings
+//        repetitions
+// Exit:  0 == success
+int RunStringBench(const char *set_name, size_t array_size, int iteration_tot)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+
+  StringSet set;
+  if (!CreateStringSet(set_name, array_size, set))
+    return -1;
+  size_t string_tot = set.offset_arr.size();
+  vector<const char *> master(string_tot);
+  for (size_t i = 0; i < string_tot; ++i)
+    master[i] = &set.pool[set.offset_arr[i]];
+
+  cout << COUT_AQUA << "Strings (" << set_name << "): " << COUT_NORMAL
+       << string_tot << " strings, "
+       << (double) (set.pool.size() - string_tot) / string_tot
+       << " bytes mean length" << endl;
+
+  // The std::sort reference runs first
+  vector<StringAlgo *> engine_arr;
+  engine_arr.push_back(new StringStdSort());
+  engine_arr.push_back(new MultikeyQuickSort());
+  engine_arr.push_back(new StringRadixSort());
+  engine_arr.push_back(new BurstSort());
+
+  Arena arena;
+  size_t scratch_size = 0;
+  for (auto engine : engine_arr)
+    scratch_size = max(scratch_size, engine->GetScratchSize(string_tot));
+  if (scratch_size && arena.Reserve(scratch_size))
+    for (auto engine : engine_arr)
+      engine->SetArena(&arena);
+
+  cout << "engine\t" << CHAR_MU << " ms\tMstr/s\tSTD" << endl;
+  int result = 0;
+  double baseline_ms = 0.0;
+  vector<const char *> arr;
+  StringLess less;
+  for (auto engine : engine_arr) {
+    double ms = 0.0;
+    bool passed = true;
+    for (int it = 0; it < iteration_tot; ++it) {
+      arr = master;
+      auto start = chrono::high_resolution_clock::now();
+      int error = engine->Test(&arr[0], string_tot);
+      auto stop = chrono::high_resolution_clock::now();
+      ms += FpMilliseconds(stop - start).count();
+      for (size_t i = 1; !error && passed && i < string_tot; ++i)
+        passed = !less(arr[i], arr[i - 1]);
+      passed = passed && !error;
+    }
+    ms /= iteration_tot;
+    if (!baseline_ms)
+      baseline_ms = ms;
+    cout << COUT_WHITE << engine->GetName();
+    if (passed) {
+      cout << COUT_GREEN << " (PASS)";
+    } else {
+      cout << COUT_RED << " (FAIL)";
+      result = -1;
+    }
+    cout << COUT_NORMAL << "\t" << ms << "\t"
+         << (ms > 0.0 ? string_tot / ms / 1000.0 : 0.0) << "\t"
+         << (ms > 0.0 ? baseline_ms / ms : 0.0) << "x" << endl;
+  }
+
+  for (auto engine : engine_arr)
+    delete engine;
+  return result;
+}
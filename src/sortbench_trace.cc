@@ -0,0 +1,227 @@
+// sortbench_trace.cc
+//
+// Trace benchmark: time Merge Sort Multi-Core with tracing off and on,
+// summarize where its threads spent the last traced sort, and export that
+// sort as a Chrome trace.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "merge_sort_multicore.h"
+#include "trace.h"
+
+using FpMilliseconds =
+      std::chrono::duration<double, std::chrono::milliseconds::period>;
+
+// TraceThreadTime
+// Where one thread's time went, in ns
+struct TraceThreadTime {
+  int tid;
+  unsigned long long task;
+  unsigned long long join;
+  unsigned long long merge;
+};
+
+// TraceTotals
+// Sum the spans of one thread's buffer by name, and keep the sort's wall
+// time and the largest merge seen.
+// Entry: buffer
+//        out: thread time
+//        in/out: sort wall time in ns
+//        in/out: largest merge, in elements
+//        in/out: its time in ns
+static void TraceTotals(
+  const hedger::TraceBuffer *buffer,
+  TraceThreadTime& time,
+  unsigned long long& sort_ns,
+  long long& merge_max,
+  unsigned long long& merge_max_ns)
+{
+  using namespace hedger;
+  std::vector<const TraceEvent *> stack;
+  time.tid = buffer->tid;
+  time.task = time.join = time.merge = 0;
+  for (size_t i = 0; i < buffer->event_tot; ++i) {
+    const TraceEvent& event = buffer->event_arr[i];
+    if (kTraceBegin == event.phase) {
+      stack.push_back(&event);
+      continue;
+    }
+    if (kTraceEnd != event.phase || stack.empty())
+      continue;
+    const TraceEvent& begin = *stack.back();
+    stack.pop_back();
+    unsigned long long ns = event.ts - begin.ts;
+    if (kTraceTask == begin.name) {
+      time.task += ns;
+    } else if (kTraceJoin == begin.name) {
+      time.join += ns;
+    } else if (kTraceSort == begin.name) {
+      sort_ns = std::max(sort_ns, ns);
+    } else if (kTraceMerge == begin.name) {
+      time.merge += ns;
+      if (begin.arg > merge_max) {
+        merge_max = begin.arg;
+        merge_max_ns = ns;
+      }
+    }
+  }
+}
+
+// RunTraceBench
+// Time Merge Sort Multi-Core on random keys untraced and traced, to show
+// what tracing costs, then report each thread of the last traced sort:
+// time in its tasks, idle in joins, merging, and busy (tasks less joins).
+// The largest merge runs alone on one thread, so its share of the wall
+// time is serial; the busiest thread over the mean busy time of the
+// thread budget's slots is the imbalance.  Threads spawned late into a
+// freed slot share it, so the mean is not taken over the trace buffers.
+// Entry: trace output path
+//        array size in elements
+//        repetitions
+//        thread budget
+// Exit:  0 == success
+int RunTraceBench(
+  const char *path,
+  size_t array_size,
+  int iteration_tot,
+  int thread_max)
+{
+  using namespace std;
+  using namespace hedger;
+
+  S_T *master_array = AllocArray(array_size);
+  S_T *array = AllocArray(array_size);
+  if (!master_array || !array) {
+    printf("Failed to allocate data set array.\n");
+    FreeArray(master_array);
+    FreeArray(array);
+    return -1;
+  }
+  CreateRandomDataSet(master_array, array_size, array_size);
+
+  MergeSortMultiCore engine;
+  engine.SetThreadMax(thread_max);
+  cout << COUT_AQUA << "TRACE:" << COUT_NORMAL << endl;
+  cout << engine.GetName() << ", " << array_size << " elements, "
+       << iteration_tot << " iterations, " << thread_max << " threads"
+       << endl;
+
+  // Untraced first, then traced; each traced sort replaces the last one's
+  // buffers, so the export holds one sort.  Slots freed by finished
+  // subtrees are spawned again, so one sort starts several threads per
+  // slot; threads past the pool are counted as dropped events.
+  size_t buffer_max = std::max(kTraceBufferMax,
+    (size_t) engine.GetThreadMax() * 8 + 1);
+  double ms_arr[2] = { 0.0, 0.0 };
+  bool passed = true;
+  for (int traced = 0; traced < 2; ++traced) {
+    if (!TraceEnable(traced, buffer_max)) {
+      printf("Failed to allocate trace buffers.\n");
+      FreeArray(master_array);
+      FreeArray(array);
+      return -1;
+    }
+    for (int it = 0; it < iteration_tot; ++it) {
+      TraceClear();
+      memcpy(array, master_array, array_size * sizeof(S_T));
+      auto start = chrono::high_resolution_clock::now();
+      engine.Test(array, array_size);
+      auto stop = chrono::high_resolution_clock::now();
+      ms_arr[traced] += FpMilliseconds(stop - start).count();
+      passed = passed && VerifyNonDescending(array, array_size);
+    }
+    ms_arr[traced] /= iteration_tot;
+  }
+  TraceEnable(false);
+  FreeArray(master_array);
+  FreeArray(array);
+
+  cout << COUT_WHITE << "untraced" << COUT_NORMAL << "\t" << CHAR_MU << ":"
+       << ms_arr[0] << " ms" << endl;
+  cout << COUT_WHITE << "traced" << COUT_NORMAL << "\t\t" << CHAR_MU << ":"
+       << ms_arr[1] << " ms\t("
+       << (ms_arr[0] > 0.0 ? 100.0 * (ms_arr[1] / ms_arr[0] - 1.0) : 0.0)
+       << "% overhead)" << endl;
+
+  // Summary of the last traced sort, thread by thread
+  vector<TraceThreadTime> time_arr;
+  unsigned long long sort_ns = 0, merge_max_ns = 0;
+  long long merge_max = 0;
+  size_t event_tot = 0, drop_tot = TraceGetLostTot();
+  for (TraceBuffer *buffer = TraceGetBuffers(); buffer;
+       buffer = buffer->next) {
+    TraceThreadTime time;
+    TraceTotals(buffer, time, sort_ns, merge_max, merge_max_ns);
+    time_arr.push_back(time);
+    event_tot += buffer->event_tot;
+    drop_tot += buffer->drop_tot;
+  }
+  sort(time_arr.begin(), time_arr.end(),
+    [](const TraceThreadTime& a, const TraceThreadTime& b) {
+      return a.tid < b.tid;
+    });
+  cout << "thread\ttask ms\tjoin ms\tmerge ms\tbusy ms" << endl;
+  double busy_tot = 0.0, busy_max = 0.0;
+  for (auto& time : time_arr) {
+    double busy = (time.task - time.join) / 1e6;
+    busy_tot += busy;
+    busy_max = max(busy_max, busy);
+    cout << time.tid << "\t" << time.task / 1e6 << "\t" << time.join / 1e6
+         << "\t" << time.merge / 1e6 << "\t\t" << busy << endl;
+  }
+  if (sort_ns) {
+    cout << "wall: " << sort_ns / 1e6 << " ms\ttop merge: " << merge_max
+         << " keys, " << merge_max_ns / 1e6 << " ms ("
+         << 100.0 * merge_max_ns / sort_ns << "% serial)\timbalance: "
+         << (busy_tot > 0.0 ? busy_max * engine.GetThreadMax() / busy_tot :
+             0.0)
+         << "x" << endl;
+  }
+
+  int result = passed ? 0 : -1;
+  if (TraceWrite(path)) {
+    cout << "Wrote " << event_tot << " events from " << time_arr.size()
+         << " threads to " << path << " (chrome://tracing or "
+         << "ui.perfetto.dev)";
+    if (drop_tot)
+      cout << COUT_RED << "; " << drop_tot << " events dropped"
+           << COUT_NORMAL;
+    cout << endl;
+  } else {
+    printf("Failed to write trace %s.\n", path);
+    result = -1;
+  }
+  TraceRelease();
+  if (!passed)
+    cout << COUT_RED << "FAIL" << COUT_NORMAL << endl;
+  return result;
+}
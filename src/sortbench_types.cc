@@ -0,0 +1,174 @@
+// sortbench_types.cc
+//
+// Element-type benchmark: the comparison engines compiled for each type
+// in sort_types.h, picked at run time.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+// C headers
+#include <stdio.h>
+#include <string.h>
+
+// C++ headers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+// Project-specific
+#include "sortbench_common.h"
+#include "sortbench.h"
+#include "arena.h"
+#include "sort_types.h"
+#include "quick_sort_randomized.h"
+#include "quick_sort_3way.h"
+#include "quick_sort_incremental.h"
+#include "merge_sort.h"
+#include "merge_sort_multicore.h"
+#include "merge_sort_cache.h"
+#include "heap_sort.h"
+#include "heap_sort_variants.h"
+#include "insertion_sort.h"
+
+// VerifyOrdered
+// Exit: true == no element orders before its predecessor
+template <class T, class Compare>
+static bool VerifyOrdered(const std::vector<T>& arr, const Compare& less)
+{
+  for (size_t i = 1; i < arr.size(); ++i)
+    if (less(arr[i], arr[i - 1]))
+      return false;
+  return true;
+}
+
+// BenchType
+// Time every comparison engine instantiated for T on the same random data.
+// Entry: array size in elements
+//        repetitions
+//        true == skip O(n^2) engines
+// Exit:  0 == success
+template <class T, class Compare>
+static int BenchType(size_t array_size, int iteration_tot, bool fast_only)
+{
+  using namespace std;
+  using namespace hedger;
+  using FpMilliseconds =
+        chrono::duration<double, chrono::milliseconds::period>;
+
+  vector<BasicAlgo<T, Compare> *> engine_arr;
+  engine_arr.push_back(new BasicQuickSort<T, Compare>());
+  engine_arr.push_back(new BasicQuickSortRandomized<T, Compare>());
+  engine_arr.push_back(new BasicQuickSort3Way<T, Compare>());
+  engine_arr.push_back(new BasicQuickSortIncremental<T, Compare>());
+  engine_arr.push_back(new BasicMergeSort<T, Compare>());
+  engine_arr.push_back(new BasicMergeSortMultiCore<T, Compare>());
+  engine_arr.push_back(new BasicMergeSortTiled<T, Compare>());
+  engine_arr.push_back(new BasicFunnelSort<T, Compare>());
+  engine_arr.push_back(new BasicHeapSort<T, Compare>());
+  engine_arr.push_back(new BasicHeapSortIterative<T, Compare>());
+  engine_arr.push_back(new BasicHeapSortBottomUp<T, Compare>());
+  engine_arr.push_back(new BasicHeapSortDary<T, Compare>(4));
+  engine_arr.push_back(new BasicHeapSortDary<T, Compare>(8));
+  if (!fast_only)
+    engine_arr.push_back(new BasicInsertionSort<T, Compare>());
+
+  Arena arena;
+  size_t scratch_size = 0;
+  for (auto engine : engine_arr)
+    scratch_size = max(scratch_size, engine->GetScratchSize(array_size));
+  if (scratch_size && arena.Reserve(scratch_size))
+    for (auto engine : engine_arr)
+      engine->SetArena(&arena);
+
+  vector<T> master(array_size);
+  for (size_t i = 0; i < array_size; ++i)
+    master[i] = RandomKey<T>();
+
+  cout << "engine\t" << CHAR_MU << " ms\tMelem/s" << endl;
+  int result = 0;
+  vector<T> arr;
+  for (auto engine : engine_arr) {
+    double ms = 0.0;
+    bool passed = true;
+    for (int it = 0; it < iteration_tot; ++it) {
+      arr = master;
+      auto start = chrono::high_resolution_clock::now();
+      engine->Test(&arr[0], array_size);
+      auto stop = chrono::high_resolution_clock::now();
+      ms += FpMilliseconds(stop - start).count();
+      passed = passed && VerifyOrdered(arr, Compare());
+    }
+    ms /= iteration_tot;
+    cout << COUT_WHITE << engine->GetName();
+    if (passed) {
+      cout << COUT_GREEN << " (PASS)";
+    } else {
+      cout << COUT_RED << " (FAIL)";
+      result = -1;
+    }
+    cout << COUT_NORMAL << "\t" << ms << "\t"
+         << (ms > 0.0 ? array_size / ms / 1000.0 : 0.0) << endl;
+  }
+
+  for (auto engine : engine_arr)
+    delete engine;
+  return result;
+}
+
+// RunTypedBench
+// Dispatch to the engines precompiled for the named element type.
+// Entry: type name (int32, int64, uint64, float, double or record)
+//        array size in elements
+//        repetitions
+//        true == skip O(n^2) engines
+// Exit:  0 == success, -1 == unknown type or a failed sort
+int RunTypedBench(
+  const char *type_name,
+  size_t array_size,
+  int iteration_tot,
+  bool fast_only)
+{
+  using namespace std;
+  using namespace hedger;
+
+  cout << COUT_AQUA << "Element type " << type_name << ":" << COUT_NORMAL
+       << endl;
+  if (!strcmp(type_name, "int32"))
+    return BenchType<int32_t, less<int32_t> >(array_size, iteration_tot,
+      fast_only);
+  if (!strcmp(type_name, "int64"))
+    return BenchType<int64_t, less<int64_t> >(array_size, iteration_tot,
+      fast_only);
+  if (!strcmp(type_name, "uint64"))
+    return BenchType<uint64_t, less<uint64_t> >(array_size, iteration_tot,
+      fast_only);
+  if (!strcmp(type_name, "float"))
+    return BenchType<float, less<float> >(array_size, iteration_tot,
+      fast_only);
+  if (!strcmp(type_name, "double"))
+    return BenchType<double, less<double> >(array_size, iteration_tot,
+      fast_only);
+  if (!strcmp(type_name, "record"))
+    return BenchType<KeyRecord, KeyRecordLess>(array_size, iteration_tot,
+      fast_only);
+  printf("Unknown type %s (int32, int64, uint64, float, double, record)\n",
+    type_name);
+  return -1;
+}
@@ -0,0 +1,185 @@
+// sorting_network.h
+//
+// Sorting networks for small fixed sizes, generated at compile time.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef SORTING_NETWORK_H_
+#define SORTING_NETWORK_H_
+
+#include <cstddef>
+
+#include "algo.h"
+
+namespace hedger
+{
+// Largest size with a generated network.
+const size_t kSortNetworkMax = 32;
+
+// NetworkSwapped
+// Tell the comparator a compare-exchange swapped its pair: a no-op unless
+// it counts through a policy (SortContext::CountedLess()).
+template <class Compare>
+inline void NetworkSwapped(const Compare& less, bool swap) {}
+
+template <class Stats, class Compare>
+inline void NetworkSwapped(const StatsLess<Stats, Compare>& less, bool swap)
+{
+  if (swap)
+    less.stats.Swap();
+}
+
+// CompareExchange
+// Order a[I] <= a[J] without branching; the selects compile to
+// conditional moves.
+template <size_t I, size_t J>
+struct CompareExchange {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    T x = a[I];
+    T y = a[J];
+    bool swap = less(y, x);
+    a[I] = swap ? y : x;
+    a[J] = swap ? x : y;
+    NetworkSwapped(less, swap);
+  }
+};
+
+// BoseNelsonMerge
+// Merge sorted a[I..I+NI) and a[J..J+NJ) (Bose & Nelson, 1962).  The last
+// parameter picks the base case; 0 is the general split.
+template <size_t I, size_t NI, size_t J, size_t NJ,
+  int Case = (!NI || !NJ) ? 4 :
+             (1 == NI && 1 == NJ) ? 1 :
+             (1 == NI && 2 == NJ) ? 2 :
+             (2 == NI && 1 == NJ) ? 3 : 0>
+struct BoseNelsonMerge {
+  static const size_t A = NI / 2;
+  static const size_t B = (NI & 1) ? NJ / 2 : (NJ + 1) / 2;
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    BoseNelsonMerge<I, A, J, B>::Apply(a, less);
+    BoseNelsonMerge<I + A, NI - A, J + B, NJ - B>::Apply(a, less);
+    BoseNelsonMerge<I + A, NI - A, J, B>::Apply(a, less);
+  }
+};
+
+template <size_t I, size_t NI, size_t J, size_t NJ>
+struct BoseNelsonMerge<I, NI, J, NJ, 1> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    CompareExchange<I, J>::Apply(a, less);
+  }
+};
+
+template <size_t I, size_t NI, size_t J, size_t NJ>
+struct BoseNelsonMerge<I, NI, J, NJ, 2> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    CompareExchange<I, J + 1>::Apply(a, less);
+    CompareExchange<I, J>::Apply(a, less);
+  }
+};
+
+template <size_t I, size_t NI, size_t J, size_t NJ>
+struct BoseNelsonMerge<I, NI, J, NJ, 3> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    CompareExchange<I, J>::Apply(a, less);
+    CompareExchange<I + 1, J>::Apply(a, less);
+  }
+};
+
+template <size_t I, size_t NI, size_t J, size_t NJ>
+struct BoseNelsonMerge<I, NI, J, NJ, 4> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {}
+};
+
+// BoseNelsonSort
+// Sort a[I..I+N) by sorting both halves and merging them.  Every index is
+// a template argument, so the whole network unrolls to straight-line code.
+template <size_t I, size_t N>
+struct BoseNelsonSort {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {
+    BoseNelsonSort<I, N / 2>::Apply(a, less);
+    BoseNelsonSort<I + N / 2, N - N / 2>::Apply(a, less);
+    BoseNelsonMerge<I, N / 2, I + N / 2, N - N / 2>::Apply(a, less);
+  }
+};
+
+template <size_t I>
+struct BoseNelsonSort<I, 1> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {}
+};
+
+template <size_t I>
+struct BoseNelsonSort<I, 0> {
+  template <class T, class Compare>
+  static inline void Apply(T *a, const Compare& less) {}
+};
+
+// NetworkSort
+// Sort exactly N elements.
+template <size_t N, class T, class Compare>
+inline void NetworkSort(T *arr, const Compare& less)
+{
+  BoseNelsonSort<0, N>::Apply(arr, less);
+}
+
+// SortNetwork
+// Sort a small array with the network for its size.
+// Entry: pointer to array
+//        size in elements
+//        strict weak ordering
+// Exit:  false == size exceeds kSortNetworkMax (array untouched)
+template <class T, class Compare>
+inline bool SortNetwork(T *arr, size_t size, const Compare& less)
+{
+#define SORT_NETWORK_CASE(n) case n: NetworkSort<n>(arr, less); return true;
+  switch (size) {
+    case 0:
+    case 1:
+      return true;
+    SORT_NETWORK_CASE(2)  SORT_NETWORK_CASE(3)  SORT_NETWORK_CASE(4)
+    SORT_NETWORK_CASE(5)  SORT_NETWORK_CASE(6)  SORT_NETWORK_CASE(7)
+    SORT_NETWORK_CASE(8)  SORT_NETWORK_CASE(9)  SORT_NETWORK_CASE(10)
+    SORT_NETWORK_CASE(11) SORT_NETWORK_CASE(12) SORT_NETWORK_CASE(13)
+    SORT_NETWORK_CASE(14) SORT_NETWORK_CASE(15) SORT_NETWORK_CASE(16)
+    SORT_NETWORK_CASE(17) SORT_NETWORK_CASE(18) SORT_NETWORK_CASE(19)
+    SORT_NETWORK_CASE(20) SORT_NETWORK_CASE(21) SORT_NETWORK_CASE(22)
+    SORT_NETWORK_CASE(23) SORT_NETWORK_CASE(24) SORT_NETWORK_CASE(25)
+    SORT_NETWORK_CASE(26) SORT_NETWORK_CASE(27) SORT_NETWORK_CASE(28)
+    SORT_NETWORK_CASE(29) SORT_NETWORK_CASE(30) SORT_NETWORK_CASE(31)
+    SORT_NETWORK_CASE(32)
+    default:
+      return false;
+  }
+#undef SORT_NETWORK_CASE
+}
+
+inline bool SortNetwork(hedger::S_T *arr, size_t size)
+{
+  return SortNetwork(arr, size, std::less<hedger::S_T>());
+}
+}
+
+#endif // SORTING_NETWORK_H_
@@ -0,0 +1,204 @@
+// std_sort.cc
+//
+// Reference engines wrapping the C and C++ standard library sorts.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<execution>)
+#include <execution>
+#define SORTBENCH_HAVE_EXECUTION 1
+#endif
+#endif
+
+#include "std_sort.h"
+
+namespace hedger {
+
+// Chunks smaller than this are not worth a thread of their own.
+const size_t kStdParallelMin = 1 << 15;
+
+// StdSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StdSort::Test(hedger::S_T *arr, size_t size, hedger::S_T range)
+{
+  std::sort(arr, arr + size);
+  return 0;
+}
+
+// StdStableSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StdStableSort::Test(hedger::S_T *arr, size_t size, hedger::S_T range)
+{
+  std::stable_sort(arr, arr + size);
+  return 0;
+}
+
+// StdHeapSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StdHeapSort::Test(hedger::S_T *arr, size_t size, hedger::S_T range)
+{
+  std::make_heap(arr, arr + size);
+  std::sort_heap(arr, arr + size);
+  return 0;
+}
+
+// QSortCompare
+// qsort() comparison callback for S_T
+static int QSortCompare(const void *a, const void *b)
+{
+  hedger::S_T key_a = *(const hedger::S_T *) a;
+  hedger::S_T key_b = *(const hedger::S_T *) b;
+  return (key_a > key_b) - (key_a < key_b);
+}
+
+// QSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int QSort::Test(hedger::S_T *arr, size_t size, hedger::S_T range)
+{
+  qsort(arr, size, sizeof(hedger::S_T), QSortCompare);
+  return 0;
+}
+
+// StdParallelTask
+// One chunk sort (mid == nullptr) or one pairwise merge for a thread
+struct StdParallelTask {
+  hedger::S_T *first;
+  hedger::S_T *mid;
+  hedger::S_T *last;
+};
+
+// StdParallelWorker
+// Thread body: sort or merge one task
+// Entry: pointer to StdParallelTask
+static void *StdParallelWorker(void *param)
+{
+  StdParallelTask *task = (StdParallelTask *) param;
+  if (task->mid)
+    std::inplace_merge(task->first, task->mid, task->last);
+  else
+    std::sort(task->first, task->last);
+  return nullptr;
+}
+
+// RunStdParallelTasks
+// Run every task at once, the last on the calling thread.  A task whose
+// thread cannot be created runs on the calling thread instead.
+// Entry: task vector
+static void RunStdParallelTasks(std::vector<StdParallelTask>& task_arr)
+{
+  size_t task_tot = task_arr.size();
+  std::vector<pthread_t> thread_arr(task_tot);
+  std::vector<bool> started_arr(task_tot, false);
+  for (size_t i = 0; i + 1 < task_tot; ++i) {
+    started_arr[i] = !pthread_create(&thread_arr[i], nullptr,
+      StdParallelWorker, &task_arr[i]);
+    if (!started_arr[i]) {
+      // TODO: LOG ERROR
+      StdParallelWorker(&task_arr[i]);
+    }
+  }
+  if (task_tot)
+    StdParallelWorker(&task_arr[task_tot - 1]);
+  for (size_t i = 0; i + 1 < task_tot; ++i) {
+    if (started_arr[i])
+      pthread_join(thread_arr[i], nullptr);
+  }
+}
+
+// Constructor
+StdSortParallel::StdSortParallel() {
+  thread_max_ = std::thread::hardware_concurrency();
+  if (thread_max_ < 1)
+    thread_max_ = 1;
+}
+
+// GetName
+const char *StdSortParallel::GetName()
+{
+#ifdef SORTBENCH_HAVE_EXECUTION
+  return "std::sort (par)";
+#else
+  return "std::sort (par, threaded)";
+#endif
+}
+
+// StdSortParallel::Test
+// The execution policy picks its own thread count, so the thread budget
+// only applies to the threaded fallback.
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StdSortParallel::Test(hedger::S_T *arr, size_t size, hedger::S_T range)
+{
+#ifdef SORTBENCH_HAVE_EXECUTION
+  std::sort(std::execution::par, arr, arr + size);
+#else
+  size_t chunk_tot = std::min((size_t) thread_max_, size / kStdParallelMin);
+  if (chunk_tot < 2) {
+    std::sort(arr, arr + size);
+    return 0;
+  }
+  std::vector<size_t> bound_arr(chunk_tot + 1);
+  for (size_t i = 0; i <= chunk_tot; ++i)
+    bound_arr[i] = size * i / chunk_tot;
+
+  std::vector<StdParallelTask> task_arr;
+  for (size_t i = 0; i < chunk_tot; ++i) {
+    StdParallelTask task = {
+      arr + bound_arr[i], nullptr, arr + bound_arr[i + 1]
+    };
+    task_arr.push_back(task);
+  }
+  RunStdParallelTasks(task_arr);
+
+  // Merge neighbouring runs, doubling the run width each round
+  for (size_t width = 1; width < chunk_tot; width *= 2) {
+    task_arr.clear();
+    for (size_t i = 0; i + width < chunk_tot; i += 2 * width) {
+      StdParallelTask task = {
+        arr + bound_arr[i],
+        arr + bound_arr[i + width],
+        arr + bound_arr[std::min(i + 2 * width, chunk_tot)]
+      };
+      task_arr.push_back(task);
+    }
+    RunStdParallelTasks(task_arr);
+  }
+#endif
+  return 0;
+}
+
+} // namespace hedger
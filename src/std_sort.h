@@ -0,0 +1,92 @@
+// std_sort.h
+//
+// Reference engines wrapping the C and C++ standard library sorts.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef STD_SORT_H_
+#define STD_SORT_H_
+
+#include "algo.h"
+#include "roofline.h"
+
+namespace hedger
+{
+// StdSort
+// std::sort (introsort).  This is the reference every other engine is
+// measured against in the report.
+class StdSort : public Algo
+{
+ public:
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "std::sort"; }
+  // As QuickSort: introsort partitions level by level
+  double GetMemoryBytes(size_t size) {
+    return 2.0 * size * sizeof(hedger::S_T) *
+      RooflineLevels(size * sizeof(hedger::S_T));
+  }
+};
+
+// StdStableSort
+// std::stable_sort (merge sort with a temporary buffer it allocates itself)
+class StdStableSort : public Algo
+{
+ public:
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "std::stable_sort"; }
+};
+
+// StdHeapSort
+// std::make_heap followed by std::sort_heap
+class StdHeapSort : public Algo
+{
+ public:
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "std::sort_heap"; }
+};
+
+// QSort
+// C library qsort(), comparing through a function pointer
+class QSort : public Algo
+{
+ public:
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "qsort"; }
+};
+
+// StdSortParallel
+// std::sort(std::execution::par, ...) where the library has it (C++17 and
+// <execution>); otherwise std::sort on one chunk per thread followed by
+// rounds of pairwise std::inplace_merge, also one pair per thread.
+class StdSortParallel : public Algo
+{
+ public:
+  StdSortParallel();
+  int Test(hedger::S_T *arr, size_t size, hedger::S_T range = 0);
+  const char *GetName();
+  void SetThreadMax(int thread_max) {
+    thread_max_ = thread_max < 1 ? 1 : thread_max;
+  }
+  int GetThreadMax() { return thread_max_; }
+ private:
+  int thread_max_;
+};
+}
+
+#endif // STD_SORT_H_
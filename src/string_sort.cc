@@ -0,0 +1,280 @@
+// string_sort.cc
+//
+// Engines for sorting NUL-terminated strings.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <string.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "string_sort.h"
+
+namespace hedger {
+
+// Groups this small are finished by insertion sort
+const size_t kStringInsertionMax = 16;
+// Buckets smaller than this are handed from radix sort to multikey quicksort
+const size_t kStringRadixMin = 256;
+// Burstsort bucket size that triggers a burst (pointers, about 64 KB)
+const size_t kBurstMax = 8192;
+
+// CharAt
+// Exit: the byte at depth as an unsigned value (0 == end of string)
+static inline unsigned int CharAt(const char *s, size_t depth)
+{
+  return (unsigned char) s[depth];
+}
+
+// InsertionSortFrom
+// Insertion sort on strings known to share their first depth bytes
+// Entry: pointer to array
+//        size of array
+//        depth
+static void InsertionSortFrom(const char **arr, size_t size, size_t depth)
+{
+  for (size_t i = 1; i < size; ++i) {
+    const char *s = arr[i];
+    size_t j = i;
+    while (j && strcmp(s + depth, arr[j - 1] + depth) < 0) {
+      arr[j] = arr[j - 1];
+      --j;
+    }
+    arr[j] = s;
+  }
+}
+
+// StringStdSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StringStdSort::Test(const char **arr, size_t size, hedger::S_T range)
+{
+  std::sort(arr, arr + size, less_);
+  return 0;
+}
+
+// MultikeyQuickSort::Sort
+// Entry: pointer to array
+//        size of array
+//        depth: bytes every string in the array already shares
+void MultikeyQuickSort::Sort(const char **arr, size_t size, size_t depth)
+{
+  while (size > kStringInsertionMax) {
+    // Median of three characters for the pivot
+    unsigned int a = CharAt(arr[0], depth);
+    unsigned int b = CharAt(arr[size / 2], depth);
+    unsigned int c = CharAt(arr[size - 1], depth);
+    unsigned int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+    // Three-way partition: [0, lt) < pivot, [lt, gt) == pivot, [gt, size) >
+    size_t lt = 0, i = 0, gt = size;
+    while (i < gt) {
+      unsigned int key = CharAt(arr[i], depth);
+      if (key < pivot)
+        std::swap(arr[lt++], arr[i++]);
+      else if (key > pivot)
+        std::swap(arr[i], arr[--gt]);
+      else
+        ++i;
+    }
+
+    // Strings that ended at this depth are equal; the rest go one deeper
+    if (pivot)
+      Sort(arr + lt, gt - lt, depth + 1);
+    // Recurse into the smaller side and loop on the larger, so the stack
+    // stays logarithmic in the size
+    if (lt < size - gt) {
+      Sort(arr, lt, depth);
+      arr += gt;
+      size -= gt;
+    } else {
+      Sort(arr + gt, size - gt, depth);
+      size = lt;
+    }
+  }
+  InsertionSortFrom(arr, size, depth);
+}
+
+// MultikeyQuickSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int MultikeyQuickSort::Test(const char **arr, size_t size, hedger::S_T range)
+{
+  Sort(arr, size, 0);
+  return 0;
+}
+
+// StringRadixSort::Sort
+// Entry: pointer to array
+//        size of array
+//        depth: bytes every string in the array already shares
+//        scratch pointer array at least size long
+//        scratch byte cache at least size long
+void StringRadixSort::Sort(
+  const char **arr,
+  size_t size,
+  size_t depth,
+  const char **tmp_arr,
+  unsigned char *cache_arr)
+{
+  size_t count_arr[256];
+  for (;;) {
+    if (size < kStringRadixMin) {
+      MultikeyQuickSort::Sort(arr, size, depth);
+      return;
+    }
+    memset(count_arr, 0, sizeof(count_arr));
+    for (size_t i = 0; i < size; ++i) {
+      unsigned char key = (unsigned char) arr[i][depth];
+      cache_arr[i] = key;
+      ++count_arr[key];
+    }
+    // Every string has the same byte here: no need to move anything.
+    // Looping rather than recursing keeps long shared prefixes off the
+    // stack.
+    unsigned int key = cache_arr[0];
+    if (count_arr[key] == size) {
+      if (!key)
+        return;
+      ++depth;
+      continue;
+    }
+    break;
+  }
+
+  size_t pos_arr[256];
+  size_t pos = 0;
+  for (int key = 0; key < 256; ++key) {
+    pos_arr[key] = pos;
+    pos += count_arr[key];
+  }
+  for (size_t i = 0; i < size; ++i)
+    tmp_arr[pos_arr[cache_arr[i]]++] = arr[i];
+  memcpy(arr, tmp_arr, size * sizeof(const char *));
+
+  // Bucket 0 holds strings that ended here, which are all equal
+  size_t start = count_arr[0];
+  for (int key = 1; key < 256; ++key) {
+    if (count_arr[key] > 1)
+      Sort(arr + start, count_arr[key], depth + 1, tmp_arr, cache_arr);
+    start += count_arr[key];
+  }
+}
+
+// StringRadixSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int StringRadixSort::Test(const char **arr, size_t size, hedger::S_T range)
+{
+  Scratch scratch(arena_);
+  const char **tmp_arr =
+    (const char **) scratch.Alloc(size * sizeof(const char *));
+  unsigned char *cache_arr = (unsigned char *) scratch.Alloc(size);
+  if (!tmp_arr || !cache_arr) {
+    // TODO: LOG ERROR
+    return -1;
+  }
+  Sort(arr, size, 0, tmp_arr, cache_arr);
+  return 0;
+}
+
+// BurstNode
+// Trie node: one bucket or child per byte value.  Bucket 0 collects the
+// strings that end at this depth and never bursts.
+struct BurstNode {
+  BurstNode() { memset(child_arr, 0, sizeof(child_arr)); }
+  ~BurstNode() {
+    for (int i = 0; i < 256; ++i)
+      delete child_arr[i];
+  }
+  BurstNode *child_arr[256];
+  std::vector<const char *> bucket_arr[256];
+};
+
+// BurstInsert
+// Entry: trie root
+//        string
+static void BurstInsert(BurstNode *root, const char *s)
+{
+  BurstNode *node = root;
+  size_t depth = 0;
+  unsigned int key = CharAt(s, depth);
+  while (node->child_arr[key]) {
+    node = node->child_arr[key];
+    key = CharAt(s, ++depth);
+  }
+  std::vector<const char *>& bucket = node->bucket_arr[key];
+  bucket.push_back(s);
+  if (key && bucket.size() > kBurstMax) {
+    // Burst: the bucket's strings move one level down, by their next byte
+    BurstNode *child = new BurstNode();
+    for (auto t : bucket)
+      child->bucket_arr[CharAt(t, depth + 1)].push_back(t);
+    std::vector<const char *>().swap(bucket);
+    node->child_arr[key] = child;
+  }
+}
+
+// BurstTraverse
+// Write the trie's strings to arr in order
+// Entry: trie node
+//        depth of the node
+//        output position
+// Exit:  output position after the node's strings
+static const char **BurstTraverse(
+  BurstNode *node,
+  size_t depth,
+  const char **out)
+{
+  for (int key = 0; key < 256; ++key) {
+    if (node->child_arr[key]) {
+      out = BurstTraverse(node->child_arr[key], depth + 1, out);
+      continue;
+    }
+    std::vector<const char *>& bucket = node->bucket_arr[key];
+    if (bucket.empty())
+      continue;
+    size_t size = bucket.size();
+    memcpy(out, &bucket[0], size * sizeof(const char *));
+    if (key)
+      MultikeyQuickSort::Sort(out, size, depth + 1);
+    out += size;
+  }
+  return out;
+}
+
+// BurstSort::Test
+// Entry: pointer to array
+//        size of array
+// Exit:  0
+int BurstSort::Test(const char **arr, size_t size, hedger::S_T range)
+{
+  BurstNode root;
+  for (size_t i = 0; i < size; ++i)
+    BurstInsert(&root, arr[i]);
+  BurstTraverse(&root, 0, arr);
+  return 0;
+}
+
+} // namespace hedger
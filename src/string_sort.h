@@ -0,0 +1,102 @@
+// string_sort.h
+//
+// Engines for sorting NUL-terminated strings.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef STRING_SORT_H_
+#define STRING_SORT_H_
+
+#include <string.h>
+
+#include "algo.h"
+
+namespace hedger
+{
+// StringLess
+// Byte-wise (strcmp) order of NUL-terminated strings
+struct StringLess {
+  bool operator()(const char *a, const char *b) const {
+    return strcmp(a, b) < 0;
+  }
+};
+
+// The engines sort arrays of pointers; the strings themselves never move.
+typedef BasicAlgo<const char *, StringLess> StringAlgo;
+
+// StringStdSort
+// std::sort comparing with strcmp from the first byte every time; the
+// reference the string engines are measured against.
+class StringStdSort : public StringAlgo
+{
+ public:
+  int Test(const char **arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "std::sort (strcmp)"; }
+};
+
+// MultikeyQuickSort
+// Bentley-Sedgewick multikey quicksort: a three-way partition on the
+// character at the current depth, where only the equal part moves on to
+// the next character, so no byte of a common prefix is compared twice.
+class MultikeyQuickSort : public StringAlgo
+{
+ public:
+  int Test(const char **arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Multikey Quick Sort"; }
+  static void Sort(const char **arr, size_t size, size_t depth);
+};
+
+// StringRadixSort
+// MSD radix sort, one byte per level.  Each level first copies every
+// string's byte at the current depth into a contiguous cache, so the
+// counting and distribution passes read it without chasing the pointer
+// again; small buckets are finished by multikey quicksort.
+class StringRadixSort : public StringAlgo
+{
+ public:
+  int Test(const char **arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "String Radix Sort"; }
+  size_t GetScratchSize(size_t size) {
+    return Arena::Round(size * sizeof(const char *)) + Arena::Round(size);
+  }
+ private:
+  static void Sort(
+    const char **arr,
+    size_t size,
+    size_t depth,
+    const char **tmp_arr,
+    unsigned char *cache_arr
+  );
+};
+
+// BurstSort
+// Burstsort: strings are inserted into a byte trie whose leaves are
+// buckets; a bucket that outgrows the cache bursts into a new trie node.
+// An in-order walk then sorts each small bucket with multikey quicksort
+// from the depth its trie path already fixes.  The trie is built on the
+// heap.
+class BurstSort : public StringAlgo
+{
+ public:
+  int Test(const char **arr, size_t size, hedger::S_T range = 0);
+  const char *GetName() { return "Burst Sort"; }
+};
+}
+
+#endif // STRING_SORT_H_
@@ -0,0 +1,232 @@
+// trace.cc
+//
+// Timeline tracing: per-thread event buffers and Chrome trace-event JSON
+// export.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#include <stdio.h>
+#include <time.h>
+
+#include <cstddef>
+#include <atomic>
+#include <new>
+
+#include "trace.h"
+
+namespace hedger {
+
+const char *kTraceSort = "sort";
+const char *kTraceTask = "task";
+const char *kTraceSpawn = "spawn";
+const char *kTraceJoin = "join wait";
+const char *kTraceMerge = "merge";
+
+std::atomic<bool> trace_enabled(false);
+
+// Buffers of every thread that has recorded, newest first
+static std::atomic<TraceBuffer *> trace_head(nullptr);
+// Preallocated buffers; the next unclaimed one is claimed by fetch_add
+static TraceBuffer *trace_pool = nullptr;
+static size_t trace_pool_tot = 0;
+static std::atomic<size_t> trace_pool_next(0);
+static std::atomic<size_t> trace_lost_tot(0);
+// Bumped by TraceClear(), so threads let go of the buffers it reclaimed.
+// Starts at 1 so that a thread's zeroed generation is never current.
+static std::atomic<unsigned> trace_generation(1);
+static std::atomic<int> trace_tid(0);
+
+// The calling thread's buffer (nullptr in a current generation == the
+// pool was empty) and the generation it belongs to
+static thread_local TraceBuffer *local_buffer = nullptr;
+static thread_local unsigned local_generation = 0;
+
+// TraceNow
+// Exit: ns on the monotonic clock (vDSO, no syscall)
+static inline unsigned long long TraceNow()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// TraceEnable
+// Entry: true == record
+//        buffers to preallocate
+// Exit:  false == pool allocation failed, tracing left off
+bool TraceEnable(bool enable, size_t buffer_max)
+{
+  if (enable && buffer_max > trace_pool_tot) {
+    TraceRelease();
+    trace_pool = new (std::nothrow) TraceBuffer[buffer_max];
+    if (nullptr == trace_pool) {
+      // TODO: LOG ERROR
+      return false;
+    }
+    trace_pool_tot = buffer_max;
+  }
+  trace_enabled.store(enable, std::memory_order_relaxed);
+  return true;
+}
+
+// TraceClear
+void TraceClear()
+{
+  trace_generation.fetch_add(1, std::memory_order_relaxed);
+  trace_head.store(nullptr, std::memory_order_relaxed);
+  trace_pool_next.store(0, std::memory_order_relaxed);
+  trace_lost_tot.store(0, std::memory_order_relaxed);
+  trace_tid.store(0, std::memory_order_relaxed);
+}
+
+// TraceRelease
+void TraceRelease()
+{
+  trace_enabled.store(false, std::memory_order_relaxed);
+  TraceClear();
+  delete [] trace_pool;
+  trace_pool = nullptr;
+  trace_pool_tot = 0;
+}
+
+// TraceClaim
+// Take the next buffer from the pool and link it into the list.
+// Exit: buffer, or nullptr if the pool is empty
+static TraceBuffer *TraceClaim()
+{
+  size_t index = trace_pool_next.fetch_add(1, std::memory_order_relaxed);
+  if (index >= trace_pool_tot)
+    return nullptr;
+  TraceBuffer *buffer = &trace_pool[index];
+  buffer->tid = trace_tid.fetch_add(1, std::memory_order_relaxed);
+  buffer->event_tot = buffer->drop_tot = 0;
+  buffer->open_tot = buffer->drop_open_tot = 0;
+  // Lock-free push: only the link to the head is shared.
+  buffer->next = trace_head.load(std::memory_order_relaxed);
+  while (!trace_head.compare_exchange_weak(buffer->next, buffer,
+    std::memory_order_release, std::memory_order_relaxed))
+    ;
+  return buffer;
+}
+
+// TraceRecord
+// Entry: event name
+//        phase
+//        argument
+void TraceRecord(const char *name, TracePhase phase, long long arg)
+{
+  unsigned generation = trace_generation.load(std::memory_order_relaxed);
+  if (local_generation != generation) {
+    local_buffer = TraceClaim();
+    local_generation = generation;
+  }
+  TraceBuffer *buffer = local_buffer;
+  if (nullptr == buffer) {
+    trace_lost_tot.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // Spans nest, so once a begin is dropped every begin inside it is too,
+  // and an end closes a dropped begin while any is open.  Ends of recorded
+  // begins always have their room.
+  if (kTraceEnd == phase) {
+    if (buffer->drop_open_tot) {
+      --buffer->drop_open_tot;
+      ++buffer->drop_tot;
+      return;
+    }
+    if (buffer->open_tot)
+      --buffer->open_tot;
+  } else {
+    size_t need = kTraceBegin == phase ? 2 : 1;
+    if (buffer->drop_open_tot ||
+        buffer->event_tot + buffer->open_tot + need > kTraceEventMax) {
+      if (kTraceBegin == phase)
+        ++buffer->drop_open_tot;
+      ++buffer->drop_tot;
+      return;
+    }
+    if (kTraceBegin == phase)
+      ++buffer->open_tot;
+  }
+  TraceEvent& event = buffer->event_arr[buffer->event_tot++];
+  event.ts = TraceNow();
+  event.name = name;
+  event.arg = arg;
+  event.phase = (char) phase;
+}
+
+// TraceGetLostTot
+// Exit: events dropped for want of a buffer
+size_t TraceGetLostTot()
+{
+  return trace_lost_tot.load(std::memory_order_relaxed);
+}
+
+// TraceGetBuffers
+// Exit: newest buffer first
+TraceBuffer *TraceGetBuffers()
+{
+  return trace_head.load(std::memory_order_acquire);
+}
+
+// TraceWrite
+// Entry: path
+// Exit:  true == written
+bool TraceWrite(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (nullptr == file) {
+    // TODO: LOG ERROR
+    return false;
+  }
+  TraceBuffer *head = TraceGetBuffers();
+  unsigned long long origin = 0;
+  bool found = false;
+  for (TraceBuffer *buffer = head; buffer; buffer = buffer->next)
+    if (buffer->event_tot && (!found || buffer->event_arr[0].ts < origin)) {
+      origin = buffer->event_arr[0].ts;
+      found = true;
+    }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool first = true;
+  for (TraceBuffer *buffer = head; buffer; buffer = buffer->next) {
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+      "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", first ? "" : ",\n",
+      buffer->tid, buffer->tid);
+    first = false;
+    for (size_t i = 0; i < buffer->event_tot; ++i) {
+      const TraceEvent& event = buffer->event_arr[i];
+      fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"sortbench\",\"ph\":\"%c\","
+        "\"ts\":%.3f,\"pid\":1,\"tid\":%d", event.name, event.phase,
+        (event.ts - origin) / 1000.0, buffer->tid);
+      if (kTraceInstant == event.phase)
+        fprintf(file, ",\"s\":\"t\"");
+      if (kTraceEnd != event.phase)
+        fprintf(file, ",\"args\":{\"n\":%lld}", event.arg);
+      fprintf(file, "}");
+    }
+  }
+  fprintf(file, "\n]}\n");
+  bool written = !ferror(file);
+  if (fclose(file))
+    written = false;
+  return written;
+}
+} // namespace hedger
@@ -0,0 +1,141 @@
+// trace.h
+//
+// Timeline tracing: per-thread event buffers, written without locks by
+// the thread that owns them, exported as Chrome trace-event JSON for
+// chrome://tracing or Perfetto.
+//
+// This file is part of sortbench.
+//
+// Sortbench is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Sortbench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with sortbench.  If not, see <https://www.gnu.org/licenses/>.
+//
+// Copyright (C) 2018 Gregory Hedger
+//
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <cstddef>
+#include <atomic>
+
+namespace hedger
+{
+// Events one thread's buffer holds; later ones are counted and dropped
+const size_t kTraceEventMax = 16384;
+// Buffers TraceEnable() preallocates unless told otherwise, one per thread
+// that records between two TraceClear() calls
+const size_t kTraceBufferMax = 64;
+
+// Event names the parallel engines use
+extern const char *kTraceSort;          // one whole sort call
+extern const char *kTraceTask;          // a thread's share of the work
+extern const char *kTraceSpawn;         // creating worker threads
+extern const char *kTraceJoin;          // idle, waiting on worker threads
+extern const char *kTraceMerge;         // one traced merge
+
+// TracePhase
+// Chrome trace-event phases
+enum TracePhase {
+  kTraceBegin = 'B',
+  kTraceEnd = 'E',
+  kTraceInstant = 'i'
+};
+
+// TraceEvent
+struct TraceEvent {
+  unsigned long long ts;        // ns on the monotonic clock
+  const char *name;             // static string, no JSON escapes
+  long long arg;                // elements, start index, ...
+  char phase;                   // TracePhase
+};
+
+// TraceBuffer
+// One thread's events, in the order it recorded them.  Only the owning
+// thread writes it; readers must have joined that thread first.  Room is
+// kept for the end of every recorded begin, so a full buffer drops whole
+// spans and its begins and ends stay balanced.
+struct TraceBuffer {
+  int tid;                      // 0 == the first thread to record
+  size_t event_tot;
+  size_t drop_tot;
+  size_t open_tot;              // recorded begins awaiting their end
+  size_t drop_open_tot;         // dropped begins awaiting their end
+  TraceBuffer *next;
+  TraceEvent event_arr[kTraceEventMax];
+};
+
+// Set while tracing; a disabled trace point costs one relaxed load
+extern std::atomic<bool> trace_enabled;
+
+inline bool TraceEnabled()
+{
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+// TraceEnable
+// Start or stop recording.  Starting preallocates the buffer pool, so
+// recording never allocates; buffers already recorded are kept.  No
+// thread may be recording.
+// Entry: true == record
+//        buffers to preallocate
+// Exit:  false == pool allocation failed, tracing left off
+bool TraceEnable(bool enable, size_t buffer_max = kTraceBufferMax);
+
+// TraceClear
+// Return every buffer to the pool.  No thread may be recording.
+void TraceClear();
+
+// TraceRelease
+// Stop recording and free the pool.  No thread may be recording.
+void TraceRelease();
+
+// TraceRecord
+// Append an event to the calling thread's buffer, claiming the buffer from
+// the pool on the thread's first event.
+void TraceRecord(const char *name, TracePhase phase, long long arg);
+
+// TraceGetLostTot
+// Exit: events since TraceClear() from threads that found the pool empty
+size_t TraceGetLostTot();
+
+// TraceGetBuffers
+// Exit: newest buffer first, linked by next (nullptr == none)
+TraceBuffer *TraceGetBuffers();
+
+// TraceWrite
+// Write every buffer as Chrome trace-event JSON, timestamps in µs from the
+// first event, one track per recording thread.
+// Entry: path
+// Exit:  true == written
+bool TraceWrite(const char *path);
+
+inline void TraceBeginEvent(const char *name, long long arg = 0)
+{
+  if (TraceEnabled())
+    TraceRecord(name, kTraceBegin, arg);
+}
+
+inline void TraceEndEvent(const char *name)
+{
+  if (TraceEnabled())
+    TraceRecord(name, kTraceEnd, 0);
+}
+
+inline void TraceInstantEvent(const char *name, long long arg = 0)
+{
+  if (TraceEnabled())
+    TraceRecord(name, kTraceInstant, arg);
+}
+}
+
+#endif // TRACE_H_